@@ -0,0 +1,117 @@
+//
+//	block-devices.cpp - file with definitions of the block device collector reading /proc/diskstats
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <vector>	// vector
+#include <algorithm>	// sort
+#include <cstring>	// strncpy, strcmp
+#include <dirent.h>	// opendir, readdir, closedir
+// Internal headers
+#include "block-devices.h"
+
+// Devices whose I/O never reaches a disk of their own
+static bool isVirtualDevice(const std::string &name){
+	return !name.compare(0, 4, "loop") || !name.compare(0, 3, "ram") || !name.compare(0, 4, "zram");
+};
+
+// A device with entries in slaves/ (dm, md) only passes its I/O to the devices listed there
+static bool hasSlaves(const std::string &path){
+
+	DIR* directory = opendir(path.c_str());
+	if(!directory) return false;
+
+	bool found = false;
+	struct dirent* entry;
+	while(!found && (entry = readdir(directory)) != nullptr)
+		found = entry->d_name[0] != '.';
+	closedir(directory);
+	return found;
+};
+
+bool parseDiskstatsLine(std::string_view line, std::string_view &name, BlockDeviceCounters &counters){
+
+	nextToken(line);
+	nextToken(line);
+	name = nextToken(line);
+	if(name.empty()) return false;
+
+	uint64_t* fields[] = {
+		&counters.reads, &counters.readsMerged, &counters.sectorsRead, &counters.readTime,
+		&counters.writes, &counters.writesMerged, &counters.sectorsWritten, &counters.writeTime,
+		&counters.inFlight, &counters.busyTime, &counters.queueTime,
+		&counters.discards, &counters.discardsMerged, &counters.sectorsDiscarded, &counters.discardTime,
+		&counters.flushes, &counters.flushTime};
+
+	int count = 0;
+	for(uint64_t* field : fields) *field = 0;
+	for(uint64_t* field : fields){
+		if(!parseUnsigned(line, *field)) break;
+		count++;
+	}
+	return count >= 11;
+};
+
+BlockDevices::BlockDevices(){
+	this->devices = 0;
+};
+
+bool BlockDevices::open(const std::string &root){
+
+	this->devices = 0;
+	DIR* directory = opendir(root.c_str());
+	if(!directory) return false;
+
+	std::vector<std::string> found;
+	struct dirent* entry;
+	while((entry = readdir(directory)) != nullptr){
+		std::string name = entry->d_name;
+		if(name[0] == '.' || isVirtualDevice(name) || name.size() >= BLOCK_NAME_LENGTH) continue;
+		found.push_back(name);
+	}
+	closedir(directory);
+
+	// Sorted, so the same machine always puts the same device in the same slot
+	std::sort(found.begin(), found.end());
+	for(const std::string &name : found){
+		if(this->devices == BLOCK_MAX_DEVICES) break;
+		strncpy(this->names[this->devices], name.c_str(), BLOCK_NAME_LENGTH);
+		this->stacked[this->devices] = hasSlaves(root + "/" + name + "/slaves");
+		this->devices++;
+	}
+
+	return this->diskstatsFile.open("/proc/diskstats") && this->devices > 0;
+};
+
+bool BlockDevices::isOpen() const {
+	return this->diskstatsFile.isOpen() && this->devices > 0;
+};
+
+bool BlockDevices::read(BlockDeviceReading &reading){
+
+	reading.devices = this->devices;
+	for(int i = 0; i < this->devices; i++){
+		strncpy(reading.names[i], this->names[i], BLOCK_NAME_LENGTH);
+		reading.stacked[i] = this->stacked[i];
+		reading.found[i] = false;
+	}
+	if(!this->diskstatsFile.isOpen()) return false;
+
+	// Partitions are listed as well, only the devices found at open() are taken
+	std::string_view text = this->diskstatsFile.read(), name;
+	BlockDeviceCounters counters;
+	while(!text.empty()){
+		if(!parseDiskstatsLine(nextLine(text), name, counters)) continue;
+		for(int i = 0; i < this->devices; i++)
+			if(name == this->names[i]){
+				reading.counters[i] = counters;
+				reading.found[i] = true;
+				break;
+			}
+	}
+	return true;
+};
@@ -0,0 +1,75 @@
+//
+//	block-devices.h - header file with the block device collector reading /proc/diskstats
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef BLOCK_DEVICES_H
+#define BLOCK_DEVICES_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define BLOCK_ROOT "/sys/block"			// Every whole device (not partition) has a directory here
+#define BLOCK_MAX_DEVICES 16			// Devices reported separately, the rest is left out
+#define BLOCK_NAME_LENGTH 32			// Room for the device name with the terminating zero
+#define BLOCK_SECTOR_SIZE 512			// diskstats counts 512 byte sectors whatever the device uses
+
+// One line of /proc/diskstats, every counter is cumulative since boot except inFlight
+struct BlockDeviceCounters {
+	uint64_t reads;				// Reads completed
+	uint64_t readsMerged;			// Adjacent reads merged into one
+	uint64_t sectorsRead;			// Sectors read
+	uint64_t readTime;			// Time spent on reads in ms
+	uint64_t writes;			// Writes completed
+	uint64_t writesMerged;			// Adjacent writes merged into one
+	uint64_t sectorsWritten;		// Sectors written
+	uint64_t writeTime;			// Time spent on writes in ms
+	uint64_t inFlight;			// Requests issued to the device and not completed yet
+	uint64_t busyTime;			// Time with at least one request in flight in ms
+	uint64_t queueTime;			// Time of all requests in flight added up in ms
+	uint64_t discards;			// Discards completed, since Linux 4.18
+	uint64_t discardsMerged;
+	uint64_t sectorsDiscarded;
+	uint64_t discardTime;
+	uint64_t flushes;			// Flushes completed, since Linux 5.5
+	uint64_t flushTime;			// Time spent on flushes in ms
+};
+
+struct BlockDeviceReading {
+	int devices;						// Number of devices found
+	char names[BLOCK_MAX_DEVICES][BLOCK_NAME_LENGTH];	// e.g. sda, nvme0n1, md0
+	bool stacked[BLOCK_MAX_DEVICES];			// dm and md devices built on top of other devices
+	bool found[BLOCK_MAX_DEVICES];				// Device was listed in /proc/diskstats at the read
+	BlockDeviceCounters counters[BLOCK_MAX_DEVICES];
+};
+
+// Devices are listed once from /sys/block, so partitions are skipped and every device keeps its slot
+// for the whole run. All of them are read at once from /proc/diskstats, which stays open.
+// Loop, ram and zram devices are left out: their I/O is memory or lands on another device anyway.
+class BlockDevices {
+public:
+	BlockDevices();
+
+	bool open(const std::string& = BLOCK_ROOT);
+	bool isOpen() const;
+
+	bool read(BlockDeviceReading&);
+
+private:
+	int devices;
+	char names[BLOCK_MAX_DEVICES][BLOCK_NAME_LENGTH];
+	bool stacked[BLOCK_MAX_DEVICES];
+	ProcfsFile diskstatsFile;
+};
+
+// "major minor name" and up to 17 counters, older kernels have only the first 11 and the rest stays 0
+bool parseDiskstatsLine(std::string_view, std::string_view&, BlockDeviceCounters&);
+
+#endif
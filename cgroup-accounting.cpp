@@ -0,0 +1,129 @@
+//
+//	cgroup-accounting.cpp - file with definitions of the cgroup v2 collector of the CPU, memory and I/O used by one job
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <iterator>	// size
+#include <unistd.h>	// access, F_OK
+// Internal headers
+#include "cgroup-accounting.h"
+
+std::string findCgroupDirectory(int pid, const std::string &cgroupRoot){
+
+	// The cgroup v2 line is "0::/path", hybrid systems list the v1 controllers before it
+	ProcfsFile cgroupFile("/proc/" + std::to_string(pid) + "/cgroup");
+	std::string_view path;
+	if(!findLine(cgroupFile.read(), "0::", path)) return "";
+	path = nextToken(path);
+	while(!path.empty() && path.back() == '/') path.remove_suffix(1);
+
+	for(const std::string &root : {cgroupRoot, cgroupRoot + "/unified"}){
+		std::string directory = root + std::string(path);
+		if(!access((directory + "/cgroup.procs").c_str(), F_OK)) return directory;
+	}
+	return "";
+};
+
+bool parseIoStat(std::string_view text, CgroupReading &reading){
+
+	uint64_t totals[4] = {0, 0, 0, 0}, value;
+	bool found = false;
+	while(!text.empty()){
+		std::string_view line = nextLine(text);
+		nextToken(line);							// major:minor
+
+		// Fields are "name=value", the discard ones are left out
+		while(!line.empty()){
+			std::string_view field = nextToken(line);
+			size_t equals = field.find('=');
+			if(equals == std::string_view::npos) continue;
+			std::string_view name = field.substr(0, equals), number = field.substr(equals + 1);
+			int index = name == "rbytes" ? 0 : name == "wbytes" ? 1 : name == "rios" ? 2 : name == "wios" ? 3 : -1;
+			if(index < 0 || !parseUnsigned(number, value)) continue;
+			totals[index] += value;
+			found = true;
+		}
+	}
+
+	// A cgroup that has not done any I/O yet has an empty file, which is zero rather than missing
+	reading.bytesRead = totals[0];
+	reading.bytesWritten = totals[1];
+	reading.readOperations = totals[2];
+	reading.writeOperations = totals[3];
+	return found;
+};
+
+bool CgroupAccounting::open(const std::string &directory){
+
+	// Paths inside the hierarchy are used as they are, the rest are relative to its root
+	if(!directory.rfind(CGROUP_ROOT, 0)) return this->openFiles(directory);
+	return this->openFiles(std::string(CGROUP_ROOT) + (!directory.empty() && directory[0] == '/' ? "" : "/") + directory);
+};
+
+bool CgroupAccounting::setProcess(int pid, const std::string &cgroupRoot){
+	return this->openFiles(findCgroupDirectory(pid, cgroupRoot));
+};
+
+bool CgroupAccounting::openFiles(const std::string &directory){
+
+	this->path = directory;
+	while(this->path.size() > 1 && this->path.back() == '/') this->path.pop_back();
+	if(directory.empty()){
+		this->cpuStatFile.close();
+		this->memoryCurrentFile.close();
+		this->memoryStatFile.close();
+		this->ioStatFile.close();
+		return false;
+	}
+
+	bool opened = this->cpuStatFile.open(this->path + "/cpu.stat");
+	opened |= this->memoryCurrentFile.open(this->path + "/memory.current");
+	opened |= this->memoryStatFile.open(this->path + "/memory.stat");
+	opened |= this->ioStatFile.open(this->path + "/io.stat");
+	return opened;
+};
+
+bool CgroupAccounting::isOpen() const {
+	return this->cpuStatFile.isOpen() || this->memoryCurrentFile.isOpen() || this->memoryStatFile.isOpen()
+		|| this->ioStatFile.isOpen();
+};
+
+const std::string& CgroupAccounting::directory() const {
+	return this->path;
+};
+
+void CgroupAccounting::read(CgroupReading &reading){
+
+	reading = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX,
+		UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+
+	// nr_periods and the rest are there only when the cpu controller is enabled
+	const KeyValueField cpuFields[] = {
+		{"usage_usec", &reading.usageTime},
+		{"user_usec", &reading.userTime},
+		{"system_usec", &reading.systemTime},
+		{"nr_periods", &reading.periods},
+		{"nr_throttled", &reading.throttledPeriods},
+		{"throttled_usec", &reading.throttledTime}};
+	if(this->cpuStatFile.isOpen()) findKeyValues(this->cpuStatFile.read(), cpuFields, std::size(cpuFields));
+
+	std::string_view text;
+	if(this->memoryCurrentFile.isOpen()){
+		text = this->memoryCurrentFile.read();
+		if(!parseUnsigned(text, reading.memoryCurrent)) reading.memoryCurrent = UINT64_MAX;
+	}
+	const KeyValueField memoryFields[] = {
+		{"anon", &reading.memoryAnon},
+		{"file", &reading.memoryFile},
+		{"kernel", &reading.memoryKernel},
+		{"shmem", &reading.memoryShmem},
+		{"pgfault", &reading.pageFaults},
+		{"pgmajfault", &reading.majorFaults}};
+	if(this->memoryStatFile.isOpen()) findKeyValues(this->memoryStatFile.read(), memoryFields, std::size(memoryFields));
+
+	if(this->ioStatFile.isOpen()) parseIoStat(this->ioStatFile.read(), reading);
+};
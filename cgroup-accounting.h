@@ -0,0 +1,74 @@
+//
+//	cgroup-accounting.h - header file with the cgroup v2 collector of the CPU, memory and I/O used by one job
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef CGROUP_ACCOUNTING_H
+#define CGROUP_ACCOUNTING_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define CGROUP_ROOT "/sys/fs/cgroup"		// Mount point of the cgroup v2 hierarchy
+#define CGROUP_PATH_LENGTH 96			// Directory of the job relative to CGROUP_ROOT, e.g. /system.slice/slurmstepd.scope/job_42
+
+// Cumulative counters of one cgroup, missing ones are UINT64_MAX
+struct CgroupReading {
+	uint64_t usageTime;			// usage_usec of cpu.stat
+	uint64_t userTime;			// user_usec
+	uint64_t systemTime;			// system_usec
+	uint64_t periods;			// nr_periods, enforcement periods of cpu.max
+	uint64_t throttledPeriods;		// nr_throttled
+	uint64_t throttledTime;			// throttled_usec
+	uint64_t memoryCurrent;			// memory.current in bytes, missing in the root cgroup
+	uint64_t memoryAnon;			// anon of memory.stat in bytes
+	uint64_t memoryFile;			// file, the page cache charged to the cgroup
+	uint64_t memoryKernel;			// kernel, since Linux 5.18
+	uint64_t memoryShmem;			// shmem, tmpfs and shared anonymous memory
+	uint64_t pageFaults;			// pgfault
+	uint64_t majorFaults;			// pgmajfault
+	uint64_t bytesRead;			// rbytes of io.stat summed over the devices
+	uint64_t bytesWritten;			// wbytes
+	uint64_t readOperations;		// rios
+	uint64_t writeOperations;		// wios
+};
+
+// cpu.stat, memory.current, memory.stat and io.stat of one cgroup stay open and are read once per
+// sample, so following many cgroups costs four pread() calls each. A controller that is not enabled
+// in the parent's cgroup.subtree_control has no files and its counters stay missing.
+class CgroupAccounting {
+public:
+	// Directory of the cgroup as listed in /proc/[pid]/cgroup, or the full path under CGROUP_ROOT
+	bool open(const std::string&);
+	// cgroup v2 directory of a process, found through /proc/[pid]/cgroup
+	bool setProcess(int, const std::string& = CGROUP_ROOT);
+	bool isOpen() const;
+	// Directory the files were opened in
+	const std::string& directory() const;
+
+	void read(CgroupReading&);
+
+private:
+	std::string path;
+	ProcfsFile cpuStatFile;
+	ProcfsFile memoryCurrentFile;
+	ProcfsFile memoryStatFile;
+	ProcfsFile ioStatFile;
+
+	bool openFiles(const std::string&);
+};
+
+// cgroup v2 directory of a process without the trailing slash, empty if the process is gone or
+// the hierarchy is not mounted. Hybrid systems mount it under unified/
+std::string findCgroupDirectory(int, const std::string& = CGROUP_ROOT);
+// "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0" lines of io.stat summed over the devices
+bool parseIoStat(std::string_view, CgroupReading&);
+
+#endif
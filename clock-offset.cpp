@@ -0,0 +1,86 @@
+//
+//	clock-offset.cpp - file with definitions of the estimate of the clock offset and drift of a node to the root
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// min, max
+#include <cstdint>	// INT64_MAX
+// Internal headers
+#include "clock-offset.h"
+
+ClockOffset::ClockOffset(){
+	this->rounds = 0;
+	this->shortestRoundTrip = INT64_MAX;
+	this->lastRoundTrip = 0;
+	this->referenceTime = 0;
+	this->referenceOffset = 0;
+	this->slope = 0;
+};
+
+bool ClockOffset::isKnown() const {
+	return this->rounds > 0;
+};
+
+int64_t ClockOffset::offsetAt(int64_t time) const {
+	return this->referenceOffset + int64_t(this->slope * (time - this->referenceTime));
+};
+
+double ClockOffset::drift() const {
+	return this->slope * 1e6;
+};
+
+int64_t ClockOffset::uncertainty() const {
+	return this->lastRoundTrip / 2;
+};
+
+bool ClockOffset::update(const ClockProbe* probes, int count){
+
+	const ClockProbe* fastest = nullptr;
+	int64_t roundTrip = INT64_MAX;
+	for(int i = 0; i < count; i++){
+		int64_t candidate = std::max<int64_t>((probes[i].returned - probes[i].sent) - (probes[i].answered - probes[i].received), 0);
+		if(candidate < roundTrip){
+			roundTrip = candidate;
+			fastest = &probes[i];
+		}
+	}
+	if(!fastest) return false;
+
+	// A round slowed down as a whole, e.g. by the gather in flight, is dropped. The bar is raised
+	// by every drop, so a network that became slower for good is accepted after a few rounds.
+	if(this->rounds && roundTrip > 2 * this->shortestRoundTrip){
+		this->shortestRoundTrip += this->shortestRoundTrip / 4 + 1;
+		return false;
+	}
+	this->shortestRoundTrip = std::min(this->shortestRoundTrip, roundTrip);
+	this->lastRoundTrip = roundTrip;
+
+	int slot = this->rounds % CLOCK_HISTORY;
+	this->times[slot] = fastest->received + (fastest->answered - fastest->received) / 2;
+	this->offsets[slot] = ((fastest->received - fastest->sent) + (fastest->answered - fastest->returned)) / 2;
+	this->rounds++;
+
+	// Least squares line through the kept rounds, in differences to the newest one so that
+	// nanosecond timestamps do not lose their precision in a double
+	int kept = std::min(this->rounds, CLOCK_HISTORY);
+	int64_t newestTime = this->times[slot], newestOffset = this->offsets[slot];
+	double meanTime = 0, meanOffset = 0;
+	for(int i = 0; i < kept; i++){
+		meanTime += double(this->times[i] - newestTime) / kept;
+		meanOffset += double(this->offsets[i] - newestOffset) / kept;
+	}
+	double covariance = 0, variance = 0;
+	for(int i = 0; i < kept; i++){
+		double time = double(this->times[i] - newestTime) - meanTime;
+		covariance += time * (double(this->offsets[i] - newestOffset) - meanOffset);
+		variance += time * time;
+	}
+	this->slope = variance > 0 ? covariance / variance : 0;
+	this->referenceTime = newestTime;
+	this->referenceOffset = newestOffset + int64_t(meanOffset - this->slope * meanTime);
+	return true;
+};
@@ -0,0 +1,59 @@
+//
+//	clock-offset.h - header file with the estimate of the clock offset and drift of a node to the root
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef CLOCK_OFFSET_H
+#define CLOCK_OFFSET_H
+
+// External libraries
+#include <cstdint>		// int64_t
+
+#define CLOCK_PROBES 8				// Ping-pong exchanges of one round, only the fastest one is kept
+#define CLOCK_HISTORY 16			// Rounds the drift is fitted over
+#define CLOCK_SYNC_PERIOD 10000			// Time between two rounds in ms
+
+// One NTP-style exchange: the root sends at t1, the node receives at t2 and answers at t3, the
+// root receives at t4. Every time is CLOCK_REALTIME in ns of the clock that took it.
+struct ClockProbe {
+	int64_t sent;				// t1, root
+	int64_t received;			// t2, node
+	int64_t answered;			// t3, node
+	int64_t returned;			// t4, root
+};
+
+// The offset of the node clock to the root one, (t2 - t1 + t3 - t4) / 2, is exact when both ways
+// took the same time and off by at most half the round trip otherwise. A round keeps the probe with
+// the shortest round trip, the one least delayed by queues and scheduling, and drops the whole round
+// when it is over twice the shortest one seen so far. The drift is the least squares slope of the
+// offsets of the last CLOCK_HISTORY rounds.
+class ClockOffset {
+public:
+	ClockOffset();
+
+	// Probes of one round, false if the round was dropped
+	bool update(const ClockProbe*, int);
+	bool isKnown() const;
+
+	// Node clock minus root clock in ns at the given CLOCK_REALTIME of the node
+	int64_t offsetAt(int64_t) const;
+	// Drift of the node clock in ppm, 0 until there are two rounds
+	double drift() const;
+	// Half the round trip of the last round kept, the bound on the error of its offset in ns
+	int64_t uncertainty() const;
+
+private:
+	int64_t times[CLOCK_HISTORY];		// Node clock halfway through the kept probe of every round
+	int64_t offsets[CLOCK_HISTORY];		// ns
+	int rounds;				// Rounds kept, the newest is at (rounds - 1) % CLOCK_HISTORY
+	int64_t shortestRoundTrip;		// ns
+	int64_t lastRoundTrip;			// ns
+	int64_t referenceTime;			// Node clock the fit is centred on
+	int64_t referenceOffset;		// Fitted offset at referenceTime in ns
+	double slope;				// ns per ns
+};
+
+#endif
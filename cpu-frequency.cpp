@@ -0,0 +1,213 @@
+//
+//	cpu-frequency.cpp - file with definitions of the per-CPU frequency, idle state and thermal throttling collector
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <cstring>	// memset, strncpy
+#include <fcntl.h>	// open, O_RDONLY, O_CLOEXEC
+#include <unistd.h>	// pread, close
+// Internal headers
+#include "cpu-frequency.h"
+
+bool readMsr(int descriptor, uint32_t address, uint64_t &value){
+
+	// The offset into the msr device is the address of the register
+	return descriptor >= 0 && pread(descriptor, &value, sizeof(value), address) == sizeof(value);
+};
+
+CpuFrequency::CpuFrequency(){
+	this->cpuCount = 0;
+	this->idleStateCount = 0;
+	this->nominalFrequency = -1;
+	memset(this->idleStateNames, 0, sizeof(this->idleStateNames));
+};
+
+CpuFrequency::~CpuFrequency(){
+	this->closeMsr();
+};
+
+void CpuFrequency::closeMsr(){
+
+	for(CpuFiles &files : this->cpuFiles){
+		if(files.msrDescriptor >= 0) close(files.msrDescriptor);
+		files.msrDescriptor = -1;
+	}
+};
+
+int CpuFrequency::addValue(const std::string &path){
+
+	// cpufreq, cpuidle and thermal_throttle are about a dozen files per CPU, more than a process may
+	// keep open on a large node. Past the limit a file is only checked here and opened on every read.
+	SysfsValue value;
+	value.path = path;
+	if(this->values.size() < FREQUENCY_MAX_DESCRIPTORS){
+		if(!value.file.open(path)) return -1;
+	}
+	else{
+		if(!this->scratchFile.open(path)) return -1;
+		this->scratchFile.close();
+	}
+
+	this->values.push_back(std::move(value));
+	return this->values.size() - 1;
+};
+
+bool CpuFrequency::readValue(int index, uint64_t &value){
+
+	if(index < 0) return false;
+	SysfsValue &sysfsValue = this->values[index];
+	ProcfsFile* file = &sysfsValue.file;
+	if(!file->isOpen()){
+		if(!this->scratchFile.open(sysfsValue.path)) return false;
+		file = &this->scratchFile;
+	}
+
+	std::string_view text = file->read();
+	return parseUnsigned(text, value);
+};
+
+bool CpuFrequency::open(const CpuTopology &topology, const std::string &cpuRoot, const std::string &msrRoot){
+
+	this->closeMsr();
+	this->values.clear();
+	this->cpuFiles.clear();
+	this->cores.clear();
+	this->sockets.clear();
+	this->cpuCount = topology.cpus();
+	this->idleStateCount = 0;
+	this->nominalFrequency = -1;
+	memset(this->idleStateNames, 0, sizeof(this->idleStateNames));
+	if(!this->cpuCount) return false;
+
+	std::vector<bool> coreSeen(topology.cores()), socketSeen(topology.sockets());
+	bool found = false;
+	for(int slot = 0; slot < this->cpuCount; slot++){
+		const CpuPlacement &placement = topology.placement(slot);
+		std::string cpu = std::to_string(placement.cpu);
+		std::string directory = cpuRoot + "/cpu" + cpu + "/";
+		CpuFiles files;
+		this->cores.push_back(placement.core);
+		this->sockets.push_back(placement.socket);
+
+		files.frequency = this->addValue(directory + "cpufreq/scaling_cur_freq");
+		found |= files.frequency >= 0;
+
+		// States are numbered from 0 without gaps, every CPU has the same ones
+		int states = 0;
+		for(int state = 0; state < IDLE_MAX_STATES; state++){
+			std::string stateDirectory = directory + "cpuidle/state" + std::to_string(state) + "/";
+			files.idleTime[state] = this->addValue(stateDirectory + "time");
+			files.idleUsage[state] = files.idleTime[state] >= 0 ? this->addValue(stateDirectory + "usage") : -1;
+			if(files.idleTime[state] < 0) continue;
+			states = state + 1;
+
+			if(slot) continue;
+			ProcfsFile nameFile(stateDirectory + "name");
+			std::string_view name = nameFile.read();
+			name = nextToken(name);
+			strncpy(this->idleStateNames[state], std::string(name).c_str(), IDLE_NAME_LENGTH - 1);
+		}
+		if(states > this->idleStateCount) this->idleStateCount = states;
+		found |= states > 0;
+
+		// Siblings would report their core and every core its package again
+		std::string throttle = directory + "thermal_throttle/";
+		files.coreThrottle[0] = files.coreThrottle[1] = files.packageThrottle[0] = files.packageThrottle[1] = -1;
+		if(!coreSeen[placement.core]){
+			coreSeen[placement.core] = true;
+			files.coreThrottle[0] = this->addValue(throttle + "core_throttle_count");
+			// The total times exist since Linux 5.18
+			files.coreThrottle[1] = this->addValue(throttle + "core_throttle_total_time_ms");
+		}
+		if(!socketSeen[placement.socket]){
+			socketSeen[placement.socket] = true;
+			files.packageThrottle[0] = this->addValue(throttle + "package_throttle_count");
+			files.packageThrottle[1] = this->addValue(throttle + "package_throttle_total_time_ms");
+		}
+		found |= files.coreThrottle[0] >= 0;
+
+		// Opening the device needs CAP_SYS_RAWIO, reading needs a CPU that has the register
+		uint64_t mperf;
+		files.msrDescriptor = ::open((msrRoot + "/" + cpu + "/msr").c_str(), O_RDONLY | O_CLOEXEC);
+		if(files.msrDescriptor >= 0 && !readMsr(files.msrDescriptor, MSR_MPERF, mperf)){
+			close(files.msrDescriptor);
+			files.msrDescriptor = -1;
+		}
+		found |= files.msrDescriptor >= 0;
+		this->cpuFiles.push_back(files);
+	}
+	this->scratchFile.close();
+
+	// intel_pstate gives the nominal frequency in kHz, otherwise the ratio comes from the MSR
+	uint64_t value;
+	std::string_view text;
+	ProcfsFile baseFrequencyFile(cpuRoot + "/cpu" + std::to_string(topology.placement(0).cpu) + "/cpufreq/base_frequency");
+	text = baseFrequencyFile.read();
+	if(parseUnsigned(text, value)) this->nominalFrequency = value / 1000.0f;
+	else if(readMsr(this->cpuFiles[0].msrDescriptor, MSR_PLATFORM_INFO, value) && (value >> 8 & 0xFF))
+		this->nominalFrequency = (value >> 8 & 0xFF) * 100.0f;
+
+	return found;
+};
+
+bool CpuFrequency::isOpen() const {
+	return !this->values.empty() || this->hasMsr();
+};
+
+bool CpuFrequency::hasMsr() const {
+
+	for(const CpuFiles &files : this->cpuFiles)
+		if(files.msrDescriptor >= 0) return true;
+	return false;
+};
+
+float CpuFrequency::baseFrequency() const {
+	return this->nominalFrequency;
+};
+
+int CpuFrequency::idleStates() const {
+	return this->idleStateCount;
+};
+
+const char* CpuFrequency::idleStateName(int state) const {
+	return this->idleStateNames[state];
+};
+
+void CpuFrequency::read(CpuFrequencyReading &reading){
+
+	reading.cpus = this->cpuCount;
+	for(int i = 0; i < TOPOLOGY_MAX_CPUS; i++)
+		reading.coreThrottleCount[i] = reading.coreThrottleTime[i] = UINT64_MAX;
+	for(int i = 0; i < TOPOLOGY_MAX_SOCKETS; i++)
+		reading.packageThrottleCount[i] = reading.packageThrottleTime[i] = UINT64_MAX;
+
+	uint64_t value;
+	for(int slot = 0; slot < this->cpuCount; slot++){
+		const CpuFiles &files = this->cpuFiles[slot];
+
+		reading.frequency[slot] = this->readValue(files.frequency, value) ? value / 1000.0f : -1;	// MHz
+
+		for(int state = 0; state < IDLE_MAX_STATES; state++){
+			if(!this->readValue(files.idleTime[state], reading.idleTime[slot][state])) reading.idleTime[slot][state] = UINT64_MAX;
+			if(!this->readValue(files.idleUsage[state], reading.idleUsage[slot][state])) reading.idleUsage[slot][state] = UINT64_MAX;
+		}
+
+		if(!readMsr(files.msrDescriptor, MSR_APERF, reading.aperf[slot])) reading.aperf[slot] = UINT64_MAX;
+		if(!readMsr(files.msrDescriptor, MSR_MPERF, reading.mperf[slot])) reading.mperf[slot] = UINT64_MAX;
+
+		int core = this->cores[slot], socket = this->sockets[slot];
+		if(files.coreThrottle[0] >= 0){
+			this->readValue(files.coreThrottle[0], reading.coreThrottleCount[core]);
+			this->readValue(files.coreThrottle[1], reading.coreThrottleTime[core]);
+		}
+		if(files.packageThrottle[0] >= 0 && socket < TOPOLOGY_MAX_SOCKETS){
+			this->readValue(files.packageThrottle[0], reading.packageThrottleCount[socket]);
+			this->readValue(files.packageThrottle[1], reading.packageThrottleTime[socket]);
+		}
+	}
+	this->scratchFile.close();
+};
@@ -0,0 +1,98 @@
+//
+//	cpu-frequency.h - header file with the per-CPU frequency, idle state and thermal throttling collector
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef CPU_FREQUENCY_H
+#define CPU_FREQUENCY_H
+
+// External libraries
+#include <string>		// string
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+#include "cpu-topology.h"
+
+#define MSR_ROOT "/dev/cpu"			// N/msr of every CPU, needs the msr module and CAP_SYS_RAWIO
+#define MSR_MPERF 0xE7				// Cycles at the nominal frequency while not halted
+#define MSR_APERF 0xE8				// Cycles at the actual frequency while not halted
+#define MSR_PLATFORM_INFO 0xCE			// Bits 15:8 are the nominal ratio to the 100 MHz bus on Intel
+#define IDLE_MAX_STATES 8			// cpuidle states reported, POLL included
+#define IDLE_NAME_LENGTH 16			// Name of an idle state, e.g. C1E, C6
+#define FREQUENCY_MAX_DESCRIPTORS 256		// sysfs files kept open, the others are opened on every read
+
+// Raw values of every CPU, slots are the ones of CpuTopology. Missing counters are UINT64_MAX.
+struct CpuFrequencyReading {
+	int cpus;							// Number of CPUs in the slots
+	float frequency[TOPOLOGY_MAX_CPUS];				// scaling_cur_freq in MHz, -1 without cpufreq
+	uint64_t aperf[TOPOLOGY_MAX_CPUS];				// IA32_APERF
+	uint64_t mperf[TOPOLOGY_MAX_CPUS];				// IA32_MPERF
+	uint64_t idleTime[TOPOLOGY_MAX_CPUS][IDLE_MAX_STATES];	// Time spent in every idle state since boot in us
+	uint64_t idleUsage[TOPOLOGY_MAX_CPUS][IDLE_MAX_STATES];	// Entries to every idle state since boot
+	uint64_t coreThrottleCount[TOPOLOGY_MAX_CPUS];		// Throttling events of every physical core
+	uint64_t coreThrottleTime[TOPOLOGY_MAX_CPUS];		// Time throttled of every physical core in ms
+	uint64_t packageThrottleCount[TOPOLOGY_MAX_SOCKETS];	// Throttling events of every socket
+	uint64_t packageThrottleTime[TOPOLOGY_MAX_SOCKETS];	// Time throttled of every socket in ms
+};
+
+// cpufreq, cpuidle and thermal_throttle files of every CPU of the topology, found once at open().
+// The throttle counters of a core are read from its first CPU only and the ones of a package from
+// its first CPU only, SMT siblings and cores of one socket share them. The MSRs are read
+// when /dev/cpu/N/msr can be opened, which usually means root.
+class CpuFrequency {
+public:
+	CpuFrequency();
+	CpuFrequency(const CpuFrequency&) = delete;
+	CpuFrequency& operator=(const CpuFrequency&) = delete;
+	~CpuFrequency();
+
+	bool open(const CpuTopology&, const std::string& = TOPOLOGY_CPU_ROOT, const std::string& = MSR_ROOT);
+	bool isOpen() const;
+	bool hasMsr() const;
+
+	// Nominal frequency in MHz from cpufreq/base_frequency or MSR_PLATFORM_INFO, -1 if not known
+	float baseFrequency() const;
+	int idleStates() const;
+	const char* idleStateName(int) const;
+
+	void read(CpuFrequencyReading&);
+
+private:
+	// sysfs file that is either kept open or opened again on every read
+	struct SysfsValue {
+		std::string path;
+		ProcfsFile file;
+	};
+
+	struct CpuFiles {
+		int frequency;				// Index of scaling_cur_freq in values, -1 if missing
+		int idleTime[IDLE_MAX_STATES];
+		int idleUsage[IDLE_MAX_STATES];
+		int coreThrottle[2];			// core_throttle_count and core_throttle_total_time_ms
+		int packageThrottle[2];			// package_throttle_count and package_throttle_total_time_ms
+		int msrDescriptor;
+	};
+
+	std::vector<SysfsValue> values;
+	std::vector<CpuFiles> cpuFiles;
+	ProcfsFile scratchFile;
+	int cpuCount;
+	int idleStateCount;
+	char idleStateNames[IDLE_MAX_STATES][IDLE_NAME_LENGTH];
+	float nominalFrequency;
+	std::vector<int> cores;			// Core of every slot
+	std::vector<int> sockets;		// Socket of every slot
+
+	int addValue(const std::string&);
+	bool readValue(int, uint64_t&);
+	void closeMsr();
+};
+
+// Unsigned 64 bit register of a CPU from its /dev/cpu/N/msr descriptor
+bool readMsr(int, uint32_t, uint64_t&);
+
+#endif
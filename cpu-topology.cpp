@@ -0,0 +1,149 @@
+//
+//	cpu-topology.cpp - file with definitions of the per-CPU collector reading /proc/stat and the CPU topology in sysfs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// sort, unique, lower_bound
+#include <utility>	// pair
+#include <dirent.h>	// opendir, readdir, closedir
+// Internal headers
+#include "cpu-topology.h"
+
+// Single number from a sysfs file, e.g. topology/core_id, -1 if it cannot be read
+static int64_t readTopologyValue(const std::string &path){
+
+	ProcfsFile file(path);
+	std::string_view text = file.read();
+	int64_t value;
+	return parseSigned(text, value) ? value : -1;
+};
+
+// Position of an id among the sorted ids, so the ids become numbers from 0 without gaps
+template<typename T>
+static int denseIndex(const std::vector<T> &ids, const T &id){
+	return std::lower_bound(ids.begin(), ids.end(), id) - ids.begin();
+};
+
+template<typename T>
+static void sortUnique(std::vector<T> &ids){
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+};
+
+CpuTopology::CpuTopology(){
+	this->cpuCount = 0;
+	this->coreCount = 0;
+	this->socketCount = 0;
+	this->nodeCount = 0;
+};
+
+bool CpuTopology::open(const std::string &cpuRoot, const std::string &nodeRoot){
+
+	this->cpuCount = this->coreCount = this->socketCount = this->nodeCount = 0;
+	this->slots.clear();
+
+	ProcfsFile onlineFile(cpuRoot + "/online");
+	std::vector<int> cpus = parseCpuList(onlineFile.read());
+	if(cpus.empty()) return false;
+	if(cpus.size() > TOPOLOGY_MAX_CPUS) cpus.resize(TOPOLOGY_MAX_CPUS);
+
+	// Without CONFIG_NUMA there is no node directory and every CPU stays on node 0
+	std::vector<int> cpuNodes(cpus.back() + 1, 0);
+	DIR* directory = opendir(nodeRoot.c_str());
+	if(directory){
+		struct dirent* entry;
+		while((entry = readdir(directory)) != nullptr){
+			std::string_view name = entry->d_name;
+			if(name.substr(0, 4) != "node") continue;
+			name.remove_prefix(4);
+			uint64_t node;
+			if(!parseUnsigned(name, node) || !name.empty()) continue;
+
+			ProcfsFile cpulistFile(nodeRoot + "/" + entry->d_name + "/cpulist");
+			for(int cpu : parseCpuList(cpulistFile.read()))
+				if(cpu < (int)cpuNodes.size()) cpuNodes[cpu] = node;
+		}
+		closedir(directory);
+	}
+
+	// core_id is unique only within a socket, so a physical core is the pair of both
+	std::vector<std::pair<int64_t, int64_t>> cpuCores;
+	std::vector<int64_t> sockets;
+	std::vector<int> nodes;
+	for(int cpu : cpus){
+		std::string topology = cpuRoot + "/cpu" + std::to_string(cpu) + "/topology/";
+		int64_t socket = readTopologyValue(topology + "physical_package_id");
+		int64_t core = readTopologyValue(topology + "core_id");
+		// Without topology every CPU is a core of its own
+		if(core < 0) core = cpu;
+		cpuCores.push_back({socket, core});
+		sockets.push_back(socket);
+		nodes.push_back(cpuNodes[cpu]);
+	}
+	std::vector<std::pair<int64_t, int64_t>> cores = cpuCores;
+	sortUnique(cores);
+	sortUnique(sockets);
+	sortUnique(nodes);
+
+	this->slots.assign(cpus.back() + 1, -1);
+	for(size_t i = 0; i < cpus.size(); i++){
+		CpuPlacement &placement = this->placements[i];
+		placement.cpu = cpus[i];
+		placement.core = denseIndex(cores, cpuCores[i]);
+		placement.socket = denseIndex(sockets, cpuCores[i].first);
+		placement.node = denseIndex(nodes, cpuNodes[cpus[i]]);
+		this->slots[cpus[i]] = i;
+	}
+
+	this->cpuCount = cpus.size();
+	this->coreCount = cores.size();
+	this->socketCount = sockets.size();
+	this->nodeCount = nodes.size();
+	return true;
+};
+
+bool CpuTopology::isOpen() const {
+	return this->cpuCount > 0;
+};
+
+int CpuTopology::cpus() const {
+	return this->cpuCount;
+};
+
+int CpuTopology::cores() const {
+	return this->coreCount;
+};
+
+int CpuTopology::sockets() const {
+	return this->socketCount;
+};
+
+int CpuTopology::nodes() const {
+	return this->nodeCount;
+};
+
+const CpuPlacement& CpuTopology::placement(int slot) const {
+	return this->placements[slot];
+};
+
+void CpuTopology::read(std::string_view text, CpuTimesReading &reading) const {
+
+	reading.cpus = this->cpuCount;
+	for(int i = 0; i < this->cpuCount; i++)
+		for(uint64_t &time : reading.times[i]) time = UINT64_MAX;
+
+	// "cpu " is the sum over all CPUs, the cpuN lines follow it. A CPU that went offline has no line.
+	while(!text.empty()){
+		std::string_view line = nextLine(text);
+		if(line.size() < 4 || line.substr(0, 3) != "cpu" || line[3] < '0' || line[3] > '9') continue;
+		line.remove_prefix(3);
+
+		uint64_t cpu;
+		if(!parseUnsigned(line, cpu) || cpu >= this->slots.size() || this->slots[cpu] < 0) continue;
+		parseUnsignedList(line, reading.times[this->slots[cpu]], TOPOLOGY_CPU_TIMES);
+	}
+};
@@ -0,0 +1,67 @@
+//
+//	cpu-topology.h - header file with the per-CPU collector reading /proc/stat and the CPU topology in sysfs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define TOPOLOGY_CPU_ROOT "/sys/devices/system/cpu"	// cpuN/topology of every logical CPU
+#define TOPOLOGY_NODE_ROOT "/sys/devices/system/node"	// nodeN/cpulist of every NUMA node
+#define TOPOLOGY_MAX_CPUS 256			// Logical CPUs reported separately, e.g. 128 cores with SMT
+#define TOPOLOGY_MAX_SOCKETS 8			// Sockets reported separately
+#define TOPOLOGY_MAX_NODES 16			// NUMA nodes reported separately
+#define TOPOLOGY_CPU_TIMES 9			// user, nice, system, idle, iowait, irq, softirq, steal, guest
+
+// Where a logical CPU sits. Cores, sockets and nodes are numbered from 0 in the order of their ids,
+// so they can index the per-socket and per-node arrays even when the ids have gaps.
+struct CpuPlacement {
+	int cpu;				// Logical CPU number, cpuN in /proc/stat
+	int core;				// Physical core, SMT siblings share it
+	int socket;				// physical_package_id
+	int node;				// NUMA node, 0 when the kernel has no NUMA support
+};
+
+struct CpuTimesReading {
+	int cpus;						// Number of CPUs found at open()
+	uint64_t times[TOPOLOGY_MAX_CPUS][TOPOLOGY_CPU_TIMES];	// Columns of every cpuN line in USER_HZ
+};
+
+// The online CPUs and their topology are read once, every CPU keeps its slot for the whole run.
+// The times come from the /proc/stat text the caller has already read for the "cpu " line.
+class CpuTopology {
+public:
+	CpuTopology();
+
+	bool open(const std::string& = TOPOLOGY_CPU_ROOT, const std::string& = TOPOLOGY_NODE_ROOT);
+	bool isOpen() const;
+
+	int cpus() const;
+	int cores() const;
+	int sockets() const;
+	int nodes() const;
+	const CpuPlacement& placement(int) const;
+
+	void read(std::string_view, CpuTimesReading&) const;
+
+private:
+	int cpuCount;
+	int coreCount;
+	int socketCount;
+	int nodeCount;
+	CpuPlacement placements[TOPOLOGY_MAX_CPUS];
+	std::vector<int> slots;			// Slot of every CPU number, -1 for CPUs left out
+};
+
+#endif
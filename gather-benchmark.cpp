@@ -0,0 +1,123 @@
+//
+// 	gather-benchmark.cpp - time rank 0 spends on every tick of sampling, for both ways of gathering the samples
+//
+// 	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// Compares the old loop of blocking MPI_Recv calls with the MPI_Igather pipeline of measure-performance.
+// Both run on the same scheduler as measure-performance: every node wakes up at the common deadlines,
+// takes a full sample and ships it. Rank 0 reports the time from the deadline until the record it is
+// going to save is in its hands, which is the time a tick keeps it from being ready for the next one:
+// the sample and the whole gather with the old loop, the sample and the wait for the gather started
+// on the previous tick with the pipeline.
+//
+// mpicxx -std=c++2a gather-benchmark.cpp metrics.cpp node-synchronization.cpp procfs-reader.cpp perf-counters.cpp rapl-power.cpp process-tree.cpp target-launcher.cpp block-devices.cpp network-interfaces.cpp cpu-topology.cpp pressure-stall.cpp interrupt-counters.cpp cpu-frequency.cpp cgroup-accounting.cpp infiniband-ports.cpp gpu-devices.cpp power-meter.cpp sampling-scheduler.cpp clock-offset.cpp -o gather-benchmark -ldl
+// mpirun --oversubscribe -np 64 gather-benchmark --ticks 100 --period 100
+//
+
+// External libraries
+#include <iostream>		// cout
+#include <vector>		// vector
+#include <algorithm>		// sort
+#include <cstring>		// strcmp
+#include <mpi.h>		// MPI_Igather, MPI_Send, MPI_Recv, ...
+// Internal headers
+#include "metrics.h"
+#include "node-synchronization.h"
+#include "procfs-reader.h"
+
+#define BENCHMARK_TICKS 100			// Default number of ticks per method
+#define BENCHMARK_PERIOD 100			// Default time between two ticks in ms, the shortest --period
+
+static void printTickTime(const char* method, int clusterSize, std::vector<double> &tickTime){
+
+	std::sort(tickTime.begin(), tickTime.end());
+	double sum = 0;
+	for(double value : tickTime) sum += value;
+
+	std::cout << method << "\tranks " << clusterSize
+		<< "\tmean " << sum / tickTime.size() / 1e3 << " us"
+		<< "\tmedian " << tickTime[tickTime.size() / 2] / 1e3 << " us"
+		<< "\tp99 " << tickTime[tickTime.size() * 99 / 100] / 1e3 << " us"
+		<< "\tmax " << tickTime.back() / 1e3 << " us\n";
+};
+
+int main(int argc, char **argv){
+
+	int rank, clusterSize;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &clusterSize);
+
+	int ticks = BENCHMARK_TICKS, period = BENCHMARK_PERIOD;
+	for(int i = 1; i < argc - 1; i++){
+		if(!strcmp(argv[i], "--ticks")) ticks = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--period")) period = std::stoi(argv[++i]);
+	}
+	if(ticks < 1) ticks = 1;
+	if(period < 1) period = 1;
+
+	int clusterCpus = countClusterCpus();
+	MPI_Datatype allMetricsType = createMpiAllMetricsType(METRIC_ALL_GROUPS, clusterCpus);
+	int recordSize;
+	MPI_Type_size(allMetricsType, &recordSize);
+
+	AllMetrics sendSlots[2];
+	std::vector<AllMetrics> receiveSlots[2];
+	for(std::vector<AllMetrics> &slot : receiveSlots) slot.resize(rank ? 0 : clusterSize);
+	std::vector<double> sendReceiveTime, pipelineTime;
+	// Never opened, the benchmark has no clock probes
+	ClockExchange clockExchange;
+	int periods[METRIC_GROUPS];
+	for(int &collectorPeriod : periods) collectorPeriod = period;
+
+	// Blocking point-to-point loop, rank 0 receives from every node in turn right after its own sample
+	{
+		int64_t epoch = waitForCommonEpoch();
+		takeSnapshot();
+		SamplingScheduler scheduler;
+		scheduler.open(periods, METRIC_GROUPS, epoch);
+		for(int i = 0; i < ticks; i++){
+			uint32_t tick = sleepWhileGathering(scheduler, nullptr, 0, clockExchange);
+			getAllMetrics(sendSlots[0], tick);
+			if(rank){
+				MPI_Send(&sendSlots[0], 1, allMetricsType, 0, 0, MPI_COMM_WORLD);
+				continue;
+			}
+			receiveSlots[0][0] = sendSlots[0];
+			for(int j = 1; j < clusterSize; j++)
+				MPI_Recv(&receiveSlots[0][j], 1, allMetricsType, j, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			sendReceiveTime.push_back(realTime() - scheduler.tickTime());
+		}
+	}
+
+	// The pipeline of measure-performance: the gather of a tick progresses while the nodes sleep until
+	// the next one, rank 0 waits for it only after its next sample
+	{
+		int64_t epoch = waitForCommonEpoch();
+		takeSnapshot();
+		SamplingScheduler scheduler;
+		scheduler.open(periods, METRIC_GROUPS, epoch);
+		MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+		for(int i = 0; i <= ticks; i++){
+			int slot = i % 2;
+			uint32_t tick = sleepWhileGathering(scheduler, &requests[1 - slot], 1, clockExchange);
+			getAllMetrics(sendSlots[slot], tick);
+			MPI_Igather(&sendSlots[slot], 1, allMetricsType, receiveSlots[slot].data(), 1, allMetricsType, 0, MPI_COMM_WORLD, &requests[slot]);
+			MPI_Wait(&requests[1 - slot], MPI_STATUS_IGNORE);
+			if(!rank && i) pipelineTime.push_back(realTime() - scheduler.tickTime());
+		}
+		MPI_Wait(&requests[ticks % 2], MPI_STATUS_IGNORE);
+	}
+
+	if(!rank){
+		std::cout << "AllMetrics: " << recordSize << " B per node, " << ticks << " ticks of " << period << " ms\n";
+		printTickTime("send/recv", clusterSize, sendReceiveTime);
+		printTickTime("pipeline", clusterSize, pipelineTime);
+	}
+
+	MPI_Type_free(&allMetricsType);
+	MPI_Finalize();
+	return 0;
+};
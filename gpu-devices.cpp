@@ -0,0 +1,158 @@
+//
+//	gpu-devices.cpp - file with definitions of the NVIDIA GPU collector using NVML loaded at run time
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <cstring>	// strncpy
+#include <dlfcn.h>	// dlopen, dlsym, dlclose
+// Internal headers
+#include "gpu-devices.h"
+
+// Function of the library cast to the type of the pointer it is stored in, nullptr if it is missing
+template<typename Function>
+static bool findFunction(void* library, const char* name, Function &function){
+	function = reinterpret_cast<Function>(dlsym(library, name));
+	return function != nullptr;
+};
+
+GpuDevices::GpuDevices(){
+	this->library = nullptr;
+	this->previousTime = 0;
+	this->shutdown = nullptr;
+	this->getPowerUsage = nullptr;
+	this->getTotalEnergyConsumption = nullptr;
+	this->getTemperature = nullptr;
+	this->getFanSpeed = nullptr;
+	this->getClockInfo = nullptr;
+	this->getMemoryInfo = nullptr;
+	this->getUtilizationRates = nullptr;
+};
+
+GpuDevices::~GpuDevices(){
+	this->close();
+};
+
+bool GpuDevices::open(const std::string &libraryName){
+
+	this->close();
+	this->library = dlopen(libraryName.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if(!this->library) return false;
+
+	// The _v2 entry points exist since driver 325, the plain ones only for old binaries
+	nvmlReturn_t (*initialize)();
+	nvmlReturn_t (*getCount)(unsigned int*);
+	nvmlReturn_t (*getHandleByIndex)(unsigned int, nvmlDevice_t*);
+	nvmlReturn_t (*getName)(nvmlDevice_t, char*, unsigned int);
+	bool found = findFunction(this->library, "nvmlInit_v2", initialize)
+		&& findFunction(this->library, "nvmlShutdown", this->shutdown)
+		&& findFunction(this->library, "nvmlDeviceGetCount_v2", getCount)
+		&& findFunction(this->library, "nvmlDeviceGetHandleByIndex_v2", getHandleByIndex)
+		&& findFunction(this->library, "nvmlDeviceGetName", getName);
+	if(!found || initialize() != NVML_SUCCESS){
+		this->shutdown = nullptr;
+		this->close();
+		return false;
+	}
+
+	// Queries missing from an old library leave their values at -1
+	findFunction(this->library, "nvmlDeviceGetPowerUsage", this->getPowerUsage);
+	findFunction(this->library, "nvmlDeviceGetTotalEnergyConsumption", this->getTotalEnergyConsumption);
+	findFunction(this->library, "nvmlDeviceGetTemperature", this->getTemperature);
+	findFunction(this->library, "nvmlDeviceGetFanSpeed", this->getFanSpeed);
+	findFunction(this->library, "nvmlDeviceGetClockInfo", this->getClockInfo);
+	findFunction(this->library, "nvmlDeviceGetMemoryInfo", this->getMemoryInfo);
+	findFunction(this->library, "nvmlDeviceGetUtilizationRates", this->getUtilizationRates);
+
+	unsigned int count = 0;
+	if(getCount(&count) != NVML_SUCCESS) count = 0;
+	for(unsigned int i = 0; i < count && this->gpus.size() < GPU_MAX_DEVICES; i++){
+		Device device;
+		if(getHandleByIndex(i, &device.handle) != NVML_SUCCESS) continue;
+		char name[96];					// NVML_DEVICE_NAME_V2_BUFFER_SIZE
+		device.name = getName(device.handle, name, sizeof(name)) == NVML_SUCCESS ? name : "GPU " + std::to_string(i);
+		device.previousEnergy = UINT64_MAX;
+		this->gpus.push_back(device);
+	}
+
+	if(this->gpus.empty()){
+		this->close();
+		return false;
+	}
+	return true;
+};
+
+bool GpuDevices::isOpen() const {
+	return !this->gpus.empty();
+};
+
+void GpuDevices::close(){
+
+	if(this->shutdown) this->shutdown();
+	if(this->library) dlclose(this->library);
+	this->library = nullptr;
+	this->gpus.clear();
+	this->previousTime = 0;
+	this->shutdown = nullptr;
+	this->getPowerUsage = nullptr;
+	this->getTotalEnergyConsumption = nullptr;
+	this->getTemperature = nullptr;
+	this->getFanSpeed = nullptr;
+	this->getClockInfo = nullptr;
+	this->getMemoryInfo = nullptr;
+	this->getUtilizationRates = nullptr;
+};
+
+int GpuDevices::devices() const {
+	return this->gpus.size();
+};
+
+bool GpuDevices::read(GpuReading &reading, uint64_t now){
+
+	reading.devices = this->gpus.size();
+	reading.elapsedTime = this->previousTime && now > this->previousTime ? (now - this->previousTime) / 1e9 : 0;
+	this->previousTime = now;
+
+	unsigned int value;
+	unsigned long long energy;
+	nvmlMemory_t memory;
+	nvmlUtilization_t utilization;
+	for(int i = 0; i < reading.devices; i++){
+		Device &device = this->gpus[i];
+		strncpy(reading.names[i], device.name.c_str(), GPU_NAME_LENGTH - 1);
+		reading.names[i][GPU_NAME_LENGTH - 1] = '\0';
+
+		// Energy in mJ since the driver was loaded, the power reading is averaged over about a second
+		reading.power[i] = -1;
+		if(this->getTotalEnergyConsumption && this->getTotalEnergyConsumption(device.handle, &energy) == NVML_SUCCESS){
+			if(device.previousEnergy != UINT64_MAX && energy >= device.previousEnergy && reading.elapsedTime > 0)
+				reading.power[i] = (energy - device.previousEnergy) / 1e3 / reading.elapsedTime;
+			device.previousEnergy = energy;
+		}
+		if(reading.power[i] < 0 && this->getPowerUsage && this->getPowerUsage(device.handle, &value) == NVML_SUCCESS)
+			reading.power[i] = value / 1e3;
+
+		reading.temperature[i] = this->getTemperature && this->getTemperature(device.handle, NVML_TEMPERATURE_GPU, &value) == NVML_SUCCESS ? float(value) : -1;
+		// Passively cooled GPUs have no fan and give NVML_ERROR_NOT_SUPPORTED
+		reading.fanSpeed[i] = this->getFanSpeed && this->getFanSpeed(device.handle, &value) == NVML_SUCCESS ? float(value) : -1;
+		reading.clockSM[i] = this->getClockInfo && this->getClockInfo(device.handle, NVML_CLOCK_SM, &value) == NVML_SUCCESS ? float(value) : -1;
+		reading.clockMemory[i] = this->getClockInfo && this->getClockInfo(device.handle, NVML_CLOCK_MEM, &value) == NVML_SUCCESS ? float(value) : -1;
+
+		reading.memoryTotal[i] = reading.memoryUsed[i] = reading.memoryFree[i] = -1;
+		if(this->getMemoryInfo && this->getMemoryInfo(device.handle, &memory) == NVML_SUCCESS){
+			reading.memoryTotal[i] = memory.total / (1024.0 * 1024.0);
+			reading.memoryUsed[i] = memory.used / (1024.0 * 1024.0);
+			reading.memoryFree[i] = memory.free / (1024.0 * 1024.0);
+		}
+
+		reading.utilization[i] = reading.memoryUtilization[i] = -1;
+		if(this->getUtilizationRates && this->getUtilizationRates(device.handle, &utilization) == NVML_SUCCESS){
+			reading.utilization[i] = utilization.gpu;
+			reading.memoryUtilization[i] = utilization.memory;
+		}
+	}
+	return reading.devices > 0;
+};
@@ -0,0 +1,96 @@
+//
+//	gpu-devices.h - header file with the NVIDIA GPU collector using NVML loaded at run time
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef GPU_DEVICES_H
+#define GPU_DEVICES_H
+
+// External libraries
+#include <string>		// string
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+
+#define NVML_LIBRARY "libnvidia-ml.so.1"	// Installed with the driver, found through the dynamic linker
+#define GPU_MAX_DEVICES 8			// GPUs reported separately, the rest is left out
+#define GPU_NAME_LENGTH 32			// Product name, e.g. NVIDIA A100-SXM4-40GB
+
+// The parts of the NVML ABI that are used, declared here so nvml.h is not needed to build
+typedef int nvmlReturn_t;				// NVML_SUCCESS is 0
+typedef struct nvmlDevice_st* nvmlDevice_t;
+struct nvmlMemory_t {
+	unsigned long long total;			// Bytes
+	unsigned long long free;
+	unsigned long long used;
+};
+struct nvmlUtilization_t {
+	unsigned int gpu;				// % of the sample period a kernel was running
+	unsigned int memory;				// % of the sample period memory was read or written
+};
+#define NVML_SUCCESS 0
+#define NVML_TEMPERATURE_GPU 0
+#define NVML_CLOCK_SM 1
+#define NVML_CLOCK_MEM 2
+
+// Values of every GPU, -1 where the device does not support them
+struct GpuReading {
+	int devices;					// Number of GPUs found
+	char names[GPU_MAX_DEVICES][GPU_NAME_LENGTH];
+	float power[GPU_MAX_DEVICES];			// Average power since the previous read in W, or the last power reading
+	float temperature[GPU_MAX_DEVICES];		// Die temperature in C
+	float fanSpeed[GPU_MAX_DEVICES];		// Fan speed in % of the maximum
+	float clockSM[GPU_MAX_DEVICES];			// SM clock in MHz
+	float clockMemory[GPU_MAX_DEVICES];		// Memory clock in MHz
+	float memoryTotal[GPU_MAX_DEVICES];		// Memory in MB
+	float memoryUsed[GPU_MAX_DEVICES];
+	float memoryFree[GPU_MAX_DEVICES];
+	float utilization[GPU_MAX_DEVICES];		// Time a kernel was running in %
+	float memoryUtilization[GPU_MAX_DEVICES];	// Time memory was read or written in %
+	double elapsedTime;				// Interval since the previous read in seconds
+};
+
+// libnvidia-ml is opened with dlopen() once, so the application starts and runs on nodes without a
+// driver, and nvmlInit() runs once instead of the nvidia-smi process that used to be started on every
+// sample. Every GPU remembers its last total energy, so on Volta and newer the power is the energy
+// used between two reads divided by the time between them, like RAPL. Older GPUs give the power
+// reading of the driver instead.
+class GpuDevices {
+public:
+	GpuDevices();
+	GpuDevices(const GpuDevices&) = delete;
+	GpuDevices& operator=(const GpuDevices&) = delete;
+	~GpuDevices();
+
+	// File name or path of the library, false if it cannot be loaded or there is no GPU
+	bool open(const std::string& = NVML_LIBRARY);
+	bool isOpen() const;
+	void close();
+	int devices() const;
+
+	bool read(GpuReading&, uint64_t);	// With an explicit CLOCK_MONOTONIC timestamp in ns
+
+private:
+	struct Device {
+		nvmlDevice_t handle;
+		std::string name;
+		uint64_t previousEnergy;	// mJ, UINT64_MAX if the device has no energy counter
+	};
+
+	void* library;
+	std::vector<Device> gpus;
+	uint64_t previousTime;
+
+	nvmlReturn_t (*shutdown)();
+	nvmlReturn_t (*getPowerUsage)(nvmlDevice_t, unsigned int*);
+	nvmlReturn_t (*getTotalEnergyConsumption)(nvmlDevice_t, unsigned long long*);
+	nvmlReturn_t (*getTemperature)(nvmlDevice_t, int, unsigned int*);
+	nvmlReturn_t (*getFanSpeed)(nvmlDevice_t, unsigned int*);
+	nvmlReturn_t (*getClockInfo)(nvmlDevice_t, int, unsigned int*);
+	nvmlReturn_t (*getMemoryInfo)(nvmlDevice_t, nvmlMemory_t*);
+	nvmlReturn_t (*getUtilizationRates)(nvmlDevice_t, nvmlUtilization_t*);
+};
+
+#endif
@@ -0,0 +1,166 @@
+//
+//	infiniband-ports.cpp - file with definitions of the InfiniBand/RDMA port collector reading /sys/class/infiniband
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// sort
+#include <cstring>	// strncpy
+#include <dirent.h>	// opendir, readdir, closedir
+// Internal headers
+#include "infiniband-ports.h"
+
+// File names in counters/ and the width of the legacy attribute, in the order of InfinibandCounter
+static const struct {
+	const char* name;
+	int bits;
+} infinibandCounters[INFINIBAND_COUNTERS] = {
+	{"port_xmit_data", 32}, {"port_rcv_data", 32}, {"port_xmit_packets", 32}, {"port_rcv_packets", 32},
+	{"port_xmit_wait", 32}, {"symbol_error", 16}, {"link_error_recovery", 8}, {"link_downed", 8},
+	{"port_rcv_errors", 16}, {"port_rcv_remote_physical_errors", 16}, {"port_rcv_switch_relay_errors", 16},
+	{"port_xmit_discards", 16}, {"port_xmit_constraint_errors", 8}, {"port_rcv_constraint_errors", 8},
+	{"local_link_integrity_errors", 4}, {"excessive_buffer_overrun_errors", 4}, {"VL15_dropped", 16}};
+
+// Transport errors of hw_counters that mean retransmits or lost messages, names differ between drivers
+// and only the ones that exist are read
+static const char* infinibandHwErrors[] = {
+	"out_of_sequence", "packet_seq_err", "local_ack_timeout_err", "rnr_nak_retry_err", "implied_nak_seq_err",
+	"duplicate_request", "req_cqe_error", "resp_cqe_error", "req_remote_access_errors", "resp_remote_access_errors",
+	"req_remote_invalid_request", "resp_local_length_error"};
+
+// Entries of a directory without . and .., sorted, so the same machine always gives the same order
+static std::vector<std::string> listDirectory(const std::string &path){
+
+	std::vector<std::string> names;
+	DIR* directory = opendir(path.c_str());
+	if(!directory) return names;
+	struct dirent* entry;
+	while((entry = readdir(directory)) != nullptr)
+		if(entry->d_name[0] != '.') names.push_back(entry->d_name);
+	closedir(directory);
+	std::sort(names.begin(), names.end());
+	return names;
+};
+
+bool infinibandDelta(uint64_t previous, uint64_t current, int bits, uint64_t &delta){
+
+	if(previous == UINT64_MAX || current == UINT64_MAX) return false;
+	// Either a 64 bit counter that can only have been reset, or a legacy one that can only have saturated
+	if(!bits){
+		if(current < previous || (current == UINT32_MAX && previous == UINT32_MAX)) return false;
+		delta = current - previous;
+		return true;
+	}
+	uint64_t maximum = bits < 64 ? (uint64_t(1) << bits) - 1 : UINT64_MAX;
+	if(bits < 64 && current == maximum) return false;
+	if(current >= previous){
+		delta = current - previous;
+		return true;
+	}
+	if(bits > 32 || previous > maximum) return false;
+	delta = current + (maximum - previous) + 1;
+	return true;
+};
+
+bool parseInfinibandRate(std::string_view text, float &rate){
+
+	double value;
+	std::string_view number = nextToken(text);
+	if(!parseDouble(number, value)) return false;
+	rate = value;
+	return true;
+};
+
+InfinibandPorts::InfinibandPorts(){
+};
+
+bool InfinibandPorts::open(const std::string &root){
+
+	this->ports.clear();
+	for(const std::string &device : listDirectory(root)){
+		std::string portsDirectory = root + "/" + device + "/ports";
+		for(const std::string &port : listDirectory(portsDirectory)){
+			std::string name = device + "/" + port;
+			if(this->ports.size() == INFINIBAND_MAX_PORTS || name.size() >= INFINIBAND_NAME_LENGTH) continue;
+			std::string directory = portsDirectory + "/" + port + "/";
+
+			PortFiles files;
+			files.name = name;
+			files.state.open(directory + "state");
+			files.linkRate = -1;
+			ProcfsFile rateFile(directory + "rate");
+			std::string_view text = rateFile.read();
+			parseInfinibandRate(text, files.linkRate);
+
+			// Drivers that keep the 64 bit data and packet counters apart in counters_ext leave the legacy
+			// ones in counters/. Otherwise the kernel fills counters/ from PortCountersExtended when the
+			// PMA supports it, which sysfs does not tell, so their width stays unknown.
+			bool extended = !listDirectory(directory + "counters_ext").empty();
+			bool found = false;
+			for(int i = 0; i < INFINIBAND_COUNTERS; i++){
+				files.bits[i] = infinibandCounters[i].bits;
+				if(i <= INFINIBAND_RCV_PACKETS && files.counters[i].open(directory + "counters_ext/" + infinibandCounters[i].name + "_64"))
+					files.bits[i] = 64;
+				else{
+					files.counters[i].open(directory + "counters/" + infinibandCounters[i].name);
+					if(i <= INFINIBAND_RCV_PACKETS && !extended) files.bits[i] = 0;
+				}
+				found |= files.counters[i].isOpen();
+			}
+
+			for(const char* counter : infinibandHwErrors){
+				ProcfsFile file(directory + "hw_counters/" + counter);
+				if(file.isOpen()) files.hwErrors.push_back(std::move(file));
+			}
+			files.outOfBuffer.open(directory + "hw_counters/out_of_buffer");
+
+			if(found || !files.hwErrors.empty()) this->ports.push_back(std::move(files));
+		}
+	}
+	return !this->ports.empty();
+};
+
+bool InfinibandPorts::isOpen() const {
+	return !this->ports.empty();
+};
+
+void InfinibandPorts::read(InfinibandReading &reading){
+
+	reading.ports = this->ports.size();
+	uint64_t value;
+	std::string_view text;
+	for(int i = 0; i < reading.ports; i++){
+		PortFiles &files = this->ports[i];
+		strncpy(reading.names[i], files.name.c_str(), INFINIBAND_NAME_LENGTH);
+		reading.linkRate[i] = files.linkRate;
+
+		// "4: ACTIVE"
+		text = files.state.read();
+		reading.state[i] = parseUnsigned(text, value) ? int(value) : -1;
+
+		for(int j = 0; j < INFINIBAND_COUNTERS; j++){
+			text = files.counters[j].read();
+			reading.counters[i][j] = parseUnsigned(text, value) ? value : UINT64_MAX;
+			reading.bits[i][j] = files.bits[j];
+		}
+
+		// Only an extended counter goes above the legacy maximum, which settles a width that was unknown
+		for(int j = INFINIBAND_XMIT_DATA; j <= INFINIBAND_RCV_PACKETS; j++)
+			if(!files.bits[j] && reading.counters[i][j] != UINT64_MAX && reading.counters[i][j] > UINT32_MAX) files.bits[j] = reading.bits[i][j] = 64;
+
+		reading.hwErrors[i] = files.hwErrors.empty() ? UINT64_MAX : 0;
+		for(ProcfsFile &file : files.hwErrors){
+			text = file.read();
+			if(!parseUnsigned(text, value)){
+				reading.hwErrors[i] = UINT64_MAX;
+				break;
+			}
+			reading.hwErrors[i] += value;
+		}
+		text = files.outOfBuffer.read();
+		reading.outOfBuffer[i] = parseUnsigned(text, value) ? value : UINT64_MAX;
+	}
+};
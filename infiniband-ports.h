@@ -0,0 +1,93 @@
+//
+//	infiniband-ports.h - header file with the InfiniBand/RDMA port collector reading /sys/class/infiniband
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef INFINIBAND_PORTS_H
+#define INFINIBAND_PORTS_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define INFINIBAND_ROOT "/sys/class/infiniband"	// One directory per RDMA device, e.g. mlx5_0, hfi1_0, irdma0
+#define INFINIBAND_MAX_PORTS 8			// Ports reported separately, the rest is left out
+#define INFINIBAND_NAME_LENGTH 24		// Device and port number, e.g. mlx5_0/1
+
+// Port counters of the PMA, in counters/ of every port. The comments give the width of the
+// legacy PortCounters attribute, which saturates instead of wrapping.
+enum InfinibandCounter {
+	INFINIBAND_XMIT_DATA,			// port_xmit_data, 32 bits, in units of 4 bytes
+	INFINIBAND_RCV_DATA,			// port_rcv_data, 32 bits, in units of 4 bytes
+	INFINIBAND_XMIT_PACKETS,		// port_xmit_packets, 32 bits
+	INFINIBAND_RCV_PACKETS,			// port_rcv_packets, 32 bits
+	INFINIBAND_XMIT_WAIT,			// port_xmit_wait, 32 bits, ticks with data to send and no credits
+	INFINIBAND_SYMBOL_ERROR,		// symbol_error, 16 bits
+	INFINIBAND_LINK_ERROR_RECOVERY,		// link_error_recovery, 8 bits
+	INFINIBAND_LINK_DOWNED,			// link_downed, 8 bits
+	INFINIBAND_RCV_ERRORS,			// port_rcv_errors, 16 bits
+	INFINIBAND_RCV_REMOTE_PHYSICAL_ERRORS,	// port_rcv_remote_physical_errors, 16 bits
+	INFINIBAND_RCV_SWITCH_RELAY_ERRORS,	// port_rcv_switch_relay_errors, 16 bits
+	INFINIBAND_XMIT_DISCARDS,		// port_xmit_discards, 16 bits
+	INFINIBAND_XMIT_CONSTRAINT_ERRORS,	// port_xmit_constraint_errors, 8 bits
+	INFINIBAND_RCV_CONSTRAINT_ERRORS,	// port_rcv_constraint_errors, 8 bits
+	INFINIBAND_LOCAL_LINK_INTEGRITY_ERRORS,	// local_link_integrity_errors, 4 bits
+	INFINIBAND_EXCESSIVE_BUFFER_OVERRUN_ERRORS,	// excessive_buffer_overrun_errors, 4 bits
+	INFINIBAND_VL15_DROPPED,		// VL15_dropped, 16 bits
+	INFINIBAND_COUNTERS
+};
+
+struct InfinibandReading {
+	int ports;							// Number of ports found
+	char names[INFINIBAND_MAX_PORTS][INFINIBAND_NAME_LENGTH];	// e.g. mlx5_0/1
+	int state[INFINIBAND_MAX_PORTS];				// 4 is ACTIVE, -1 if unknown
+	float linkRate[INFINIBAND_MAX_PORTS];				// Signalling rate of the link in Gb/s, -1 if unknown
+	uint64_t counters[INFINIBAND_MAX_PORTS][INFINIBAND_COUNTERS];	// UINT64_MAX when missing
+	int bits[INFINIBAND_MAX_PORTS][INFINIBAND_COUNTERS];		// Width of every counter, 64 when extended, 0 when unknown
+	uint64_t hwErrors[INFINIBAND_MAX_PORTS];			// Error counters of hw_counters summed
+	uint64_t outOfBuffer[INFINIBAND_MAX_PORTS];			// out_of_buffer of hw_counters
+};
+
+// Ports are listed once from the device directories, sorted by name, and keep their slots for the
+// whole run. The counters of every port stay open and are read once per sample. The data and packet
+// counters come from counters_ext/*_64 where the driver has them, otherwise from counters/, which
+// the kernel fills from PortCountersExtended when the HCA supports them.
+class InfinibandPorts {
+public:
+	InfinibandPorts();
+
+	bool open(const std::string& = INFINIBAND_ROOT);
+	bool isOpen() const;
+
+	void read(InfinibandReading&);
+
+private:
+	struct PortFiles {
+		std::string name;
+		ProcfsFile state;
+		ProcfsFile counters[INFINIBAND_COUNTERS];
+		int bits[INFINIBAND_COUNTERS];
+		float linkRate;
+		std::vector<ProcfsFile> hwErrors;
+		ProcfsFile outOfBuffer;
+	};
+
+	std::vector<PortFiles> ports;
+};
+
+// Increase of a port counter between two reads. A legacy counter stuck at its maximum has
+// saturated and gives false, so does a 64 bit one that went back after a reset. A counter of up
+// to 32 bits that went back has wrapped, some drivers do not saturate. A counter of unknown width
+// that went back was reset, one that stays at UINT32_MAX may have saturated, both give false.
+bool infinibandDelta(uint64_t, uint64_t, int, uint64_t&);
+// "100 Gb/sec (4X EDR)" from the rate file in Gb/s
+bool parseInfinibandRate(std::string_view, float&);
+
+#endif
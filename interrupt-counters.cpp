@@ -0,0 +1,189 @@
+//
+//	interrupt-counters.cpp - file with definitions of the per-IRQ collector reading /proc/interrupts and /proc/softirqs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// min
+#include <cstring>	// memset, memcpy
+#include <utility>	// swap
+// Internal headers
+#include "interrupt-counters.h"
+
+// Fixed size fields of InterruptPair are always terminated, longer names are cut
+static void copyName(char* field, size_t size, std::string_view text){
+
+	memset(field, 0, size);
+	memcpy(field, text.data(), std::min(text.size(), size - 1));
+};
+
+void parseInterruptHeader(std::string_view line, std::vector<int> &cpus){
+
+	cpus.clear();
+	while(!line.empty()){
+		std::string_view token = nextToken(line);
+		if(token.substr(0, 3) != "CPU") continue;
+		token.remove_prefix(3);
+		uint64_t cpu;
+		if(parseUnsigned(token, cpu)) cpus.push_back(cpu);
+	}
+};
+
+bool parseInterruptLine(std::string_view line, std::string_view &name, uint64_t* counts, int columns, std::string_view &device){
+
+	size_t colon = line.find(':');
+	if(colon == std::string_view::npos) return false;
+	name = line.substr(0, colon);
+	skipWhitespace(name);
+	line.remove_prefix(colon + 1);
+	if(name.empty() || parseUnsignedList(line, counts, columns) < columns) return false;
+
+	// The chip and the hwirq come first, the handlers follow after a wider gap,
+	// e.g. "IR-PCI-MSI 524288-edge      eth0-TxRx-0" or "  Local timer interrupts"
+	while(!line.empty() && (line.back() == ' ' || line.back() == '\t')) line.remove_suffix(1);
+	size_t gap = line.rfind("  ");
+	if(gap != std::string_view::npos) line.remove_prefix(gap);
+	skipWhitespace(line);
+	device = line;
+	return true;
+};
+
+InterruptCounters::InterruptCounters(){
+	for(InterruptTable &table : this->tables) table.rows = table.previousRows = 0;
+	this->previousTime = 0;
+};
+
+bool InterruptCounters::open(const std::string &interruptsPath, const std::string &softirqsPath){
+
+	const std::string* paths[INTERRUPT_KINDS] = {&interruptsPath, &softirqsPath};
+	bool opened = false;
+	for(int kind = 0; kind < INTERRUPT_KINDS; kind++){
+		InterruptTable &table = this->tables[kind];
+		table.rows = table.previousRows = 0;
+		if(!table.file.open(*paths[kind])) continue;
+		// The first read only fills the counters the next one is compared with
+		opened |= this->parse(table);
+	}
+	this->previousTime = monotonicTime();
+	return opened;
+};
+
+bool InterruptCounters::isOpen() const {
+	return this->tables[INTERRUPT_HARD].file.isOpen() || this->tables[INTERRUPT_SOFT].file.isOpen();
+};
+
+bool InterruptCounters::parse(InterruptTable &table){
+
+	std::swap(table.cpus, table.previousCpus);
+	std::swap(table.sources, table.previousSources);
+	table.previousRows = table.rows;
+	table.rows = 0;
+
+	std::string_view text = table.file.read();
+	if(text.empty()) return false;
+	parseInterruptHeader(nextLine(text), table.cpus);
+	int columns = table.cpus.size();
+	if(!columns) return false;
+
+	std::string_view name, device;
+	while(!text.empty()){
+		std::string_view line = nextLine(text);
+		if(table.rows == (int)table.sources.size()) table.sources.emplace_back();
+		InterruptSource &source = table.sources[table.rows];
+		source.counts.resize(columns);
+		if(!parseInterruptLine(line, name, source.counts.data(), columns, device)) continue;
+
+		// Assigning keeps the capacity, so after the first reads nothing is allocated anymore
+		source.name.assign(name);
+		source.device.assign(device);
+		table.rows++;
+	}
+	return table.rows > 0;
+};
+
+void InterruptCounters::compare(InterruptTable &table, InterruptKind kind, InterruptReading &reading){
+
+	// A CPU that went offline or online shifts every column, so that interval is not compared
+	int columns = table.cpus.size();
+	if(!table.previousRows || table.cpus != table.previousCpus) return;
+	table.cpuTotals.assign(columns, 0);
+
+	struct Candidate {
+		uint64_t delta;
+		int row;
+		int column;
+	} best[INTERRUPT_TOP];
+	int found = 0;
+
+	for(int row = 0; row < table.rows; row++){
+		const InterruptSource &source = table.sources[row];
+
+		// Lines stay in place unless an IRQ was requested or freed in between
+		int previous = row;
+		if(previous >= table.previousRows || table.previousSources[previous].name != source.name)
+			for(previous = 0; previous < table.previousRows; previous++)
+				if(table.previousSources[previous].name == source.name) break;
+		if(previous == table.previousRows) continue;
+		const uint64_t* before = table.previousSources[previous].counts.data();
+
+		for(int column = 0; column < columns; column++){
+			if(source.counts[column] <= before[column]) continue;
+			uint64_t delta = source.counts[column] - before[column];
+			table.cpuTotals[column] += delta;
+
+			// Insertion into the short sorted list, most cells do not get past the first comparison
+			if(found == INTERRUPT_TOP && delta <= best[found - 1].delta) continue;
+			int position = found < INTERRUPT_TOP ? found++ : found - 1;
+			while(position > 0 && best[position - 1].delta < delta){
+				best[position] = best[position - 1];
+				position--;
+			}
+			best[position] = {delta, row, column};
+		}
+	}
+
+	reading.pairs[kind] = found;
+	for(int i = 0; i < found; i++){
+		const InterruptSource &source = table.sources[best[i].row];
+		InterruptPair &pair = reading.top[kind][i];
+		copyName(pair.name, sizeof(pair.name), source.name);
+		copyName(pair.device, sizeof(pair.device), source.device);
+		pair.cpu = table.cpus[best[i].column];
+		pair.count = source.counts[best[i].column];
+		pair.rate = best[i].delta / reading.elapsedTime;
+	}
+
+	int busiest = std::max_element(table.cpuTotals.begin(), table.cpuTotals.end()) - table.cpuTotals.begin();
+	reading.busiestCpu[kind] = table.cpuTotals[busiest] ? table.cpus[busiest] : -1;
+	reading.busiestCpuRate[kind] = table.cpuTotals[busiest] / reading.elapsedTime;
+};
+
+bool InterruptCounters::read(InterruptReading &reading){
+	return this->read(reading, monotonicTime());
+};
+
+bool InterruptCounters::read(InterruptReading &reading, uint64_t now){
+
+	reading.cpus = this->tables[INTERRUPT_HARD].cpus.size();
+	for(int kind = 0; kind < INTERRUPT_KINDS; kind++){
+		reading.pairs[kind] = 0;
+		reading.busiestCpu[kind] = -1;
+		reading.busiestCpuRate[kind] = -1;
+	}
+
+	reading.elapsedTime = 0;
+	if(now <= this->previousTime || !this->isOpen()) return false;
+	reading.elapsedTime = (now - this->previousTime) / 1e9;
+	this->previousTime = now;
+
+	for(int kind = 0; kind < INTERRUPT_KINDS; kind++){
+		InterruptTable &table = this->tables[kind];
+		if(!table.file.isOpen()) continue;
+		if(this->parse(table)) this->compare(table, (InterruptKind)kind, reading);
+	}
+	reading.cpus = this->tables[INTERRUPT_HARD].cpus.size();
+	return true;
+};
@@ -0,0 +1,92 @@
+//
+//	interrupt-counters.h - header file with the per-IRQ collector reading /proc/interrupts and /proc/softirqs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef INTERRUPT_COUNTERS_H
+#define INTERRUPT_COUNTERS_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define INTERRUPTS_FILE "/proc/interrupts"	// One line per IRQ with a column per online CPU
+#define SOFTIRQS_FILE "/proc/softirqs"		// The same for the ten softirq types
+#define INTERRUPT_TOP 8				// Busiest IRQ/CPU pairs reported per sample
+#define INTERRUPT_NAME_LENGTH 16		// IRQ number or name, e.g. 35, LOC, NET_RX
+#define INTERRUPT_DEVICE_LENGTH 48		// Handlers of an IRQ, e.g. mlx5_comp0@pci:0000:01:00.0
+
+enum InterruptKind {
+	INTERRUPT_HARD,				// /proc/interrupts
+	INTERRUPT_SOFT,				// /proc/softirqs
+	INTERRUPT_KINDS
+};
+
+// One IRQ handled on one CPU
+struct InterruptPair {
+	char name[INTERRUPT_NAME_LENGTH];	// Label of the line without the colon
+	char device[INTERRUPT_DEVICE_LENGTH];	// Handlers or description at the end of the line, empty for softirqs
+	int cpu;				// Logical CPU number of the column
+	uint64_t count;				// Handled on this CPU since boot
+	double rate;				// Handled on this CPU per second since the previous read
+};
+
+struct InterruptReading {
+	int cpus;						// CPU columns of the files
+	int pairs[INTERRUPT_KINDS];				// Valid entries of top
+	InterruptPair top[INTERRUPT_KINDS][INTERRUPT_TOP];	// Busiest pairs first, pairs without any interrupt are left out
+	int busiestCpu[INTERRUPT_KINDS];			// CPU handling the most interrupts of the kind, -1 if none
+	double busiestCpuRate[INTERRUPT_KINDS];			// Its interrupts per second
+	double elapsedTime;					// Interval since the previous read in seconds
+};
+
+// Both files keep their descriptors and the counters of the previous read, so every read gives
+// the per-IRQ, per-CPU deltas without copying the whole matrix into the snapshot. Only the busiest
+// pairs leave the collector, on nodes with hundreds of CPUs the matrix has tens of thousands of cells.
+class InterruptCounters {
+public:
+	InterruptCounters();
+
+	bool open(const std::string& = INTERRUPTS_FILE, const std::string& = SOFTIRQS_FILE);
+	bool isOpen() const;
+
+	bool read(InterruptReading&);
+	bool read(InterruptReading&, uint64_t);	// With an explicit CLOCK_MONOTONIC timestamp in ns
+
+private:
+	struct InterruptSource {
+		std::string name;
+		std::string device;
+		std::vector<uint64_t> counts;	// One per CPU column
+	};
+
+	// Current and previous counters are swapped on every read, so the strings and vectors are reused
+	struct InterruptTable {
+		ProcfsFile file;
+		std::vector<int> cpus, previousCpus;	// CPU number of every column
+		std::vector<InterruptSource> sources, previousSources;
+		int rows, previousRows;
+		std::vector<uint64_t> cpuTotals;	// Interrupts of every column during the interval
+	};
+
+	InterruptTable tables[INTERRUPT_KINDS];
+	uint64_t previousTime;
+
+	bool parse(InterruptTable&);
+	void compare(InterruptTable&, InterruptKind, InterruptReading&);
+};
+
+// Header line "CPU0 CPU1 ..." into the CPU number of every column
+void parseInterruptHeader(std::string_view, std::vector<int>&);
+// "35: 10 0 ... IR-PCI-MSI 524288-edge eth0-TxRx-0" into the name, the counts of the columns and the
+// handlers. Lines with fewer counts than columns, like ERR and MIS, are not per CPU and give false.
+bool parseInterruptLine(std::string_view, std::string_view&, uint64_t*, int, std::string_view&);
+
+#endif
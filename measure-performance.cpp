@@ -7,8 +7,9 @@
 //
 // An application for monitoring performance and energy consumption in a computing cluster
 //
-// mpicxx -std=c++2a measure-performance.cpp metrics.cpp metrics-display.cpp metrics-save.cpp node-synchronization.cpp -o measure-performance
+// mpicxx -std=c++2a measure-performance.cpp metrics.cpp metrics-display.cpp metrics-save.cpp node-synchronization.cpp procfs-reader.cpp perf-counters.cpp rapl-power.cpp process-tree.cpp target-launcher.cpp block-devices.cpp network-interfaces.cpp cpu-topology.cpp pressure-stall.cpp interrupt-counters.cpp cpu-frequency.cpp cgroup-accounting.cpp infiniband-ports.cpp gpu-devices.cpp power-meter.cpp sampling-scheduler.cpp clock-offset.cpp -o measure-performance -ldl
 // mpirun -mca orte_keep_fqdn_hostnames t -mca btl_tcp_if_exclude docker0,docker_gwbridge,lo -hostfile hostfile.des measure-performance
+// mpirun -hostfile hostfile.des measure-performance --period 500 -- ./application arguments
 //
 // Project realised in academic years 2022-2023
 // Gdansk University of Technology, Department of Computer Systems Architecture
@@ -18,17 +19,49 @@
 // External libraries
 #include <iostream>		// cin, cout, cerr
 #include <string>		// string
-#include <mpi.h>		// MPI_Datatype, MPI_Init, MPI_Recv, MPI_Send, ...
-#include "json.hpp"		// json
+#include <cstring>		// strcmp
+#include <cstdlib>		// atoi
+#include <ctime>		// time, localtime, strftime
+#include <csignal>		// signal, sig_atomic_t
+#include <mpi.h>		// MPI_Datatype, MPI_Init, MPI_Igather, MPI_Wait, ...
 // Internal headers
 #include "metrics.h"
 #include "metrics-save.h"
 #include "metrics-display.h"
 #include "node-synchronization.h"
+#include "process-tree.h"
+#include "procfs-reader.h"
+#include "target-launcher.h"
 
-#define GPROCESSID 1				// PID of process that we are focused on (G stands for global)
 #define DATA_BATCH 10				// How many times you want to download metrics
-using json = nlohmann::json;
+#define SAMPLING_PERIOD 1000			// Default time between two samples in ms
+#define MIN_SAMPLING_PERIOD 100			// Shortest time between two samples in ms
+#define MIN_COLLECTOR_PERIOD 10			// Shortest period of a single collector in ms
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int){
+	stopRequested = 1;
+};
+
+// "power=50,processor=100,io=60000" into the periods of the collectors, false if a part is not understood
+static bool parseCollectorPeriods(const std::string &list, int* periods){
+
+	bool understood = true;
+	size_t start = 0;
+	while(start < list.size()){
+		size_t end = list.find(',', start);
+		if(end == std::string::npos) end = list.size();
+		std::string part = list.substr(start, end - start);
+		size_t equals = part.find('=');
+		int group = equals == std::string::npos ? -1 : findMetricGroup(part.substr(0, equals));
+		int period = group < 0 ? 0 : std::atoi(part.c_str() + equals + 1);
+		if(period >= MIN_COLLECTOR_PERIOD) periods[group] = period;
+		else understood = false;
+		start = end + 1;
+	}
+	return understood;
+};
 
 int main(int argc, char **argv){
 
@@ -38,85 +71,269 @@ int main(int argc, char **argv){
 	MemoryMetrics memoryMetrics;
 	NetworkMetrics networkMetrics;
 	PowerMetrics powerMetrics;
-	AllMetrics allMetrics;
-
-	const char* dateCommand = "date +'%d%m-%H%M'";
-	std::string date = exec(dateCommand);
-	// Output of the exec(dateCommand) has to be escaped by pop_back() to work
-	date.pop_back();
 
-	std::string fileName = "results/" + date + "_metrics.json";
-	std::ofstream outputFile(fileName, std::ios::out);
-	if(!outputFile.is_open()) std::cerr << "\n\n\t[ERROR] Unable to open file " << fileName << " for writing.\n";
-	
 	int rank, clusterSize;
 	MPI_Init(&argc, &argv);
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 	MPI_Comm_size(MPI_COMM_WORLD, &clusterSize);
 
-	MPI_Datatype systemMetricsType = createMpiSystemMetricsType();
-	MPI_Datatype processorMetricsType = createMpiProcessorMetricsType();
-	MPI_Datatype inputOutputMetricsType = createMpiInputOutputMetricsType();
-	MPI_Datatype memoryMetricsType = createMpiMemoryMetricsType();
-	MPI_Datatype networkMetricsType = createMpiNetworkMetricsType();
-	MPI_Datatype powerMetricsType = createMpiPowerMetricsType();
-	MPI_Datatype allMetricsType;
-
-	int blockLengths[] = {1, 1, 1, 1, 1, 1};
-    	MPI_Datatype metricTypes[] = {
-		systemMetricsType, processorMetricsType, inputOutputMetricsType,
-		memoryMetricsType, networkMetricsType, powerMetricsType};
-    	MPI_Aint metricOffsets[] = {
-		offsetof(struct AllMetrics, systemMetrics),
-		offsetof(struct AllMetrics, processorMetrics),
-		offsetof(struct AllMetrics, inputOutputMetrics),
-		offsetof(struct AllMetrics, memoryMetrics),
-		offsetof(struct AllMetrics, networkMetrics),
-		offsetof(struct AllMetrics, powerMetrics)};
-
-	MPI_Type_create_struct(6, blockLengths, metricOffsets, metricTypes, &allMetricsType);
-	MPI_Type_commit(&allMetricsType);
-	AllMetrics* allMetricsArray = new AllMetrics[clusterSize];
-	json jsonArray;
-
-	// Download metrics in constant batches
-	for(int i = 0; i < DATA_BATCH; i++){
-
-		getSystemMetrics(allMetrics.systemMetrics);
-		getProcessorMetrics(allMetrics.processorMetrics);
-		getInputOutputMetrics(allMetrics.inputOutputMetrics);
-		getMemoryMetrics(allMetrics.memoryMetrics);
-		getNetworkMetrics(allMetrics.networkMetrics);
-		getPowerMetrics(allMetrics.powerMetrics);
-
-		if(rank)
-			MPI_Send(&allMetrics, 1, allMetricsType, 0, 0, MPI_COMM_WORLD);
+	// --iterations [number of samples] --period [time between samples in ms] --format [ndjson or columnar]
+	// --collector-period [collector=ms,... e.g. power=50,processor=100,memory=1000, the others use --period]
+	// --pid [root of the monitored process tree] --command [name of the root of the process tree]
+	// --network-include [interfaces] --network-exclude [interfaces], comma separated globs like btl_tcp_if_exclude
+	// --pressure-trigger [stall time in us within PRESSURE_TRIGGER_WINDOW that wakes the sampler]
+	// --cgroup [cgroup v2 directory of the job, e.g. /system.slice/slurmstepd.scope/job_42, instead of the one of the target]
+	// --nvml [libnvidia-ml to load instead of NVML_LIBRARY, e.g. the stub built from nvml-stub.cpp]
+	// --power-meter [host[:port] or serial device[@baud] of a Yokogawa WT meter, comma separated for one per rank]
+	// --power-meter-period [time between two readings of the meter in ms]
+	// --launch-on-root -- [command started on every node, or only on the root, and monitored until it exits]
+	int iterations = DATA_BATCH, samplingPeriod = SAMPLING_PERIOD, targetProcess = -1, pressureTrigger = -1, meterPeriod = METER_PERIOD;
+	const char* targetCommand = nullptr;
+	std::string networkInclude, networkExclude = NETWORK_EXCLUDE, jobCgroup, gpuLibrary, powerMeter, collectorPeriods;
+	char** launchCommand = nullptr;
+	bool columnar = false, launchOnRoot = false;
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "--")){
+			if(i + 1 < argc) launchCommand = &argv[i + 1];
+			break;
+		}
+		else if(!strcmp(argv[i], "--launch-on-root")) launchOnRoot = true;
+		else if(i == argc - 1) break;
+		else if(!strcmp(argv[i], "--iterations")) iterations = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--period")) samplingPeriod = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--format")) columnar = !strcmp(argv[++i], "columnar");
+		else if(!strcmp(argv[i], "--collector-period")) collectorPeriods = argv[++i];
+		else if(!strcmp(argv[i], "--pid")) targetProcess = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--command")) targetCommand = argv[++i];
+		else if(!strcmp(argv[i], "--network-include")) networkInclude = argv[++i];
+		else if(!strcmp(argv[i], "--network-exclude")) networkExclude = argv[++i];
+		else if(!strcmp(argv[i], "--pressure-trigger")) pressureTrigger = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--cgroup")) jobCgroup = argv[++i];
+		else if(!strcmp(argv[i], "--nvml")) gpuLibrary = argv[++i];
+		else if(!strcmp(argv[i], "--power-meter")) powerMeter = argv[++i];
+		else if(!strcmp(argv[i], "--power-meter-period")) meterPeriod = std::stoi(argv[++i]);
+	}
+
+	// Every node looks for its own target, PIDs are not the same on different nodes
+	if(targetCommand){
+		targetProcess = findProcessByName(targetCommand);
+		if(targetProcess < 0) std::cerr << "\n\t[WARNING] Node " << rank << ": no process called " << targetCommand << "\n";
+	}
+
+	// The launched command replaces any other target, it is started as late as possible to miss no sample
+	TargetLauncher launcher;
+	bool launched = launchCommand != nullptr;
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+
+	if(targetProcess > 0 && !launched && !setTargetProcess(targetProcess))
+		std::cerr << "\n\t[WARNING] Node " << rank << ": unable to follow process " << targetProcess << "\n";
+	if((!networkInclude.empty() || networkExclude != NETWORK_EXCLUDE) && !setNetworkInterfaces(networkInclude, networkExclude))
+		std::cerr << "\n\t[WARNING] Node " << rank << ": unable to read /proc/net/dev\n";
+	if(!jobCgroup.empty() && !setJobCgroup(jobCgroup))
+		std::cerr << "\n\t[WARNING] Node " << rank << ": no cgroup v2 files in " << jobCgroup << "\n";
+	if(!gpuLibrary.empty() && !setGpuLibrary(gpuLibrary))
+		std::cerr << "\n\t[WARNING] Node " << rank << ": no GPU found through " << gpuLibrary << "\n";
+	// Every node has its own meter, a single address is shared by all ranks
+	if(!powerMeter.empty()){
+		size_t start = 0, end;
+		for(int i = 0; i < rank && (end = powerMeter.find(',', start)) != std::string::npos; i++) start = end + 1;
+		std::string address = powerMeter.substr(start, powerMeter.find(',', start) - start);
+		if(!setPowerMeter(address, meterPeriod))
+			std::cerr << "\n\t[WARNING] Node " << rank << ": no power meter answering at " << address << "\n";
+	}
+	if(pressureTrigger > 0 && !setPressureTriggers(pressureTrigger))
+		std::cerr << "\n\t[WARNING] Node " << rank << ": unable to register PSI triggers in " << PRESSURE_ROOT << "\n";
+	if(samplingPeriod < MIN_SAMPLING_PERIOD){
+		if(!rank) std::cerr << "\n\t[WARNING] Sampling period raised to the minimum of " << MIN_SAMPLING_PERIOD << " ms\n";
+		samplingPeriod = MIN_SAMPLING_PERIOD;
+	}
+	int periods[METRIC_GROUPS];
+	for(int &period : periods) period = samplingPeriod;
+	if(!parseCollectorPeriods(collectorPeriods, periods) && !rank)
+		std::cerr << "\n\t[WARNING] Collector periods are name=ms pairs of at least " << MIN_COLLECTOR_PERIOD
+			<< " ms, " << collectorPeriods << " was not understood completely\n";
+
+	// Only the root writes, one JSON line per sample as soon as it arrives or one column per metric
+	ResultWriter resultWriter;
+	ColumnarWriter columnarWriter;
+	std::string line, fileName;
+	if(!rank){
+		char date[16];
+		std::time_t now = std::time(nullptr);
+		std::strftime(date, sizeof(date), "%d%m-%H%M", std::localtime(&now));
+
+		fileName = "results/" + std::string(date) + (columnar ? "_metrics.columns" : "_metrics.ndjson");
+		bool opened = columnar ? columnarWriter.open(fileName, clusterSize) : resultWriter.open(fileName);
+		if(!opened) std::cerr << "\n\n\t[ERROR] Unable to open file " << fileName << " for writing.\n";
+	}
+
+	// One type per set of collectors that are due together, only their sections go through MPI,
+	// with as many entries of cpuMetrics as the largest node has CPUs
+	MPI_Datatype recordTypes[METRIC_ALL_GROUPS + 1];
+	for(MPI_Datatype &type : recordTypes) type = MPI_DATATYPE_NULL;
+	int clusterCpus = countClusterCpus();
+
+	// Two slots, so the gather of one record is still in flight while the next one is collected
+	AllMetrics sendSlots[2];
+	AllMetrics* receiveSlots[2] = {nullptr, nullptr};
+	if(!rank) for(AllMetrics* &slot : receiveSlots) slot = new AllMetrics[clusterSize];
+	// Last value of every section of every node, for the display and the columnar file
+	AllMetrics* latestMetrics = rank ? nullptr : new AllMetrics[clusterSize];
+	SamplingCost sampleCosts[2], displayCost = {0};
+	uint64_t tickTimes[2], nextDisplay = uint64_t(samplingPeriod) * 1000000;
+	int64_t worstJitter = 0;
+	int worstJitterNode = 0;
+	// Offset and drift of the clock of every node to the clock of the root, from the probes every CLOCK_SYNC_PERIOD
+	ClockExchange clockExchange;
+	uint64_t nextClockSync = uint64_t(CLOCK_SYNC_PERIOD) * 1000000;
+
+	// Next to every gather the nodes agree whether a launched command still runs anywhere and whether
+	// any of them was asked to stop, {running, stop requested} reduced with MPI_MAX
+	MPI_Request sampleRequests[2][2] = {{MPI_REQUEST_NULL, MPI_REQUEST_NULL}, {MPI_REQUEST_NULL, MPI_REQUEST_NULL}};
+	int localStatus[2][2], clusterStatus[2][2];
+
+	// Only the root waits for the data, the other nodes just complete their part of the collectives.
+	// Every record goes to the NDJSON file as it is, the display shows the last values once per --period.
+	auto finishSample = [&](int slot){
+		MPI_Waitall(2, sampleRequests[slot], MPI_STATUSES_IGNORE);
+		if(rank) return;
+
+		AllMetrics* allMetricsArray = receiveSlots[slot];
+		for(int j = 0; j < clusterSize; j++){
+			AllMetrics &record = allMetricsArray[j];
+			correctTimestamps(record, clockExchange.clock(j).offsetAt(record.sampleRealTime), clockExchange.clock(j).drift());
+			mergeMetrics(latestMetrics[j], record);
+			if(allMetricsArray[j].jitter > worstJitter){
+				worstJitter = allMetricsArray[j].jitter;
+				worstJitterNode = j;
+			}
+		}
+		if(columnar) columnarWriter.write(latestMetrics);
 		else {
-			allMetricsArray[0] = allMetrics;
-			for(int j = 1; j < clusterSize; j++)
-				MPI_Recv(&allMetricsArray[j], 1, allMetricsType, j, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			line.clear();
+			appendMetricsLine(line, allMetricsArray, clusterSize);
+			resultWriter.write(line);
+		}
+
+		displayCost.cpuTime += sampleCosts[slot].cpuTime;
+		if(tickTimes[slot] < nextDisplay) return;
+		while(nextDisplay <= tickTimes[slot]) nextDisplay += uint64_t(samplingPeriod) * 1000000;
+
+		for(int j = 0; j < clusterSize; j++){
+			std::cout << "\n\t[NODE " << j << " METRICS]\n\n";
+			printMetrics(&latestMetrics[j].systemMetrics, &latestMetrics[j].processorMetrics, \
+					&latestMetrics[j].inputOutputMetrics, &latestMetrics[j].processMetrics, &latestMetrics[j].memoryMetrics, \
+					&latestMetrics[j].networkMetrics, &latestMetrics[j].powerMetrics, &latestMetrics[j].pressureMetrics, \
+					&latestMetrics[j].jobMetrics);
+		}
+		std::cout << "\n\t[INFO] Sample cost on node 0: " << displayCost.cpuTime << " ms of CPU time\n";
+		std::cout << "\t[INFO] Worst tick jitter: " << worstJitter / 1000 << " us on node " << worstJitterNode << "\n";
+		displayCost = {0};
+		worstJitter = 0;
+	};
+
+	if(launched && (!launchOnRoot || !rank)){
+		if(launcher.start(launchCommand)) setTargetProcess(launcher.processID());
+		else std::cerr << "\n\t[ERROR] Node " << rank << ": unable to start " << launchCommand[0] << "\n";
+	}
+
+	// The first round of clock probes is waited for, so even the first records have their timestamps corrected
+	clockExchange.open();
+	clockExchange.round();
+
+	// The first snapshot only opens the interval of the first sample of every collector. It is taken
+	// at the common epoch, so every node samples at the same instants without a barrier per sample.
+	int64_t epoch = waitForCommonEpoch();
+	takeSnapshot();
+	SamplingScheduler scheduler;
+	if(!scheduler.open(periods, METRIC_GROUPS, epoch)){
+		std::cerr << "\n\t[ERROR] Node " << rank << ": unable to create the sampling timers\n";
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	uint64_t runTime = uint64_t(iterations) * samplingPeriod * 1000000;
+
+	// Every tick samples the collectors that are due and ships only their sections, for --iterations
+	// sampling periods or until the launched command ended on every node
+	int samples = 0;
+	for(int i = 0; ; i++){
+
+		int slot = i % 2;
+		uint32_t tick = sleepWhileGathering(scheduler, sampleRequests[1 - slot], 2, clockExchange);
+		sendSlots[slot].sampleRealTime = realTime();
+		sendSlots[slot].sampleMonotonicTime = monotonicTime();
+		sendSlots[slot].deadline = scheduler.tickTime();
+		sendSlots[slot].jitter = sendSlots[slot].sampleRealTime - sendSlots[slot].deadline;
+		tickTimes[slot] = sendSlots[slot].deadline - epoch;
+
+		SamplingCost costBefore = getSamplingCost();
+		getAllMetrics(sendSlots[slot], tick);
+		SamplingCost costAfter = getSamplingCost();
+		sampleCosts[slot].cpuTime = costAfter.cpuTime - costBefore.cpuTime;
+
+		if(recordTypes[tick] == MPI_DATATYPE_NULL) recordTypes[tick] = createMpiAllMetricsType(tick, clusterCpus);
+		localStatus[slot][0] = launcher.isRunning();
+		localStatus[slot][1] = stopRequested;
+		MPI_Igather(&sendSlots[slot], 1, recordTypes[tick], receiveSlots[slot], 1, recordTypes[tick], 0, MPI_COMM_WORLD, &sampleRequests[slot][0]);
+		MPI_Iallreduce(localStatus[slot], clusterStatus[slot], 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD, &sampleRequests[slot][1]);
+		samples++;
+
+		// The previous record had a whole tick to arrive, the one just taken still covers the exit
+		if(i){
+			finishSample(1 - slot);
+			if(clusterStatus[1 - slot][1] || (launched && !clusterStatus[1 - slot][0])) break;
+		}
+		if(!launched && tickTimes[slot] >= runTime) break;
+
+		// The ticks are the same on every node, so all of them start the same rounds. A round starts
+		// after the root saved the previous record, so the root answers the probes right away.
+		if(tickTimes[slot] >= nextClockSync){
+			clockExchange.start();
+			while(nextClockSync <= tickTimes[slot]) nextClockSync += uint64_t(CLOCK_SYNC_PERIOD) * 1000000;
+		}
+	}
+	if(samples > 0) finishSample((samples - 1) % 2);
+	clockExchange.close();
+
+	// A command that outlived the monitoring is terminated, then every node reports how its run went
+	if(launched){
+		launcher.stop();
+
+		MPI_Datatype launchRecordType = createMpiLaunchRecordType();
+		LaunchRecord* launchRecords = rank ? nullptr : new LaunchRecord[clusterSize];
+		MPI_Gather(&launcher.record(), 1, launchRecordType, launchRecords, 1, launchRecordType, 0, MPI_COMM_WORLD);
+		MPI_Type_free(&launchRecordType);
+
+		if(!rank){
+			std::string command = launchCommand[0];
+			for(char** argument = launchCommand + 1; *argument; argument++) command += ' ' + std::string(*argument);
+
+			line.clear();
+			appendLaunchLine(line, command, launchRecords, clusterSize);
+			// The columnar file only holds samples, the launch goes next to it
+			if(columnar){
+				resultWriter.open(fileName + ".launch.ndjson");
+				resultWriter.write(line);
+			}
+			else resultWriter.write(line);
+
 			for(int j = 0; j < clusterSize; j++){
-				std::cout << "\n\t[NODE " << j << " METRICS]\n\n";
-				printMetrics(&allMetricsArray[j].systemMetrics, &allMetricsArray[j].processorMetrics, \
-						&allMetricsArray[j].inputOutputMetrics, &allMetricsArray[j].memoryMetrics, \
-						&allMetricsArray[j].networkMetrics, &allMetricsArray[j].powerMetrics);
+				if(launchRecords[j].processID < 0) continue;
+				std::cout << "\n\t[INFO] Node " << j << ": " << command << " ended after "
+					<< (launchRecords[j].endTime - launchRecords[j].startTime) / 1000000 << " ms with ";
+				if(launchRecords[j].exitSignal) std::cout << "signal " << launchRecords[j].exitSignal << "\n";
+				else std::cout << "exit code " << launchRecords[j].exitCode << "\n";
 			}
-			jsonArray.push_back(metricsToJson(allMetricsArray,clusterSize));
 		}
+		delete[] launchRecords;
 	}
 
-	// Save metrics to file
-	if(!rank) outputFile << jsonArray.dump(4);
-	
-	outputFile.close();
-	MPI_Type_free(&systemMetricsType);
-	MPI_Type_free(&processorMetricsType);
-	MPI_Type_free(&inputOutputMetricsType);
-	MPI_Type_free(&memoryMetricsType);
-	MPI_Type_free(&networkMetricsType);
-	MPI_Type_free(&powerMetricsType);
-	MPI_Type_free(&allMetricsType);
-	delete[] allMetricsArray;
+	resultWriter.close();
+	columnarWriter.close();
+	for(MPI_Datatype &type : recordTypes)
+		if(type != MPI_DATATYPE_NULL) MPI_Type_free(&type);
+	for(AllMetrics* slot : receiveSlots) delete[] slot;
+	delete[] latestMetrics;
    	MPI_Finalize();
 	return 0;
 };
\ No newline at end of file
@@ -0,0 +1,155 @@
+//
+// 	meter-simulator.cpp - stand-in for a Yokogawa WT power meter answering its remote control commands
+//
+// 	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// Listens on a TCP port, or on a pseudo terminal with --serial, and answers *IDN? and
+// :NUMERIC:NORMAL:VALUE? like a WT310E measuring a load that swings around a mean power.
+// Other commands are accepted and ignored. The energy of the load since the start is printed on
+// exit (Ctrl+C), so it can be compared with what measure-performance integrated.
+//
+// g++ -std=c++2a -O2 meter-simulator.cpp -o meter-simulator -lutil
+// meter-simulator [--port 10001] [--serial] [--power 250] [--swing 50] [--cycle 10]
+// measure-performance --power-meter localhost:10001
+//
+
+// External libraries
+#include <iostream>		// cout, cerr
+#include <string>		// string, stod
+#include <cstring>		// strcmp
+#include <cstdio>		// snprintf
+#include <cmath>		// sin, cos, M_PI
+#include <csignal>		// signal, SIGINT, SIGTERM
+#include <ctime>		// clock_gettime
+#include <netinet/in.h>		// sockaddr_in, INADDR_ANY
+#include <sys/socket.h>		// socket, bind, listen, accept
+#include <pty.h>		// openpty
+#include <termios.h>		// cfmakeraw
+#include <unistd.h>		// read, write, close, fork
+
+static volatile sig_atomic_t stopRequested = 0;
+static double meanPower = 250, swingPower = 50, cyclePeriod = 10;	// W, W, s
+static timespec startTime;
+
+static void requestStop(int){
+	stopRequested = 1;
+};
+
+static double elapsedTime(){
+
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - startTime.tv_sec) + (now.tv_nsec - startTime.tv_nsec) / 1e9;
+};
+
+// The load is a sine, so its exact energy is known for any interval
+static double power(double time){
+	return meanPower + swingPower * sin(2 * M_PI * time / cyclePeriod);
+};
+
+static double energy(double time){
+	return meanPower * time + swingPower * cyclePeriod / (2 * M_PI) * (1 - cos(2 * M_PI * time / cyclePeriod));
+};
+
+static std::string answer(const std::string &command){
+
+	char value[32];
+	if(command == "*IDN?") return "YOKOGAWA,WT310E,SIMULATED,F1.00";
+	if(command == ":NUMERIC:NORMAL:VALUE?" || command == ":NUM:VAL?"){
+		snprintf(value, sizeof(value), "%+.4E", power(elapsedTime()));
+		return value;
+	}
+	if(!command.empty() && command.back() == '?') return "0";
+	return "";
+};
+
+// Answers the commands of one connection until it is closed
+static void serve(int descriptor){
+
+	std::string received;
+	char buffer[256];
+	ssize_t length;
+	while(!stopRequested && (length = read(descriptor, buffer, sizeof(buffer))) > 0){
+		received.append(buffer, length);
+		size_t end;
+		while((end = received.find('\n')) != std::string::npos){
+			std::string command = received.substr(0, end);
+			received.erase(0, end + 1);
+			if(!command.empty() && command.back() == '\r') command.pop_back();
+			std::string reply = answer(command);
+			if(reply.empty()) continue;
+			reply += '\n';
+			if(write(descriptor, reply.data(), reply.size()) < 0) return;
+		}
+	}
+};
+
+int main(int argc, char **argv){
+
+	int port = 10001;
+	bool serial = false;
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "--serial")) serial = true;
+		else if(i == argc - 1) break;
+		else if(!strcmp(argv[i], "--port")) port = std::stoi(argv[++i]);
+		else if(!strcmp(argv[i], "--power")) meanPower = std::stod(argv[++i]);
+		else if(!strcmp(argv[i], "--swing")) swingPower = std::stod(argv[++i]);
+		else if(!strcmp(argv[i], "--cycle")) cyclePeriod = std::stod(argv[++i]);
+	}
+
+	// No SA_RESTART, so a blocked read() or accept() returns on Ctrl+C
+	struct sigaction action = {};
+	action.sa_handler = requestStop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+	if(serial){
+		int controller, device;
+		char name[64];
+		if(openpty(&controller, &device, name, nullptr, nullptr)){
+			std::cerr << "\n\t[ERROR] Unable to open a pseudo terminal.\n";
+			return 1;
+		}
+		termios settings;
+		tcgetattr(controller, &settings);
+		cfmakeraw(&settings);
+		tcsetattr(controller, TCSANOW, &settings);
+		std::cout << "Serial meter on " << name << std::endl;
+		serve(controller);
+		close(device);
+		close(controller);
+	}
+	else {
+		int listener = socket(AF_INET, SOCK_STREAM, 0), reuse = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+		if(bind(listener, (sockaddr*)&address, sizeof(address)) || listen(listener, 4)){
+			std::cerr << "\n\t[ERROR] Unable to listen on port " << port << ".\n";
+			return 1;
+		}
+		std::cout << "Meter listening on port " << port << std::endl;
+		// Every connection gets a process of its own, so every rank on a test machine can have a meter
+		signal(SIGCHLD, SIG_IGN);
+		while(!stopRequested){
+			int connection = accept(listener, nullptr, nullptr);
+			if(connection < 0) continue;
+			if(!fork()){
+				close(listener);
+				serve(connection);
+				_exit(0);
+			}
+			close(connection);
+		}
+		close(listener);
+	}
+
+	double time = elapsedTime();
+	std::cout << "\n" << time << " s, " << energy(time) << " J, " << energy(time) / time << " W on average\n";
+	return 0;
+};
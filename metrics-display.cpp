@@ -11,12 +11,15 @@
 #include <string>	// string, to_string
 #include <chrono>	// system_clock, put_time, now
 #include <iomanip>	// setw, setprecision
+#include <vector>	// vector
+#include <algorithm>	// sort, min, max
+#include <cstring>	// strnlen
 // Internal headers
 #include "metrics.h"
 #include "metrics-display.h"
 
-void printMetricPair(std::string metricName, int metricValue, std::string metricUnit, 
-			std::string metricNameTwo, int metricValueTwo, std::string metricUnitTwo){
+void printMetricPair(std::string metricName, long long metricValue, std::string metricUnit, 
+			std::string metricNameTwo, long long metricValueTwo, std::string metricUnitTwo){
 
 	std::string value = std::to_string(metricValue), value2 = std::to_string(metricValueTwo);
 
@@ -29,7 +32,7 @@ void printMetricPair(std::string metricName, int metricValue, std::string metric
 };
 
 // This function prints the second metric as float value
-void printMetricPairFloat(std::string metricName, int metricValue, std::string metricUnit, 
+void printMetricPairFloat(std::string metricName, long long metricValue, std::string metricUnit, 
 			std::string metricNameTwo, float metricValueTwo, std::string metricUnitTwo){
 
 	std::string value = std::to_string(metricValue), value2 = std::to_string(metricValueTwo);
@@ -43,8 +46,9 @@ void printMetricPairFloat(std::string metricName, int metricValue, std::string m
 };
 
 void printMetrics(SystemMetrics* systemMetrics, ProcessorMetrics* processorMetrics, 
-			InputOutputMetrics* inputOutputMetrics, MemoryMetrics* memoryMetrics, 
-			NetworkMetrics* networkMetrics, PowerMetrics* powerMetrics){
+			InputOutputMetrics* inputOutputMetrics, ProcessMetrics* processMetrics, MemoryMetrics* memoryMetrics, 
+			NetworkMetrics* networkMetrics, PowerMetrics* powerMetrics, PressureMetrics* pressureMetrics,
+			JobMetrics* jobMetrics){
 
 	auto now = std::chrono::system_clock::now();
   	std::time_t now_c = std::chrono::system_clock::to_time_t(now);
@@ -64,23 +68,148 @@ void printMetrics(SystemMetrics* systemMetrics, ProcessorMetrics* processorMetri
 	for(int i = 0; i < 43; i++) std::cout << ' ';
 
 	std::cout << "Processor:\n";
-	printMetricPair("Memory Used", memoryMetrics->memoryUsed, "MB", "Time User", processorMetrics->timeUser, "USER_HZ");
-	printMetricPair("Memory Cached", memoryMetrics->memoryCached, "MB", "Time System", processorMetrics->timeSystem, "USER_HZ");
-	printMetricPair("Swap Used", memoryMetrics->swapUsed, "MB", "Time Idle", processorMetrics->timeIdle, "USER_HZ");
-	printMetricPair("Swap Cached", memoryMetrics->swapCached, "MB", "Time I/O Wait", processorMetrics->timeIoWait, "USER_HZ");
-	printMetricPair("Memory Active", memoryMetrics->memoryActive, "MB", "Time IRQ", processorMetrics->timeIRQ, "USER_HZ");
-	printMetricPair("Memory Inactive", memoryMetrics->memoryInactive, "MB", "Time Steal", processorMetrics->timeSteal, "USER_HZ");
-	printMetricPairFloat("Pages Read", memoryMetrics->pageInRate, "pages/s", "LLC Store Misses", processorMetrics->cacheLLCStoreMissRate, "%");
-	printMetricPairFloat("Pages Saved", memoryMetrics->pageOutRate, "pages/s", "LLC Load Misses", processorMetrics->cacheLLCLoadMissRate, "%");
+	printMetricPair("Memory Used", memoryMetrics->memoryUsed, "MB", "Time User", processorMetrics->timeUser, "%");
+	printMetricPair("Memory Cached", memoryMetrics->memoryCached, "MB", "Time System", processorMetrics->timeSystem, "%");
+	printMetricPair("Swap Used", memoryMetrics->swapUsed, "MB", "Time Idle", processorMetrics->timeIdle, "%");
+	printMetricPair("Swap Cached", memoryMetrics->swapCached, "MB", "Time I/O Wait", processorMetrics->timeIoWait, "%");
+	printMetricPair("Memory Active", memoryMetrics->memoryActive, "MB", "Time IRQ", processorMetrics->timeIRQ, "%");
+	printMetricPair("Memory Inactive", memoryMetrics->memoryInactive, "MB", "Time Steal", processorMetrics->timeSteal, "%");
+	printMetricPairFloat("Paged In", memoryMetrics->pageInRate, "kB/s", "LLC Store Misses", processorMetrics->cacheLLCStoreMissRate, "%");
+	printMetricPairFloat("Paged Out", memoryMetrics->pageOutRate, "kB/s", "LLC Load Misses", processorMetrics->cacheLLCLoadMissRate, "%");
 	std::cout << std::endl;
 
-	std::cout << "I/O for PID 1:";
-	for(int i = 0; i < 36; i++) std::cout << ' ';
+	std::cout << "Memory Pressure:\n";
+	printMetricPairFloat("Page Faults", memoryMetrics->pageFaultRate, "/s", "Major Page Faults", memoryMetrics->pageFaultsMajorRate, "/s");
+	printMetricPairFloat("THP Faults", memoryMetrics->thpFaultRate, "/s", "THP Fallbacks", memoryMetrics->thpFallbackRate, "/s");
+	printMetricPairFloat("Compaction Stalls", memoryMetrics->compactionStallRate, "/s", "Compaction Fails", memoryMetrics->compactionFailRate, "/s");
+	printMetricPairFloat("NUMA Hint Faults", memoryMetrics->numaHintFaultRate, "/s", "NUMA Migrations", memoryMetrics->numaMigrationRate, "/s");
+	std::cout << std::endl;
+
+	std::cout << "Processor Cores:\n";
+	printMetricPairFloat("Busiest CPU", processorMetrics->cpuBusyMax, "%", "Busiest Core", processorMetrics->coreBusyMax, "%");
+	printMetricPairFloat("Least Busy CPU", processorMetrics->cpuBusyMin, "%", "Least Busy Core", processorMetrics->coreBusyMin, "%");
+	printMetricPairFloat("CPUs", processorMetrics->cpus, "", "Busy Deviation", processorMetrics->cpuBusyDeviation, "%");
+	// Hottest CPUs on the left, coldest on the right
+	std::vector<const CpuMetrics*> cpus;
+	for(int i = 0; i < processorMetrics->cpus; i++)
+		if(processorMetrics->cpuMetrics[i].busy >= 0) cpus.push_back(&processorMetrics->cpuMetrics[i]);
+	std::sort(cpus.begin(), cpus.end(), [](const CpuMetrics* a, const CpuMetrics* b){ return a->busy > b->busy; });
+	for(int i = 0; i < std::min<int>(DISPLAY_CORES, cpus.size() / 2); i++){
+		const CpuMetrics &hot = *cpus[i], &cold = *cpus[cpus.size() - 1 - i];
+		printMetricPairFloat("CPU " + std::to_string(hot.cpu) + " (core " + std::to_string(hot.core) + ")", hot.busy, "%",
+			"CPU " + std::to_string(cold.cpu) + " (core " + std::to_string(cold.core) + ")", cold.busy, "%");
+	}
+	int sockets = std::min(processorMetrics->sockets, TOPOLOGY_MAX_SOCKETS), nodes = std::min(processorMetrics->numaNodes, TOPOLOGY_MAX_NODES);
+	for(int i = 0; i < std::max(sockets, nodes); i++)
+		printMetricPairFloat("Socket " + std::to_string(i), i < sockets ? processorMetrics->socketBusy[i] : -1, "%",
+			"NUMA Node " + std::to_string(i), i < nodes ? processorMetrics->nodeBusy[i] : -1, "%");
+	printMetricPairFloat("Frequency", processorMetrics->frequencyMean, "MHz", "Effective Frequency", processorMetrics->effectiveFrequency, "MHz");
+	printMetricPairFloat("Slowest CPU", processorMetrics->frequencyMin, "MHz", "Fastest CPU", processorMetrics->frequencyMax, "MHz");
+	printMetricPairFloat("Core Throttled", processorMetrics->coreThrottleTime, "%", "Package Throttled", processorMetrics->packageThrottleTime, "%");
+	// Two idle states per line, shallowest first
+	for(int i = 0; i < processorMetrics->idleStates; i += 2){
+		const char* left = processorMetrics->idleStateNames[i];
+		const char* right = i + 1 < processorMetrics->idleStates ? processorMetrics->idleStateNames[i + 1] : "";
+		printMetricPairFloat("Idle " + std::string(left, strnlen(left, IDLE_NAME_LENGTH)), processorMetrics->idleStateResidency[i], "%",
+			"Idle " + std::string(right, strnlen(right, IDLE_NAME_LENGTH)), *right ? processorMetrics->idleStateResidency[i + 1] : -1, "%");
+	}
+	std::cout << std::endl;
+
+	std::cout << "Interrupts:\n";
+	printMetricPairFloat("IRQ Rate", systemMetrics->interruptRate, "/s", "Softirq Rate", systemMetrics->softInterruptRate, "/s");
+	printMetricPairFloat("Busiest IRQ CPU", systemMetrics->interruptCpu, "", "Its IRQ Rate", systemMetrics->interruptCpuRate, "/s");
+	printMetricPairFloat("Busiest Softirq CPU", systemMetrics->softInterruptCpu, "", "Its Softirq Rate", systemMetrics->softInterruptCpuRate, "/s");
+	// IRQs on the left, softirqs on the right, both busiest first
+	for(int i = 0; i < std::min(DISPLAY_INTERRUPTS, std::max(systemMetrics->topInterrupts, systemMetrics->topSoftInterrupts)); i++){
+		const InterruptMetrics &hard = systemMetrics->interruptMetrics[i], &soft = systemMetrics->softInterruptMetrics[i];
+		printMetricPairFloat("IRQ " + std::string(hard.name) + " on CPU " + std::to_string(hard.cpu), hard.rate, "/s",
+			std::string(soft.name) + " on CPU " + std::to_string(soft.cpu), soft.rate, "/s");
+	}
+	std::cout << std::endl;
+
+	std::string processTitle = "Process tree of PID " + std::to_string(processMetrics->processID) + ":";
+	std::cout << processTitle;
+	for(int i = processTitle.length(); i < 50; i++) std::cout << ' ';
+	std::cout << '\n';
+	printMetricPairFloat("Processes", processMetrics->processes, "", "CPU Usage", processMetrics->cpuUsage, "%");
+	printMetricPairFloat("Threads", processMetrics->threads, "", "Resident Memory", processMetrics->memoryResident, "MB");
+	printMetricPair("Context Switch Rate", processMetrics->contextSwitchRate, "/s", "CPU Time", processMetrics->cpuTime, "ms");
+	std::cout << std::endl;
+
+	std::string inputOutputTitle = "I/O for PID " + std::to_string(inputOutputMetrics->processID) + ":";
+	std::cout << inputOutputTitle;
+	for(int i = inputOutputTitle.length(); i < 50; i++) std::cout << ' ';
 
 	std::cout << "Power:\n";
-	printMetricPairFloat("Data Read ", inputOutputMetrics->dataRead, "MB", "Processor Power", powerMetrics->processorPower, "W");
-	printMetricPairFloat("Data Written ", inputOutputMetrics->dataWritten, "MB", "System Power", powerMetrics->systemPower, "W");
+	printMetricPairFloat("Data Read ", inputOutputMetrics->dataReadRate, "MB/s", "Processor Power", powerMetrics->processorPower, "W");
+	printMetricPairFloat("Data Written ", inputOutputMetrics->dataWrittenRate, "MB/s", "System Power", powerMetrics->systemPower, "W");
 	printMetricPairFloat("Read Operations ", inputOutputMetrics->readOperationsRate, "/s", "Memory Power", powerMetrics->memoryPower, "W");
 	printMetricPairFloat("Write Operations ", inputOutputMetrics->writeOperationsRate, "/s", "GPU Power", powerMetrics->gpuPower, "W");
+	if(powerMetrics->meterSamples > 0)
+		printMetricPairFloat("Wall Power", powerMetrics->meterPower, "W", "Wall Peak Power", powerMetrics->meterPeakPower, "W");
+	std::cout << std::endl;
+
+	if(powerMetrics->gpus > 0){
+		std::cout << "GPUs:\n";
+		for(int i = 0; i < powerMetrics->gpus; i++){
+			const GpuDeviceMetrics &gpu = powerMetrics->gpuMetrics[i];
+			std::string name = "GPU " + std::to_string(i);
+			printMetricPairFloat(name + " Power", gpu.power, "W", name + " Temperature", gpu.temperature, "C");
+			printMetricPairFloat(name + " Utilization", gpu.utilization, "%", name + " Memory Used", gpu.memoryUsed, "MB");
+			printMetricPairFloat(name + " SM Clock", gpu.clocksSM, "MHz", name + " Memory Clock", gpu.clocksMemory, "MHz");
+		}
+		std::cout << std::endl;
+	}
+
+	std::cout << "Pressure:\n";
+	printMetricPairFloat("CPU Some Stall", pressureMetrics->system[PRESSURE_CPU].someStallRatio, "%", "CPU Some avg10", pressureMetrics->system[PRESSURE_CPU].someAvg10, "%");
+	printMetricPairFloat("Memory Some Stall", pressureMetrics->system[PRESSURE_MEMORY].someStallRatio, "%", "Memory Full Stall", pressureMetrics->system[PRESSURE_MEMORY].fullStallRatio, "%");
+	printMetricPairFloat("I/O Some Stall", pressureMetrics->system[PRESSURE_IO].someStallRatio, "%", "I/O Full Stall", pressureMetrics->system[PRESSURE_IO].fullStallRatio, "%");
+	printMetricPairFloat("Cgroup CPU Stall", pressureMetrics->cgroup[PRESSURE_CPU].someStallRatio, "%", "Cgroup Memory Stall", pressureMetrics->cgroup[PRESSURE_MEMORY].someStallRatio, "%");
+	printMetricPairFloat("Trigger Events", pressureMetrics->triggerEvents, "", "First Trigger", pressureMetrics->firstTriggerDelay, "ms");
+	std::cout << std::endl;
+
+	std::cout << "Job cgroup " << jobMetrics->cgroup << ":\n";
+	printMetricPairFloat("CPU Usage", jobMetrics->cpuUsage, "%", "Share of Node CPU", jobMetrics->cpuShare, "%");
+	printMetricPairFloat("Memory", jobMetrics->memoryCurrent, "MB", "Attributed Power", jobMetrics->power, "W");
+	printMetricPairFloat("Data Read", jobMetrics->dataReadRate, "MB/s", "Data Written", jobMetrics->dataWrittenRate, "MB/s");
+	printMetricPairFloat("Throttled Time", jobMetrics->throttledTime, "ms/s", "Major Faults", jobMetrics->majorFaultRate, "/s");
+	std::cout << std::endl;
+
+	std::cout << "Block Devices:\n";
+	printMetricPairFloat("Disk Reads", inputOutputMetrics->diskReadRate, "/s", "Disk Data Read", inputOutputMetrics->diskDataReadRate, "MB/s");
+	printMetricPairFloat("Disk Writes", inputOutputMetrics->diskWriteRate, "/s", "Disk Data Written", inputOutputMetrics->diskDataWrittenRate, "MB/s");
+	printMetricPairFloat("Busiest Device", inputOutputMetrics->diskUtilization, "%", "Disk Read Time", inputOutputMetrics->diskReadTime, "ms");
+	for(int i = 0; i < inputOutputMetrics->devices; i++){
+		const BlockDeviceMetrics &device = inputOutputMetrics->deviceMetrics[i];
+		std::string name = device.name;
+		printMetricPairFloat(name + " Reads", device.readRate, "/s", name + " Data Read", device.dataReadRate, "MB/s");
+		printMetricPairFloat(name + " Writes", device.writeRate, "/s", name + " Data Written", device.dataWrittenRate, "MB/s");
+		printMetricPairFloat(name + " Utilization", device.utilization, "%", name + " Queue Depth", device.queueDepth, "");
+	}
+	std::cout << std::endl;
+
+	std::cout << "Network Interfaces:\n";
+	printMetricPairFloat("TCP Retransmits", networkMetrics->tcpRetransmitRate, "/s", "TCP Retransmit Ratio", networkMetrics->tcpRetransmitRatio, "%");
+	printMetricPairFloat("Dropped Packets", networkMetrics->dropRate, "/s", "UDP Errors", networkMetrics->udpErrorRate, "/s");
+	for(int i = 0; i < networkMetrics->interfaces; i++){
+		const NetworkInterfaceMetrics &interface = networkMetrics->interfaceMetrics[i];
+		std::string name = interface.name;
+		printMetricPairFloat(name + " Received", interface.receivePacketRate, "packets/s", name + " Received", interface.receiveRate, "KB/s");
+		printMetricPairFloat(name + " Sent", interface.sendPacketRate, "packets/s", name + " Sent", interface.sendRate, "KB/s");
+		printMetricPair(name + " Drops", interface.receiveDropRate + interface.sendDropRate, "/s", name + " Errors", interface.receiveErrorRate + interface.sendErrorRate, "/s");
+	}
+	if(networkMetrics->infinibandPorts > 0)
+		printMetricPairFloat("InfiniBand Received", networkMetrics->infinibandReceiveRate, "KB/s", "InfiniBand Sent", networkMetrics->infinibandTransmitRate, "KB/s");
+	for(int i = 0; i < networkMetrics->infinibandPorts; i++){
+		const InfinibandPortMetrics &port = networkMetrics->infinibandMetrics[i];
+		std::string name = port.name;
+		printMetricPairFloat(name + " Received", port.receivePacketRate, "packets/s", name + " Received", port.receiveRate, "KB/s");
+		printMetricPairFloat(name + " Sent", port.transmitPacketRate, "packets/s", name + " Sent", port.transmitRate, "KB/s");
+		printMetricPairFloat(name + " Utilization", port.utilization, "%", name + " Wait", port.waitRate, "ticks/s");
+		printMetricPair(name + " Link Errors", port.linkErrors, "", name + " Receive Errors", port.receiveErrors, "");
+		printMetricPair(name + " Discards", port.transmitDiscards, "", name + " Transport Errors", port.transportErrors, "");
+		printMetricPair(name + " Out Of Buffer", port.outOfBuffer, "", name + " Saturated", port.saturatedCounters, "counters");
+	}
 	std::cout << std::endl;
 };
@@ -12,9 +12,13 @@
 // Internal headers
 #include "metrics.h"
 
+#define DISPLAY_CORES 3				// Hottest and coldest CPUs listed under Processor Cores
+#define DISPLAY_INTERRUPTS 3			// Busiest IRQ/CPU and softirq/CPU pairs listed under Interrupts
+
 // Printing for the user
-void printMetricPair(std::string, int, std::string, std::string, int, std::string);
-void printMetrics(SystemMetrics*, ProcessorMetrics*, InputOutputMetrics*, 
-			MemoryMetrics*, NetworkMetrics*, PowerMetrics*);
+// Counters are passed as long long, so a missing one (COUNTER_MISSING) is shown as -1
+void printMetricPair(std::string, long long, std::string, std::string, long long, std::string);
+void printMetrics(SystemMetrics*, ProcessorMetrics*, InputOutputMetrics*, ProcessMetrics*,
+			MemoryMetrics*, NetworkMetrics*, PowerMetrics*, PressureMetrics*, JobMetrics*);
 
 #endif
\ No newline at end of file
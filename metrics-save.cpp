@@ -7,131 +7,1086 @@
 //
 
 // External libraries
-#include <chrono>	// system_clock, put_time, now
-#include <sstream>	// stringstream
-#include "json.hpp"	// json
+#include <charconv>	// to_chars
+#include <cmath>	// isfinite
+#include <cstring>	// memcpy, strncpy
+#include <cstddef>	// offsetof
+#include <algorithm>	// fill, min
+#include <string_view>	// string_view
+#include <cstdio>	// snprintf
+#include <type_traits>	// is_array_v, remove_reference_t
 // Internal headers
 #include "metrics.h"
 #include "metrics-save.h"
 
-using json = nlohmann::json;
+// Every value is followed by a comma, appendObjectEnd() replaces the last one with the closing bracket
+static void appendKey(std::string &line, const char* key){
+	line += '"';
+	line += key;
+	line += "\":";
+};
 
-json metricsToJson(AllMetrics* allMetricsArray, int clusterSize){
-	
-	json jsonToReturn;
-	auto now = std::chrono::system_clock::now();
-  	std::time_t now_c = std::chrono::system_clock::to_time_t(now);
+static void appendObjectStart(std::string &line, const char* key){
+	appendKey(line, key);
+	line += '{';
+};
 
-	std::stringstream ss;
-	ss << std::put_time(std::localtime(&now_c), "%Y-%m-%d %X");
+static void appendObjectEnd(std::string &line){
+	if(line.back() == ',') line.back() = '}';
+	else line += '}';
+	line += ',';
+};
 
-	json nodesInformation = json::array(), singleNode;
-	AllMetrics allMetrics;
+static void appendValue(std::string &line, double value){
+	// JSON has no NaN or infinity
+	if(!std::isfinite(value)){
+		line += "null,";
+		return;
+	}
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	line.append(buffer, result.ptr);
+	line += ',';
+};
+
+static void appendValue(std::string &line, float value){
+	if(!std::isfinite(value)){
+		line += "null,";
+		return;
+	}
+	// Shortest form of the float itself, so 6.28 is not written as 6.28000020980835
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	line.append(buffer, result.ptr);
+	line += ',';
+};
+
+static void appendValue(std::string &line, long long value){
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	line.append(buffer, result.ptr);
+	line += ',';
+};
+
+static void appendValue(std::string &line, std::string_view value){
+
+	line += '"';
+	for(char character : value){
+		if(character == '"' || character == '\\'){
+			line += '\\';
+			line += character;
+		}
+		else if((unsigned char)character < 0x20){
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+			line += escaped;
+		}
+		else line += character;
+	}
+	line += "\",";
+};
+
+static void appendNumber(std::string &line, const char* key, double value){
+	appendKey(line, key);
+	appendValue(line, value);
+};
+
+static void appendNumber(std::string &line, const char* key, float value){
+	appendKey(line, key);
+	appendValue(line, value);
+};
+
+static void appendNumber(std::string &line, const char* key, int value){
+	appendKey(line, key);
+	appendValue(line, (long long)value);
+};
+
+static void appendNumber(std::string &line, const char* key, int64_t value){
+	appendKey(line, key);
+	appendValue(line, (long long)value);
+};
+
+// Counters that could not be read are saved as null, so they never look like a real value
+static void appendCounter(std::string &line, const char* key, uint64_t counter){
+	appendKey(line, key);
+	if(counter == COUNTER_MISSING){
+		line += "null,";
+		return;
+	}
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), counter);
+	line.append(buffer, result.ptr);
+	line += ',';
+};
+
+// Fixed size name fields are not always terminated when they are full
+static void appendText(std::string &line, const char* key, const char* text, size_t size){
+	appendKey(line, key);
+	appendValue(line, std::string_view(text, strnlen(text, size)));
+};
+
+static void appendArrayStart(std::string &line, const char* key){
+	appendKey(line, key);
+	line += '[';
+};
+
+static void appendArrayEnd(std::string &line){
+	if(line.back() == ',') line.back() = ']';
+	else line += ']';
+	line += ',';
+};
+
+static void appendArray(std::string &line, const char* key, const float* values, int count){
+	appendArrayStart(line, key);
+	for(int i = 0; i < count; i++) appendValue(line, values[i]);
+	appendArrayEnd(line);
+};
+
+// "cpu", "memory" and "io" objects of one group of pressure files
+static void appendPressure(std::string &line, const char* key, const PressureResourceMetrics* resources){
+
+	const char* names[PRESSURE_RESOURCES] = {"cpu", "memory", "io"};
+	appendObjectStart(line, key);
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		appendObjectStart(line, names[i]);
+		appendNumber(line, "someAvg10", resources[i].someAvg10);
+		appendNumber(line, "fullAvg10", resources[i].fullAvg10);
+		appendCounter(line, "someTotal", resources[i].someTotal);
+		appendCounter(line, "fullTotal", resources[i].fullTotal);
+		appendNumber(line, "someStall", resources[i].someStall);
+		appendNumber(line, "fullStall", resources[i].fullStall);
+		appendNumber(line, "someStallRatio", resources[i].someStallRatio);
+		appendNumber(line, "fullStallRatio", resources[i].fullStallRatio);
+		appendObjectEnd(line);
+	}
+	appendObjectEnd(line);
+};
+
+// Busiest IRQ/CPU pairs of one kind, only the valid ones
+static void appendInterrupts(std::string &line, const char* key, const InterruptMetrics* interrupts, int count){
+
+	appendArrayStart(line, key);
+	for(int i = 0; i < count; i++){
+		line += '{';
+		appendText(line, "name", interrupts[i].name, sizeof(interrupts[i].name));
+		appendText(line, "device", interrupts[i].device, sizeof(interrupts[i].device));
+		appendNumber(line, "cpu", interrupts[i].cpu);
+		appendCounter(line, "count", interrupts[i].count);
+		appendNumber(line, "rate", interrupts[i].rate);
+		appendObjectEnd(line);
+	}
+	appendArrayEnd(line);
+};
+
+void appendMetricsLine(std::string &line, const AllMetrics* allMetricsArray, int clusterSize){
+
+	// The deadline of the tick, the same on every node and on the clock of rank 0
+	line += '{';
+	appendNumber(line, "timestamp", allMetricsArray[0].deadline);
+
+	appendKey(line, "Nodes");
+	line += '[';
 	for(int i = 0; i < clusterSize; i++){
-		allMetrics = allMetricsArray[i];
-
-		// create JSON objects for the sub-structures
-		json systemMetricsJSON = {
-			{"processesRunning", allMetrics.systemMetrics.processesRunning},
-			{"processesAll", allMetrics.systemMetrics.processesAll},
-			{"processesBlocked", allMetrics.systemMetrics.processesBlocked},
-			{"contextSwitchRate", allMetrics.systemMetrics.contextSwitchRate},
-			{"interruptRate", allMetrics.systemMetrics.interruptRate}
-		};
-
-		json processorMetricsJSON = {
-			{"timeUser", allMetrics.processorMetrics.timeUser},
-			{"timeNice", allMetrics.processorMetrics.timeNice},
-			{"timeSystem", allMetrics.processorMetrics.timeSystem},
-			{"timeIdle", allMetrics.processorMetrics.timeIdle},
-			{"timeIoWait", allMetrics.processorMetrics.timeIoWait},
-			{"timeIRQ", allMetrics.processorMetrics.timeIRQ},
-			{"timeSoftIRQ", allMetrics.processorMetrics.timeSoftIRQ},
-			{"timeSteal", allMetrics.processorMetrics.timeSteal},
-			{"timeGuest", allMetrics.processorMetrics.timeGuest},
-			{"instructionsRetired", allMetrics.processorMetrics.instructionsRetired},
-			{"cycles", allMetrics.processorMetrics.cycles},
-			{"frequencyRelative", allMetrics.processorMetrics.frequencyRelative},
-			{"unhaltedFrequency", allMetrics.processorMetrics.unhaltedFrequency},
-			{"cacheL2Misses", allMetrics.processorMetrics.cacheL2Misses},
-			{"cacheL2Requests", allMetrics.processorMetrics.cacheL2Requests},
-			{"cacheLLCLoadMisses", allMetrics.processorMetrics.cacheLLCLoadMisses},
-			{"cacheLLCLoadMissRate", allMetrics.processorMetrics.cacheLLCLoadMissRate},
-			{"cacheLLCLoads", allMetrics.processorMetrics.cacheLLCLoads},
-			{"cacheLLCStoreMisses", allMetrics.processorMetrics.cacheLLCStoreMisses},
-			{"cacheLLCStoreMissRate", allMetrics.processorMetrics.cacheLLCStoreMissRate},
-			{"cacheLLCStores", allMetrics.processorMetrics.cacheLLCStores}
-		};
-
-		json inputOutputMetricsJSON = {
-			{"processID", allMetrics.inputOutputMetrics.processID},
-			{"dataRead", allMetrics.inputOutputMetrics.dataRead},
-			{"readTime", allMetrics.inputOutputMetrics.readTime},
-			{"readOperationsRate", allMetrics.inputOutputMetrics.readOperationsRate},
-			{"dataWritten", allMetrics.inputOutputMetrics.dataWritten},
-			{"writeTime", allMetrics.inputOutputMetrics.writeTime},
-			{"writeOperationsRate", allMetrics.inputOutputMetrics.writeOperationsRate},
-			{"flushTime", allMetrics.inputOutputMetrics.flushTime},
-			{"flushOperationsRate", allMetrics.inputOutputMetrics.flushOperationsRate}
-		};
-
-		json memoryMetricsJSON = {
-			{"memoryUsed", allMetrics.memoryMetrics.memoryUsed},
-			{"memoryCached", allMetrics.memoryMetrics.memoryCached},
-			{"swapUsed", allMetrics.memoryMetrics.swapUsed},
-			{"swapCached", allMetrics.memoryMetrics.swapCached},
-			{"memoryActive", allMetrics.memoryMetrics.memoryActive},
-			{"memoryInactive", allMetrics.memoryMetrics.memoryInactive},
-			{"pageInRate", allMetrics.memoryMetrics.pageInRate},
-			{"pageOutRate", allMetrics.memoryMetrics.pageOutRate},
-			{"pageFaultRate", allMetrics.memoryMetrics.pageFaultRate},
-			{"pageFaultsMajorRate", allMetrics.memoryMetrics.pageFaultsMajorRate},
-			{"pageFreeRate", allMetrics.memoryMetrics.pageFreeRate},
-			{"pageActivateRate", allMetrics.memoryMetrics.pageActivateRate},
-			{"pageDeactivateRate", allMetrics.memoryMetrics.pageDeactivateRate},
-			{"memoryReadRate", allMetrics.memoryMetrics.memoryReadRate},
-			{"memoryWriteRate", allMetrics.memoryMetrics.memoryWriteRate},
-			{"memoryIoRate", allMetrics.memoryMetrics.memoryIoRate}
-		};
-
-		json networkMetricsJSON = {
-			{"receivedData", allMetrics.networkMetrics.receivedData},
-			{"receivePacketRate", allMetrics.networkMetrics.receivePacketRate},
-			{"sentData", allMetrics.networkMetrics.sentData},
-			{"sendPacketsRate", allMetrics.networkMetrics.sendPacketsRate}
-		};
-
-		json powerMetricsJSON = {
-			{"processorPower", allMetrics.powerMetrics.processorPower},
-			{"memoryPower", allMetrics.powerMetrics.memoryPower},
-			{"systemPower", allMetrics.powerMetrics.systemPower},
-			{"gpuPower", allMetrics.powerMetrics.gpuPower},
-			{"gpuTemperature", allMetrics.powerMetrics.gpuTemperature},
-			{"gpuFanSpeed", allMetrics.powerMetrics.gpuFanSpeed},
-			{"gpuMemoryTotal", allMetrics.powerMetrics.gpuMemoryTotal},
-			{"gpuMemoryUsed", allMetrics.powerMetrics.gpuMemoryUsed},
-			{"gpuMemoryFree", allMetrics.powerMetrics.gpuMemoryFree},
-			{"gpuClocksCurrentSM", allMetrics.powerMetrics.gpuClocksCurrentSM},
-			{"gpuClocksCurrentMemory", allMetrics.powerMetrics.gpuClocksCurrentMemory}
-		};
-
-		json allMetricsJSON = {
-			{"systemMetrics", systemMetricsJSON},
-			{"processorMetrics", processorMetricsJSON},
-			{"inputOutputMetrics", inputOutputMetricsJSON},
-			{"memoryMetrics", memoryMetricsJSON},
-			{"networkMetrics", networkMetricsJSON},
-			{"powerMetrics", powerMetricsJSON}
-		};
-
-		singleNode["Metrics"] = allMetricsJSON;
-		singleNode["Node"] = i;
-		nodesInformation.push_back(singleNode);
-	}
-
-	jsonToReturn["Nodes"] = nodesInformation;
-	jsonToReturn["timestamp"] = ss.str();
-	
-	// Save the JSON line into a file
-	return jsonToReturn;
-};
\ No newline at end of file
+		const AllMetrics &metrics = allMetricsArray[i];
+
+		line += '{';
+		appendNumber(line, "Node", i);
+		appendNumber(line, "deadline", metrics.deadline);
+		appendNumber(line, "jitter", metrics.jitter);
+		appendNumber(line, "realTime", metrics.sampleRealTime);
+		appendNumber(line, "monotonicTime", metrics.sampleMonotonicTime);
+		appendNumber(line, "clockOffset", metrics.clockOffset);
+		appendNumber(line, "clockDrift", metrics.clockDrift);
+		appendObjectStart(line, "Metrics");
+
+		if(metrics.groups & METRIC_BIT(METRIC_SYSTEM)){
+			appendObjectStart(line, "systemMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_SYSTEM]);
+			appendNumber(line, "processesRunning", metrics.systemMetrics.processesRunning);
+			appendNumber(line, "processesAll", metrics.systemMetrics.processesAll);
+			appendNumber(line, "processesBlocked", metrics.systemMetrics.processesBlocked);
+			appendCounter(line, "contextSwitches", metrics.systemMetrics.contextSwitches);
+			appendCounter(line, "interrupts", metrics.systemMetrics.interrupts);
+			appendCounter(line, "processesCreated", metrics.systemMetrics.processesCreated);
+			appendNumber(line, "contextSwitchRate", metrics.systemMetrics.contextSwitchRate);
+			appendNumber(line, "interruptRate", metrics.systemMetrics.interruptRate);
+			appendNumber(line, "processCreationRate", metrics.systemMetrics.processCreationRate);
+			appendCounter(line, "softInterrupts", metrics.systemMetrics.softInterrupts);
+			appendNumber(line, "softInterruptRate", metrics.systemMetrics.softInterruptRate);
+			appendNumber(line, "interruptCpu", metrics.systemMetrics.interruptCpu);
+			appendNumber(line, "interruptCpuRate", metrics.systemMetrics.interruptCpuRate);
+			appendNumber(line, "softInterruptCpu", metrics.systemMetrics.softInterruptCpu);
+			appendNumber(line, "softInterruptCpuRate", metrics.systemMetrics.softInterruptCpuRate);
+			appendNumber(line, "topInterrupts", metrics.systemMetrics.topInterrupts);
+			appendInterrupts(line, "interruptMetrics", metrics.systemMetrics.interruptMetrics, metrics.systemMetrics.topInterrupts);
+			appendNumber(line, "topSoftInterrupts", metrics.systemMetrics.topSoftInterrupts);
+			appendInterrupts(line, "softInterruptMetrics", metrics.systemMetrics.softInterruptMetrics, metrics.systemMetrics.topSoftInterrupts);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_PROCESSOR)){
+			appendObjectStart(line, "processorMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_PROCESSOR]);
+			appendNumber(line, "timeUser", metrics.processorMetrics.timeUser);
+			appendNumber(line, "timeNice", metrics.processorMetrics.timeNice);
+			appendNumber(line, "timeSystem", metrics.processorMetrics.timeSystem);
+			appendNumber(line, "timeIdle", metrics.processorMetrics.timeIdle);
+			appendNumber(line, "timeIoWait", metrics.processorMetrics.timeIoWait);
+			appendNumber(line, "timeIRQ", metrics.processorMetrics.timeIRQ);
+			appendNumber(line, "timeSoftIRQ", metrics.processorMetrics.timeSoftIRQ);
+			appendNumber(line, "timeSteal", metrics.processorMetrics.timeSteal);
+			appendNumber(line, "timeGuest", metrics.processorMetrics.timeGuest);
+			appendCounter(line, "instructionsRetired", metrics.processorMetrics.instructionsRetired);
+			appendCounter(line, "cycles", metrics.processorMetrics.cycles);
+			appendNumber(line, "instructionsPerSecond", metrics.processorMetrics.instructionsPerSecond);
+			appendNumber(line, "cyclesPerSecond", metrics.processorMetrics.cyclesPerSecond);
+			appendNumber(line, "frequencyRelative", metrics.processorMetrics.frequencyRelative);
+			appendNumber(line, "unhaltedFrequency", metrics.processorMetrics.unhaltedFrequency);
+			appendCounter(line, "cacheL2Misses", metrics.processorMetrics.cacheL2Misses);
+			appendCounter(line, "cacheL2Requests", metrics.processorMetrics.cacheL2Requests);
+			appendCounter(line, "cacheLLCLoadMisses", metrics.processorMetrics.cacheLLCLoadMisses);
+			appendCounter(line, "cacheLLCLoads", metrics.processorMetrics.cacheLLCLoads);
+			appendCounter(line, "cacheLLCStoreMisses", metrics.processorMetrics.cacheLLCStoreMisses);
+			appendCounter(line, "cacheLLCStores", metrics.processorMetrics.cacheLLCStores);
+			appendNumber(line, "cacheL2MissesPerSecond", metrics.processorMetrics.cacheL2MissesPerSecond);
+			appendNumber(line, "cacheL2RequestsPerSecond", metrics.processorMetrics.cacheL2RequestsPerSecond);
+			appendNumber(line, "cacheLLCLoadMissesPerSecond", metrics.processorMetrics.cacheLLCLoadMissesPerSecond);
+			appendNumber(line, "cacheLLCLoadsPerSecond", metrics.processorMetrics.cacheLLCLoadsPerSecond);
+			appendNumber(line, "cacheLLCStoreMissesPerSecond", metrics.processorMetrics.cacheLLCStoreMissesPerSecond);
+			appendNumber(line, "cacheLLCStoresPerSecond", metrics.processorMetrics.cacheLLCStoresPerSecond);
+			appendNumber(line, "cacheLLCLoadMissRate", metrics.processorMetrics.cacheLLCLoadMissRate);
+			appendNumber(line, "cacheLLCStoreMissRate", metrics.processorMetrics.cacheLLCStoreMissRate);
+			appendNumber(line, "cpus", metrics.processorMetrics.cpus);
+			appendNumber(line, "cores", metrics.processorMetrics.cores);
+			appendNumber(line, "sockets", metrics.processorMetrics.sockets);
+			appendNumber(line, "numaNodes", metrics.processorMetrics.numaNodes);
+			appendNumber(line, "cpuBusyMax", metrics.processorMetrics.cpuBusyMax);
+			appendNumber(line, "cpuBusyMin", metrics.processorMetrics.cpuBusyMin);
+			appendNumber(line, "cpuBusyDeviation", metrics.processorMetrics.cpuBusyDeviation);
+			appendNumber(line, "coreBusyMax", metrics.processorMetrics.coreBusyMax);
+			appendNumber(line, "coreBusyMin", metrics.processorMetrics.coreBusyMin);
+			appendArray(line, "socketBusy", metrics.processorMetrics.socketBusy,
+				std::min(metrics.processorMetrics.sockets, TOPOLOGY_MAX_SOCKETS));
+			appendArray(line, "nodeBusy", metrics.processorMetrics.nodeBusy,
+				std::min(metrics.processorMetrics.numaNodes, TOPOLOGY_MAX_NODES));
+			appendNumber(line, "frequencyMean", metrics.processorMetrics.frequencyMean);
+			appendNumber(line, "frequencyMin", metrics.processorMetrics.frequencyMin);
+			appendNumber(line, "frequencyMax", metrics.processorMetrics.frequencyMax);
+			appendNumber(line, "effectiveFrequency", metrics.processorMetrics.effectiveFrequency);
+			appendNumber(line, "coreThrottleRate", metrics.processorMetrics.coreThrottleRate);
+			appendNumber(line, "packageThrottleRate", metrics.processorMetrics.packageThrottleRate);
+			appendNumber(line, "coreThrottleTime", metrics.processorMetrics.coreThrottleTime);
+			appendNumber(line, "packageThrottleTime", metrics.processorMetrics.packageThrottleTime);
+			appendNumber(line, "idleStates", metrics.processorMetrics.idleStates);
+			appendArrayStart(line, "idleStateNames");
+			for(int j = 0; j < metrics.processorMetrics.idleStates; j++){
+				const char* name = metrics.processorMetrics.idleStateNames[j];
+				appendValue(line, std::string_view(name, strnlen(name, IDLE_NAME_LENGTH)));
+			}
+			appendArrayEnd(line);
+			appendArray(line, "idleStateResidency", metrics.processorMetrics.idleStateResidency, metrics.processorMetrics.idleStates);
+			appendArray(line, "idleStateRate", metrics.processorMetrics.idleStateRate, metrics.processorMetrics.idleStates);
+			appendArrayStart(line, "cpuMetrics");
+			for(int j = 0; j < metrics.processorMetrics.cpus; j++){
+				const CpuMetrics &cpu = metrics.processorMetrics.cpuMetrics[j];
+				line += '{';
+				appendNumber(line, "cpu", cpu.cpu);
+				appendNumber(line, "core", cpu.core);
+				appendNumber(line, "socket", cpu.socket);
+				appendNumber(line, "node", cpu.node);
+				appendNumber(line, "busy", cpu.busy);
+				appendNumber(line, "user", cpu.user);
+				appendNumber(line, "system", cpu.system);
+				appendNumber(line, "ioWait", cpu.ioWait);
+				appendNumber(line, "frequency", cpu.frequency);
+				appendNumber(line, "effectiveFrequency", cpu.effectiveFrequency);
+				appendNumber(line, "idleResidency", cpu.idleResidency);
+				appendNumber(line, "throttleTime", cpu.throttleTime);
+				appendObjectEnd(line);
+			}
+			appendArrayEnd(line);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_INPUT_OUTPUT)){
+			appendObjectStart(line, "inputOutputMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_INPUT_OUTPUT]);
+			appendNumber(line, "processID", metrics.inputOutputMetrics.processID);
+			appendCounter(line, "dataRead", metrics.inputOutputMetrics.dataRead);
+			appendNumber(line, "dataReadRate", metrics.inputOutputMetrics.dataReadRate);
+			appendCounter(line, "readOperations", metrics.inputOutputMetrics.readOperations);
+			appendNumber(line, "readOperationsRate", metrics.inputOutputMetrics.readOperationsRate);
+			appendCounter(line, "dataWritten", metrics.inputOutputMetrics.dataWritten);
+			appendNumber(line, "dataWrittenRate", metrics.inputOutputMetrics.dataWrittenRate);
+			appendCounter(line, "writeOperations", metrics.inputOutputMetrics.writeOperations);
+			appendNumber(line, "writeOperationsRate", metrics.inputOutputMetrics.writeOperationsRate);
+			appendNumber(line, "diskReadRate", metrics.inputOutputMetrics.diskReadRate);
+			appendNumber(line, "diskWriteRate", metrics.inputOutputMetrics.diskWriteRate);
+			appendNumber(line, "diskDataReadRate", metrics.inputOutputMetrics.diskDataReadRate);
+			appendNumber(line, "diskDataWrittenRate", metrics.inputOutputMetrics.diskDataWrittenRate);
+			appendNumber(line, "diskReadTime", metrics.inputOutputMetrics.diskReadTime);
+			appendNumber(line, "diskWriteTime", metrics.inputOutputMetrics.diskWriteTime);
+			appendNumber(line, "diskUtilization", metrics.inputOutputMetrics.diskUtilization);
+			appendNumber(line, "devices", metrics.inputOutputMetrics.devices);
+			appendArrayStart(line, "deviceMetrics");
+			for(int j = 0; j < metrics.inputOutputMetrics.devices; j++){
+				const BlockDeviceMetrics &device = metrics.inputOutputMetrics.deviceMetrics[j];
+				line += '{';
+				appendText(line, "name", device.name, sizeof(device.name));
+				appendNumber(line, "stacked", device.stacked);
+				appendCounter(line, "reads", device.reads);
+				appendCounter(line, "writes", device.writes);
+				appendCounter(line, "dataRead", device.dataRead);
+				appendCounter(line, "dataWritten", device.dataWritten);
+				appendNumber(line, "readRate", device.readRate);
+				appendNumber(line, "writeRate", device.writeRate);
+				appendNumber(line, "dataReadRate", device.dataReadRate);
+				appendNumber(line, "dataWrittenRate", device.dataWrittenRate);
+				appendNumber(line, "readTime", device.readTime);
+				appendNumber(line, "writeTime", device.writeTime);
+				appendNumber(line, "flushRate", device.flushRate);
+				appendNumber(line, "flushTime", device.flushTime);
+				appendNumber(line, "queueDepth", device.queueDepth);
+				appendNumber(line, "utilization", device.utilization);
+				appendObjectEnd(line);
+			}
+			appendArrayEnd(line);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_PROCESS)){
+			appendObjectStart(line, "processMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_PROCESS]);
+			appendNumber(line, "processID", metrics.processMetrics.processID);
+			appendNumber(line, "processes", metrics.processMetrics.processes);
+			appendNumber(line, "threads", metrics.processMetrics.threads);
+			appendCounter(line, "cpuTime", metrics.processMetrics.cpuTime);
+			appendNumber(line, "cpuUsage", metrics.processMetrics.cpuUsage);
+			appendNumber(line, "memoryResident", metrics.processMetrics.memoryResident);
+			appendCounter(line, "contextSwitches", metrics.processMetrics.contextSwitches);
+			appendNumber(line, "contextSwitchRate", metrics.processMetrics.contextSwitchRate);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_MEMORY)){
+			appendObjectStart(line, "memoryMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_MEMORY]);
+			appendNumber(line, "memoryTotal", metrics.memoryMetrics.memoryTotal);
+			appendNumber(line, "memoryUsed", metrics.memoryMetrics.memoryUsed);
+			appendNumber(line, "memoryAvailable", metrics.memoryMetrics.memoryAvailable);
+			appendNumber(line, "memoryCached", metrics.memoryMetrics.memoryCached);
+			appendNumber(line, "swapUsed", metrics.memoryMetrics.swapUsed);
+			appendNumber(line, "swapCached", metrics.memoryMetrics.swapCached);
+			appendNumber(line, "memoryActive", metrics.memoryMetrics.memoryActive);
+			appendNumber(line, "memoryInactive", metrics.memoryMetrics.memoryInactive);
+			appendNumber(line, "memoryHugePages", metrics.memoryMetrics.memoryHugePages);
+			appendNumber(line, "pageInRate", metrics.memoryMetrics.pageInRate);
+			appendNumber(line, "pageOutRate", metrics.memoryMetrics.pageOutRate);
+			appendNumber(line, "pageFaultRate", metrics.memoryMetrics.pageFaultRate);
+			appendNumber(line, "pageFaultsMajorRate", metrics.memoryMetrics.pageFaultsMajorRate);
+			appendNumber(line, "pageFreeRate", metrics.memoryMetrics.pageFreeRate);
+			appendNumber(line, "pageActivateRate", metrics.memoryMetrics.pageActivateRate);
+			appendNumber(line, "pageDeactivateRate", metrics.memoryMetrics.pageDeactivateRate);
+			appendNumber(line, "blockReadRate", metrics.memoryMetrics.blockReadRate);
+			appendNumber(line, "blockWriteRate", metrics.memoryMetrics.blockWriteRate);
+			appendNumber(line, "blockIoRate", metrics.memoryMetrics.blockIoRate);
+			appendNumber(line, "thpFaultRate", metrics.memoryMetrics.thpFaultRate);
+			appendNumber(line, "thpFallbackRate", metrics.memoryMetrics.thpFallbackRate);
+			appendNumber(line, "thpCollapseRate", metrics.memoryMetrics.thpCollapseRate);
+			appendNumber(line, "thpSplitRate", metrics.memoryMetrics.thpSplitRate);
+			appendNumber(line, "compactionStallRate", metrics.memoryMetrics.compactionStallRate);
+			appendNumber(line, "compactionFailRate", metrics.memoryMetrics.compactionFailRate);
+			appendNumber(line, "compactionSuccessRate", metrics.memoryMetrics.compactionSuccessRate);
+			appendNumber(line, "numaPteUpdateRate", metrics.memoryMetrics.numaPteUpdateRate);
+			appendNumber(line, "numaHintFaultRate", metrics.memoryMetrics.numaHintFaultRate);
+			appendNumber(line, "numaHintFaultLocalRatio", metrics.memoryMetrics.numaHintFaultLocalRatio);
+			appendNumber(line, "numaMigrationRate", metrics.memoryMetrics.numaMigrationRate);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_NETWORK)){
+			appendObjectStart(line, "networkMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_NETWORK]);
+			appendCounter(line, "receivedData", metrics.networkMetrics.receivedData);
+			appendCounter(line, "receivedBytes", metrics.networkMetrics.receivedBytes);
+			appendNumber(line, "receivePacketRate", metrics.networkMetrics.receivePacketRate);
+			appendCounter(line, "sentData", metrics.networkMetrics.sentData);
+			appendCounter(line, "sentBytes", metrics.networkMetrics.sentBytes);
+			appendNumber(line, "sendPacketsRate", metrics.networkMetrics.sendPacketsRate);
+			appendNumber(line, "dropRate", metrics.networkMetrics.dropRate);
+			appendNumber(line, "errorRate", metrics.networkMetrics.errorRate);
+			appendCounter(line, "tcpRetransmits", metrics.networkMetrics.tcpRetransmits);
+			appendNumber(line, "tcpRetransmitRate", metrics.networkMetrics.tcpRetransmitRate);
+			appendNumber(line, "tcpRetransmitRatio", metrics.networkMetrics.tcpRetransmitRatio);
+			appendNumber(line, "tcpErrorRate", metrics.networkMetrics.tcpErrorRate);
+			appendCounter(line, "udpErrors", metrics.networkMetrics.udpErrors);
+			appendNumber(line, "udpErrorRate", metrics.networkMetrics.udpErrorRate);
+			appendNumber(line, "interfaces", metrics.networkMetrics.interfaces);
+			appendArrayStart(line, "interfaceMetrics");
+			for(int j = 0; j < metrics.networkMetrics.interfaces; j++){
+				const NetworkInterfaceMetrics &interface = metrics.networkMetrics.interfaceMetrics[j];
+				line += '{';
+				appendText(line, "name", interface.name, sizeof(interface.name));
+				appendCounter(line, "receivedBytes", interface.receivedBytes);
+				appendCounter(line, "receivedPackets", interface.receivedPackets);
+				appendCounter(line, "sentBytes", interface.sentBytes);
+				appendCounter(line, "sentPackets", interface.sentPackets);
+				appendNumber(line, "receiveRate", interface.receiveRate);
+				appendNumber(line, "sendRate", interface.sendRate);
+				appendNumber(line, "receivePacketRate", interface.receivePacketRate);
+				appendNumber(line, "sendPacketRate", interface.sendPacketRate);
+				appendNumber(line, "receiveDropRate", interface.receiveDropRate);
+				appendNumber(line, "sendDropRate", interface.sendDropRate);
+				appendNumber(line, "receiveErrorRate", interface.receiveErrorRate);
+				appendNumber(line, "sendErrorRate", interface.sendErrorRate);
+				appendObjectEnd(line);
+			}
+			appendArrayEnd(line);
+			appendNumber(line, "infinibandTransmitRate", metrics.networkMetrics.infinibandTransmitRate);
+			appendNumber(line, "infinibandReceiveRate", metrics.networkMetrics.infinibandReceiveRate);
+			appendNumber(line, "infinibandPorts", metrics.networkMetrics.infinibandPorts);
+			appendArrayStart(line, "infinibandMetrics");
+			for(int j = 0; j < metrics.networkMetrics.infinibandPorts; j++){
+				const InfinibandPortMetrics &port = metrics.networkMetrics.infinibandMetrics[j];
+				line += '{';
+				appendText(line, "name", port.name, sizeof(port.name));
+				appendNumber(line, "state", port.state);
+				appendNumber(line, "linkRate", port.linkRate);
+				appendNumber(line, "transmitRate", port.transmitRate);
+				appendNumber(line, "receiveRate", port.receiveRate);
+				appendNumber(line, "transmitPacketRate", port.transmitPacketRate);
+				appendNumber(line, "receivePacketRate", port.receivePacketRate);
+				appendNumber(line, "utilization", port.utilization);
+				appendNumber(line, "waitRate", port.waitRate);
+				appendNumber(line, "linkErrors", port.linkErrors);
+				appendNumber(line, "receiveErrors", port.receiveErrors);
+				appendNumber(line, "transmitDiscards", port.transmitDiscards);
+				appendNumber(line, "transportErrors", port.transportErrors);
+				appendNumber(line, "outOfBuffer", port.outOfBuffer);
+				appendNumber(line, "saturatedCounters", port.saturatedCounters);
+				appendObjectEnd(line);
+			}
+			appendArrayEnd(line);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_POWER)){
+			appendObjectStart(line, "powerMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_POWER]);
+			appendNumber(line, "processorPower", metrics.powerMetrics.processorPower);
+			appendNumber(line, "memoryPower", metrics.powerMetrics.memoryPower);
+			appendNumber(line, "systemPower", metrics.powerMetrics.systemPower);
+			appendNumber(line, "packages", metrics.powerMetrics.packages);
+			appendArray(line, "packagePower", metrics.powerMetrics.packagePower, metrics.powerMetrics.packages);
+			appendArray(line, "corePower", metrics.powerMetrics.corePower, metrics.powerMetrics.packages);
+			appendArray(line, "dramPower", metrics.powerMetrics.dramPower, metrics.powerMetrics.packages);
+			appendNumber(line, "platformPower", metrics.powerMetrics.platformPower);
+			appendNumber(line, "meterPower", metrics.powerMetrics.meterPower);
+			appendNumber(line, "meterEnergy", metrics.powerMetrics.meterEnergy);
+			appendNumber(line, "meterPeakPower", metrics.powerMetrics.meterPeakPower);
+			appendNumber(line, "meterSamples", metrics.powerMetrics.meterSamples);
+			appendNumber(line, "gpuPower", metrics.powerMetrics.gpuPower);
+			appendNumber(line, "gpuTemperature", metrics.powerMetrics.gpuTemperature);
+			appendNumber(line, "gpuFanSpeed", metrics.powerMetrics.gpuFanSpeed);
+			appendNumber(line, "gpuMemoryTotal", metrics.powerMetrics.gpuMemoryTotal);
+			appendNumber(line, "gpuMemoryUsed", metrics.powerMetrics.gpuMemoryUsed);
+			appendNumber(line, "gpuMemoryFree", metrics.powerMetrics.gpuMemoryFree);
+			appendNumber(line, "gpuClocksCurrentSM", metrics.powerMetrics.gpuClocksCurrentSM);
+			appendNumber(line, "gpuClocksCurrentMemory", metrics.powerMetrics.gpuClocksCurrentMemory);
+			appendNumber(line, "gpus", metrics.powerMetrics.gpus);
+			appendArrayStart(line, "gpuMetrics");
+			for(int j = 0; j < metrics.powerMetrics.gpus; j++){
+				const GpuDeviceMetrics &gpu = metrics.powerMetrics.gpuMetrics[j];
+				line += '{';
+				appendText(line, "name", gpu.name, sizeof(gpu.name));
+				appendNumber(line, "power", gpu.power);
+				appendNumber(line, "temperature", gpu.temperature);
+				appendNumber(line, "fanSpeed", gpu.fanSpeed);
+				appendNumber(line, "memoryTotal", gpu.memoryTotal);
+				appendNumber(line, "memoryUsed", gpu.memoryUsed);
+				appendNumber(line, "memoryFree", gpu.memoryFree);
+				appendNumber(line, "clocksSM", gpu.clocksSM);
+				appendNumber(line, "clocksMemory", gpu.clocksMemory);
+				appendNumber(line, "utilization", gpu.utilization);
+				appendNumber(line, "memoryUtilization", gpu.memoryUtilization);
+				appendObjectEnd(line);
+			}
+			appendArrayEnd(line);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_PRESSURE)){
+			appendObjectStart(line, "pressureMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_PRESSURE]);
+			appendPressure(line, "system", metrics.pressureMetrics.system);
+			appendPressure(line, "cgroup", metrics.pressureMetrics.cgroup);
+			appendNumber(line, "triggerEvents", metrics.pressureMetrics.triggerEvents);
+			appendNumber(line, "firstTriggerDelay", metrics.pressureMetrics.firstTriggerDelay);
+			appendObjectEnd(line);
+		}
+
+		if(metrics.groups & METRIC_BIT(METRIC_JOB)){
+			appendObjectStart(line, "jobMetrics");
+			appendNumber(line, "timestamp", metrics.timestamps[METRIC_JOB]);
+			appendText(line, "cgroup", metrics.jobMetrics.cgroup, sizeof(metrics.jobMetrics.cgroup));
+			appendNumber(line, "cpuUsage", metrics.jobMetrics.cpuUsage);
+			appendNumber(line, "cpuUser", metrics.jobMetrics.cpuUser);
+			appendNumber(line, "cpuSystem", metrics.jobMetrics.cpuSystem);
+			appendNumber(line, "cpuShare", metrics.jobMetrics.cpuShare);
+			appendNumber(line, "throttledPeriods", metrics.jobMetrics.throttledPeriods);
+			appendNumber(line, "throttledTime", metrics.jobMetrics.throttledTime);
+			appendNumber(line, "memoryCurrent", metrics.jobMetrics.memoryCurrent);
+			appendNumber(line, "memoryAnon", metrics.jobMetrics.memoryAnon);
+			appendNumber(line, "memoryFile", metrics.jobMetrics.memoryFile);
+			appendNumber(line, "memoryKernel", metrics.jobMetrics.memoryKernel);
+			appendNumber(line, "memoryShmem", metrics.jobMetrics.memoryShmem);
+			appendNumber(line, "pageFaultRate", metrics.jobMetrics.pageFaultRate);
+			appendNumber(line, "majorFaultRate", metrics.jobMetrics.majorFaultRate);
+			appendNumber(line, "dataReadRate", metrics.jobMetrics.dataReadRate);
+			appendNumber(line, "dataWrittenRate", metrics.jobMetrics.dataWrittenRate);
+			appendNumber(line, "readRate", metrics.jobMetrics.readRate);
+			appendNumber(line, "writeRate", metrics.jobMetrics.writeRate);
+			appendNumber(line, "power", metrics.jobMetrics.power);
+			appendObjectEnd(line);
+		}
+
+		appendObjectEnd(line);
+		appendObjectEnd(line);
+	}
+	if(line.back() == ',') line.back() = ']';
+	else line += ']';
+	line += "}\n";
+};
+
+void appendLaunchLine(std::string &line, const std::string &command, const LaunchRecord* records, int clusterSize){
+
+	line += '{';
+	appendObjectStart(line, "launch");
+	appendKey(line, "command");
+	appendValue(line, command);
+
+	appendKey(line, "Nodes");
+	line += '[';
+	for(int i = 0; i < clusterSize; i++){
+		line += '{';
+		appendNumber(line, "Node", i);
+		appendNumber(line, "processID", records[i].processID);
+		appendNumber(line, "startTime", records[i].startTime);
+		appendNumber(line, "endTime", records[i].endTime);
+		appendNumber(line, "exitCode", records[i].exitCode);
+		appendNumber(line, "exitSignal", records[i].exitSignal);
+		appendObjectEnd(line);
+	}
+	if(line.back() == ',') line.back() = ']';
+	else line += ']';
+	line += ',';
+
+	appendObjectEnd(line);
+	line.back() = '}';
+	line += '\n';
+};
+
+ResultWriter::ResultWriter(){
+	this->file = nullptr;
+	this->closing = false;
+};
+
+ResultWriter::~ResultWriter(){
+	this->close();
+};
+
+bool ResultWriter::open(const std::string &fileName){
+
+	this->close();
+	this->file = std::fopen(fileName.c_str(), "w");
+	if(!this->file) return false;
+	std::setvbuf(this->file, nullptr, _IOFBF, WRITER_BUFFER_SIZE);
+
+	this->closing = false;
+	this->writerThread = std::thread(&ResultWriter::run, this);
+	return true;
+};
+
+void ResultWriter::write(const std::string &line){
+
+	if(!this->file) return;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pending += line;
+	}
+	this->wakeUp.notify_one();
+};
+
+void ResultWriter::close(){
+
+	if(!this->file) return;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->closing = true;
+	}
+	this->wakeUp.notify_one();
+	this->writerThread.join();
+
+	std::fclose(this->file);
+	this->file = nullptr;
+};
+
+void ResultWriter::run(){
+
+	// The two strings are swapped back and forth, so after the first samples nothing is allocated anymore
+	std::string writing;
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while(true){
+		this->wakeUp.wait(lock, [this]{ return !this->pending.empty() || this->closing; });
+		if(this->pending.empty()) break;
+
+		writing.swap(this->pending);
+		lock.unlock();
+		std::fwrite(writing.data(), 1, writing.size(), this->file);
+		std::fflush(this->file);
+		writing.clear();
+		lock.lock();
+	}
+};
+
+// Columns get their type from the field itself, so the table cannot disagree with metrics.h
+template<typename T> static ResultsColumnType columnType();
+template<> ResultsColumnType columnType<int>(){ return COLUMN_INT32; };
+template<> ResultsColumnType columnType<uint64_t>(){ return COLUMN_UINT64; };
+template<> ResultsColumnType columnType<float>(){ return COLUMN_FLOAT; };
+template<> ResultsColumnType columnType<double>(){ return COLUMN_DOUBLE; };
+template<> ResultsColumnType columnType<int64_t>(){ return COLUMN_INT64; };
+
+// A field of the record header, e.g. "deadline", under its own name
+#define RECORD_COLUMN(name, field) \
+	addColumn<std::remove_all_extents_t<decltype(AllMetrics::field)>>(columns, name, offsetof(AllMetrics, field))
+
+#define METRIC_COLUMN(section, field) \
+	addColumn<decltype(AllMetrics::section.field)>(columns, #section "." #field, offsetof(AllMetrics, section.field))
+
+// One column per field of every slot of an array of structures, e.g. "inputOutputMetrics.deviceMetrics[3].readRate"
+#define METRIC_ELEMENT_COLUMN(section, array, index, field) \
+	addColumn<decltype(AllMetrics::section.array[0].field)>(columns, \
+		#section "." #array "[" + std::to_string(index) + "]." #field, \
+		offsetof(AllMetrics, section.array) + index * sizeof(AllMetrics::section.array[0]) \
+			+ offsetof(std::remove_reference_t<decltype(AllMetrics::section.array[0])>, field))
+
+template<typename T>
+static void addColumn(std::vector<T> &columns, const std::string &name, ResultsColumnType type, uint32_t width, size_t offset){
+	columns.push_back({name, type, width, offset, 0});
+};
+
+template<typename Field, typename T>
+static void addColumn(std::vector<T> &columns, const std::string &name, size_t offset){
+	// Names are saved as fixed size character arrays
+	if constexpr(std::is_array_v<Field>) addColumn(columns, name, COLUMN_TEXT, sizeof(Field), offset);
+	else addColumn(columns, name, columnType<Field>(), sizeof(Field), offset);
+};
+
+// Arrays with one value per package, socket or NUMA node are saved as one column per slot
+template<typename T>
+static void addColumnArray(std::vector<T> &columns, const std::string &name, size_t offset, int count){
+	for(int i = 0; i < count; i++)
+		addColumn<float>(columns, name + "[" + std::to_string(i) + "]", offset + i * sizeof(float));
+};
+
+ColumnarWriter::ColumnarWriter(){
+	this->nodes = 0;
+	this->samples = 0;
+};
+
+bool ColumnarWriter::open(const std::string &fileName, int clusterSize){
+
+	this->close();
+	this->nodes = clusterSize;
+	this->samples = 0;
+
+	std::vector<MetricColumn> &columns = this->columns;
+	columns.clear();
+	// Every row holds the last value of every section, these tell which ones were sampled for it and when
+	addColumn<int>(columns, "groups", offsetof(AllMetrics, groups));
+	RECORD_COLUMN("deadline", deadline);
+	RECORD_COLUMN("jitter", jitter);
+	RECORD_COLUMN("realTime", sampleRealTime);
+	RECORD_COLUMN("monotonicTime", sampleMonotonicTime);
+	RECORD_COLUMN("clockOffset", clockOffset);
+	RECORD_COLUMN("clockDrift", clockDrift);
+	const char* sections[METRIC_GROUPS] = {"systemMetrics", "processorMetrics", "inputOutputMetrics", "processMetrics",
+		"memoryMetrics", "networkMetrics", "powerMetrics", "pressureMetrics", "jobMetrics"};
+	for(int group = 0; group < METRIC_GROUPS; group++)
+		addColumn<std::remove_all_extents_t<decltype(AllMetrics::timestamps)>>(columns, std::string(sections[group]) + ".timestamp",
+			offsetof(AllMetrics, timestamps) + group * sizeof(AllMetrics::timestamps[0]));
+	METRIC_COLUMN(systemMetrics, processesRunning);
+	METRIC_COLUMN(systemMetrics, processesAll);
+	METRIC_COLUMN(systemMetrics, processesBlocked);
+	METRIC_COLUMN(systemMetrics, contextSwitches);
+	METRIC_COLUMN(systemMetrics, interrupts);
+	METRIC_COLUMN(systemMetrics, processesCreated);
+	METRIC_COLUMN(systemMetrics, contextSwitchRate);
+	METRIC_COLUMN(systemMetrics, interruptRate);
+	METRIC_COLUMN(systemMetrics, processCreationRate);
+	METRIC_COLUMN(systemMetrics, softInterrupts);
+	METRIC_COLUMN(systemMetrics, softInterruptRate);
+	METRIC_COLUMN(systemMetrics, interruptCpu);
+	METRIC_COLUMN(systemMetrics, interruptCpuRate);
+	METRIC_COLUMN(systemMetrics, softInterruptCpu);
+	METRIC_COLUMN(systemMetrics, softInterruptCpuRate);
+	METRIC_COLUMN(systemMetrics, topInterrupts);
+	for(int i = 0; i < INTERRUPT_TOP; i++){
+		METRIC_ELEMENT_COLUMN(systemMetrics, interruptMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(systemMetrics, interruptMetrics, i, device);
+		METRIC_ELEMENT_COLUMN(systemMetrics, interruptMetrics, i, cpu);
+		METRIC_ELEMENT_COLUMN(systemMetrics, interruptMetrics, i, count);
+		METRIC_ELEMENT_COLUMN(systemMetrics, interruptMetrics, i, rate);
+	}
+	METRIC_COLUMN(systemMetrics, topSoftInterrupts);
+	for(int i = 0; i < INTERRUPT_TOP; i++){
+		METRIC_ELEMENT_COLUMN(systemMetrics, softInterruptMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(systemMetrics, softInterruptMetrics, i, cpu);
+		METRIC_ELEMENT_COLUMN(systemMetrics, softInterruptMetrics, i, count);
+		METRIC_ELEMENT_COLUMN(systemMetrics, softInterruptMetrics, i, rate);
+	}
+
+	METRIC_COLUMN(processorMetrics, timeUser);
+	METRIC_COLUMN(processorMetrics, timeNice);
+	METRIC_COLUMN(processorMetrics, timeSystem);
+	METRIC_COLUMN(processorMetrics, timeIdle);
+	METRIC_COLUMN(processorMetrics, timeIoWait);
+	METRIC_COLUMN(processorMetrics, timeIRQ);
+	METRIC_COLUMN(processorMetrics, timeSoftIRQ);
+	METRIC_COLUMN(processorMetrics, timeSteal);
+	METRIC_COLUMN(processorMetrics, timeGuest);
+	METRIC_COLUMN(processorMetrics, instructionsRetired);
+	METRIC_COLUMN(processorMetrics, cycles);
+	METRIC_COLUMN(processorMetrics, instructionsPerSecond);
+	METRIC_COLUMN(processorMetrics, cyclesPerSecond);
+	METRIC_COLUMN(processorMetrics, frequencyRelative);
+	METRIC_COLUMN(processorMetrics, unhaltedFrequency);
+	METRIC_COLUMN(processorMetrics, cacheL2Requests);
+	METRIC_COLUMN(processorMetrics, cacheL2Misses);
+	METRIC_COLUMN(processorMetrics, cacheLLCLoads);
+	METRIC_COLUMN(processorMetrics, cacheLLCStores);
+	METRIC_COLUMN(processorMetrics, cacheLLCLoadMisses);
+	METRIC_COLUMN(processorMetrics, cacheLLCStoreMisses);
+	METRIC_COLUMN(processorMetrics, cacheL2RequestsPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheL2MissesPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheLLCLoadsPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheLLCStoresPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheLLCLoadMissesPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheLLCStoreMissesPerSecond);
+	METRIC_COLUMN(processorMetrics, cacheLLCLoadMissRate);
+	METRIC_COLUMN(processorMetrics, cacheLLCStoreMissRate);
+	METRIC_COLUMN(processorMetrics, cpus);
+	METRIC_COLUMN(processorMetrics, cores);
+	METRIC_COLUMN(processorMetrics, sockets);
+	METRIC_COLUMN(processorMetrics, numaNodes);
+	METRIC_COLUMN(processorMetrics, cpuBusyMax);
+	METRIC_COLUMN(processorMetrics, cpuBusyMin);
+	METRIC_COLUMN(processorMetrics, cpuBusyDeviation);
+	METRIC_COLUMN(processorMetrics, coreBusyMax);
+	METRIC_COLUMN(processorMetrics, coreBusyMin);
+	addColumnArray(columns, "processorMetrics.socketBusy", offsetof(AllMetrics, processorMetrics.socketBusy), TOPOLOGY_MAX_SOCKETS);
+	addColumnArray(columns, "processorMetrics.nodeBusy", offsetof(AllMetrics, processorMetrics.nodeBusy), TOPOLOGY_MAX_NODES);
+	METRIC_COLUMN(processorMetrics, frequencyMean);
+	METRIC_COLUMN(processorMetrics, frequencyMin);
+	METRIC_COLUMN(processorMetrics, frequencyMax);
+	METRIC_COLUMN(processorMetrics, effectiveFrequency);
+	METRIC_COLUMN(processorMetrics, coreThrottleRate);
+	METRIC_COLUMN(processorMetrics, packageThrottleRate);
+	METRIC_COLUMN(processorMetrics, coreThrottleTime);
+	METRIC_COLUMN(processorMetrics, packageThrottleTime);
+	METRIC_COLUMN(processorMetrics, idleStates);
+	for(int i = 0; i < IDLE_MAX_STATES; i++)
+		addColumn<char[IDLE_NAME_LENGTH]>(columns, "processorMetrics.idleStateNames[" + std::to_string(i) + "]",
+			offsetof(AllMetrics, processorMetrics.idleStateNames) + i * IDLE_NAME_LENGTH);
+	addColumnArray(columns, "processorMetrics.idleStateResidency", offsetof(AllMetrics, processorMetrics.idleStateResidency), IDLE_MAX_STATES);
+	addColumnArray(columns, "processorMetrics.idleStateRate", offsetof(AllMetrics, processorMetrics.idleStateRate), IDLE_MAX_STATES);
+	for(int i = 0; i < TOPOLOGY_MAX_CPUS; i++){
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, cpu);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, core);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, socket);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, node);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, busy);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, user);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, system);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, ioWait);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, frequency);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, effectiveFrequency);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, idleResidency);
+		METRIC_ELEMENT_COLUMN(processorMetrics, cpuMetrics, i, throttleTime);
+	}
+
+	METRIC_COLUMN(inputOutputMetrics, processID);
+	METRIC_COLUMN(inputOutputMetrics, dataRead);
+	METRIC_COLUMN(inputOutputMetrics, dataWritten);
+	METRIC_COLUMN(inputOutputMetrics, readOperations);
+	METRIC_COLUMN(inputOutputMetrics, writeOperations);
+	METRIC_COLUMN(inputOutputMetrics, dataReadRate);
+	METRIC_COLUMN(inputOutputMetrics, dataWrittenRate);
+	METRIC_COLUMN(inputOutputMetrics, readOperationsRate);
+	METRIC_COLUMN(inputOutputMetrics, writeOperationsRate);
+	METRIC_COLUMN(inputOutputMetrics, diskReadRate);
+	METRIC_COLUMN(inputOutputMetrics, diskWriteRate);
+	METRIC_COLUMN(inputOutputMetrics, diskDataReadRate);
+	METRIC_COLUMN(inputOutputMetrics, diskDataWrittenRate);
+	METRIC_COLUMN(inputOutputMetrics, diskReadTime);
+	METRIC_COLUMN(inputOutputMetrics, diskWriteTime);
+	METRIC_COLUMN(inputOutputMetrics, diskUtilization);
+	METRIC_COLUMN(inputOutputMetrics, devices);
+	for(int i = 0; i < BLOCK_MAX_DEVICES; i++){
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, stacked);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, reads);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, writes);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, dataRead);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, dataWritten);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, readRate);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, writeRate);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, dataReadRate);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, dataWrittenRate);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, readTime);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, writeTime);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, flushRate);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, flushTime);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, queueDepth);
+		METRIC_ELEMENT_COLUMN(inputOutputMetrics, deviceMetrics, i, utilization);
+	}
+
+	METRIC_COLUMN(processMetrics, processID);
+	METRIC_COLUMN(processMetrics, processes);
+	METRIC_COLUMN(processMetrics, threads);
+	METRIC_COLUMN(processMetrics, cpuTime);
+	METRIC_COLUMN(processMetrics, cpuUsage);
+	METRIC_COLUMN(processMetrics, memoryResident);
+	METRIC_COLUMN(processMetrics, contextSwitches);
+	METRIC_COLUMN(processMetrics, contextSwitchRate);
+
+	METRIC_COLUMN(memoryMetrics, memoryTotal);
+	METRIC_COLUMN(memoryMetrics, memoryUsed);
+	METRIC_COLUMN(memoryMetrics, memoryAvailable);
+	METRIC_COLUMN(memoryMetrics, memoryCached);
+	METRIC_COLUMN(memoryMetrics, swapUsed);
+	METRIC_COLUMN(memoryMetrics, swapCached);
+	METRIC_COLUMN(memoryMetrics, memoryActive);
+	METRIC_COLUMN(memoryMetrics, memoryInactive);
+	METRIC_COLUMN(memoryMetrics, memoryHugePages);
+	METRIC_COLUMN(memoryMetrics, pageInRate);
+	METRIC_COLUMN(memoryMetrics, pageOutRate);
+	METRIC_COLUMN(memoryMetrics, pageFaultRate);
+	METRIC_COLUMN(memoryMetrics, pageFaultsMajorRate);
+	METRIC_COLUMN(memoryMetrics, pageFreeRate);
+	METRIC_COLUMN(memoryMetrics, pageActivateRate);
+	METRIC_COLUMN(memoryMetrics, pageDeactivateRate);
+	METRIC_COLUMN(memoryMetrics, blockReadRate);
+	METRIC_COLUMN(memoryMetrics, blockWriteRate);
+	METRIC_COLUMN(memoryMetrics, blockIoRate);
+	METRIC_COLUMN(memoryMetrics, thpFaultRate);
+	METRIC_COLUMN(memoryMetrics, thpFallbackRate);
+	METRIC_COLUMN(memoryMetrics, thpCollapseRate);
+	METRIC_COLUMN(memoryMetrics, thpSplitRate);
+	METRIC_COLUMN(memoryMetrics, compactionStallRate);
+	METRIC_COLUMN(memoryMetrics, compactionFailRate);
+	METRIC_COLUMN(memoryMetrics, compactionSuccessRate);
+	METRIC_COLUMN(memoryMetrics, numaPteUpdateRate);
+	METRIC_COLUMN(memoryMetrics, numaHintFaultRate);
+	METRIC_COLUMN(memoryMetrics, numaHintFaultLocalRatio);
+	METRIC_COLUMN(memoryMetrics, numaMigrationRate);
+
+	METRIC_COLUMN(networkMetrics, receivedData);
+	METRIC_COLUMN(networkMetrics, receivedBytes);
+	METRIC_COLUMN(networkMetrics, receivePacketRate);
+	METRIC_COLUMN(networkMetrics, sentData);
+	METRIC_COLUMN(networkMetrics, sentBytes);
+	METRIC_COLUMN(networkMetrics, sendPacketsRate);
+	METRIC_COLUMN(networkMetrics, dropRate);
+	METRIC_COLUMN(networkMetrics, errorRate);
+	METRIC_COLUMN(networkMetrics, tcpRetransmits);
+	METRIC_COLUMN(networkMetrics, tcpRetransmitRate);
+	METRIC_COLUMN(networkMetrics, tcpRetransmitRatio);
+	METRIC_COLUMN(networkMetrics, tcpErrorRate);
+	METRIC_COLUMN(networkMetrics, udpErrors);
+	METRIC_COLUMN(networkMetrics, udpErrorRate);
+	METRIC_COLUMN(networkMetrics, interfaces);
+	for(int i = 0; i < NETWORK_MAX_INTERFACES; i++){
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receivedBytes);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receivedPackets);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sentBytes);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sentPackets);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receiveRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sendRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receivePacketRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sendPacketRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receiveDropRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sendDropRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, receiveErrorRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, interfaceMetrics, i, sendErrorRate);
+	}
+	METRIC_COLUMN(networkMetrics, infinibandTransmitRate);
+	METRIC_COLUMN(networkMetrics, infinibandReceiveRate);
+	METRIC_COLUMN(networkMetrics, infinibandPorts);
+	for(int i = 0; i < INFINIBAND_MAX_PORTS; i++){
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, state);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, linkRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, transmitRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, receiveRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, transmitPacketRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, receivePacketRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, utilization);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, waitRate);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, linkErrors);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, receiveErrors);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, transmitDiscards);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, transportErrors);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, outOfBuffer);
+		METRIC_ELEMENT_COLUMN(networkMetrics, infinibandMetrics, i, saturatedCounters);
+	}
+
+	METRIC_COLUMN(powerMetrics, processorPower);
+	METRIC_COLUMN(powerMetrics, memoryPower);
+	METRIC_COLUMN(powerMetrics, systemPower);
+	METRIC_COLUMN(powerMetrics, packages);
+	addColumnArray(columns, "powerMetrics.packagePower", offsetof(AllMetrics, powerMetrics.packagePower), RAPL_MAX_PACKAGES);
+	addColumnArray(columns, "powerMetrics.corePower", offsetof(AllMetrics, powerMetrics.corePower), RAPL_MAX_PACKAGES);
+	addColumnArray(columns, "powerMetrics.dramPower", offsetof(AllMetrics, powerMetrics.dramPower), RAPL_MAX_PACKAGES);
+	METRIC_COLUMN(powerMetrics, platformPower);
+	METRIC_COLUMN(powerMetrics, meterPower);
+	METRIC_COLUMN(powerMetrics, meterEnergy);
+	METRIC_COLUMN(powerMetrics, meterPeakPower);
+	METRIC_COLUMN(powerMetrics, meterSamples);
+	METRIC_COLUMN(powerMetrics, gpuPower);
+	METRIC_COLUMN(powerMetrics, gpuTemperature);
+	METRIC_COLUMN(powerMetrics, gpuFanSpeed);
+	METRIC_COLUMN(powerMetrics, gpuMemoryTotal);
+	METRIC_COLUMN(powerMetrics, gpuMemoryUsed);
+	METRIC_COLUMN(powerMetrics, gpuMemoryFree);
+	METRIC_COLUMN(powerMetrics, gpuClocksCurrentSM);
+	METRIC_COLUMN(powerMetrics, gpuClocksCurrentMemory);
+	METRIC_COLUMN(powerMetrics, gpus);
+	for(int i = 0; i < GPU_MAX_DEVICES; i++){
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, name);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, power);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, temperature);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, fanSpeed);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, memoryTotal);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, memoryUsed);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, memoryFree);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, clocksSM);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, clocksMemory);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, utilization);
+		METRIC_ELEMENT_COLUMN(powerMetrics, gpuMetrics, i, memoryUtilization);
+	}
+
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, someAvg10);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, fullAvg10);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, someTotal);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, fullTotal);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, someStall);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, fullStall);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, someStallRatio);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, system, i, fullStallRatio);
+	}
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, someAvg10);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, fullAvg10);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, someTotal);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, fullTotal);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, someStall);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, fullStall);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, someStallRatio);
+		METRIC_ELEMENT_COLUMN(pressureMetrics, cgroup, i, fullStallRatio);
+	}
+	METRIC_COLUMN(pressureMetrics, triggerEvents);
+	METRIC_COLUMN(pressureMetrics, firstTriggerDelay);
+
+	METRIC_COLUMN(jobMetrics, cgroup);
+	METRIC_COLUMN(jobMetrics, cpuUsage);
+	METRIC_COLUMN(jobMetrics, cpuUser);
+	METRIC_COLUMN(jobMetrics, cpuSystem);
+	METRIC_COLUMN(jobMetrics, cpuShare);
+	METRIC_COLUMN(jobMetrics, throttledPeriods);
+	METRIC_COLUMN(jobMetrics, throttledTime);
+	METRIC_COLUMN(jobMetrics, memoryCurrent);
+	METRIC_COLUMN(jobMetrics, memoryAnon);
+	METRIC_COLUMN(jobMetrics, memoryFile);
+	METRIC_COLUMN(jobMetrics, memoryKernel);
+	METRIC_COLUMN(jobMetrics, memoryShmem);
+	METRIC_COLUMN(jobMetrics, pageFaultRate);
+	METRIC_COLUMN(jobMetrics, majorFaultRate);
+	METRIC_COLUMN(jobMetrics, dataReadRate);
+	METRIC_COLUMN(jobMetrics, dataWrittenRate);
+	METRIC_COLUMN(jobMetrics, readRate);
+	METRIC_COLUMN(jobMetrics, writeRate);
+	METRIC_COLUMN(jobMetrics, power);
+
+	// Chunk header and timestamps come first, then every field for every node
+	uint64_t chunkSize = sizeof(ResultsChunkHeader) + resultsColumnSize(sizeof(int64_t), RESULTS_CHUNK_SAMPLES);
+	for(MetricColumn &column : columns){
+		column.chunkOffset = chunkSize;
+		chunkSize += resultsColumnSize(column.width, RESULTS_CHUNK_SAMPLES) * clusterSize;
+	}
+	this->chunk.assign(chunkSize, '\0');
+
+	ResultsFileHeader header = {};
+	memcpy(header.magic, RESULTS_MAGIC, sizeof(header.magic));
+	header.version = RESULTS_VERSION;
+	header.nodes = clusterSize;
+	header.fields = columns.size();
+	header.chunkSamples = RESULTS_CHUNK_SAMPLES;
+	header.chunkSize = chunkSize;
+
+	std::string schema((const char*)&header, sizeof(header));
+	for(const MetricColumn &column : columns){
+		ResultsField field = {};
+		strncpy(field.name, column.name.c_str(), sizeof(field.name) - 1);
+		field.type = column.type;
+		field.width = column.width;
+		schema.append((const char*)&field, sizeof(field));
+	}
+
+	if(!this->output.open(fileName)) return false;
+	this->output.write(schema);
+	return true;
+};
+
+void ColumnarWriter::write(const AllMetrics* allMetricsArray){
+
+	if(this->columns.empty()) return;
+
+	// The deadline of the tick rather than the time of writing, so a row says when it was measured
+	int64_t timestamp = allMetricsArray[0].deadline;
+	char* data = this->chunk.data();
+	memcpy(data + sizeof(ResultsChunkHeader) + this->samples * sizeof(int64_t), &timestamp, sizeof(timestamp));
+
+	for(const MetricColumn &column : this->columns){
+		uint64_t columnSize = resultsColumnSize(column.width, RESULTS_CHUNK_SAMPLES);
+		for(int node = 0; node < this->nodes; node++){
+			char* value = data + column.chunkOffset + node * columnSize + this->samples * column.width;
+			memcpy(value, (const char*)&allMetricsArray[node] + column.offset, column.width);
+		}
+	}
+
+	if(++this->samples == RESULTS_CHUNK_SAMPLES) this->writeChunk();
+};
+
+void ColumnarWriter::writeChunk(){
+
+	ResultsChunkHeader chunkHeader = {};
+	chunkHeader.samples = this->samples;
+	memcpy(this->chunk.data(), &chunkHeader, sizeof(chunkHeader));
+
+	this->output.write(this->chunk);
+	std::fill(this->chunk.begin(), this->chunk.end(), '\0');
+	this->samples = 0;
+};
+
+void ColumnarWriter::close(){
+
+	// The last chunk keeps its full size, so every chunk can still be found by its index
+	if(this->samples) this->writeChunk();
+	this->output.close();
+	this->columns.clear();
+};
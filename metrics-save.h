@@ -10,12 +10,76 @@
 #define METRICS_SAVE_H
 
 // External libraries
-#include <fstream>      // ifstream, ofstream
+#include <string>		// string
+#include <cstdio>		// FILE
+#include <thread>		// thread
+#include <mutex>		// mutex, unique_lock
+#include <condition_variable>	// condition_variable
+#include <vector>		// vector
 // Internal headers
 #include "metrics.h"
-#include "json.hpp"
+#include "results-format.h"
+#include "target-launcher.h"
 
-// Write to file function
-nlohmann::json metricsToJson(AllMetrics*, int);
+#define WRITER_BUFFER_SIZE (1 << 20)		// Size of the stdio buffer of the results file in bytes
 
-#endif
\ No newline at end of file
+// One record of the whole cluster as a single compact JSON line (NDJSON), appended to the string.
+// Only the sections of the collectors sampled for the record are written, each with its own timestamp.
+void appendMetricsLine(std::string&, const AllMetrics*, int);
+// Launched command with its start, end and exit status on every node, as one more line
+void appendLaunchLine(std::string&, const std::string&, const LaunchRecord*, int);
+
+// Results file written by its own thread. write() only copies the line into a pending buffer,
+// the thread swaps it out and writes it, so the sampling loop never waits for the disk.
+// Every batch is flushed, so a killed run keeps everything except the last sample.
+class ResultWriter {
+public:
+	ResultWriter();
+	ResultWriter(const ResultWriter&) = delete;
+	ResultWriter& operator=(const ResultWriter&) = delete;
+	~ResultWriter();
+
+	bool open(const std::string&);
+	void write(const std::string&);
+	void close();
+
+private:
+	std::FILE* file;
+	std::thread writerThread;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::string pending;			// Lines not yet taken by the writer thread
+	bool closing;
+
+	void run();
+};
+
+// Columnar binary results (see results-format.h), one column per field of AllMetrics.
+// Samples are collected into a chunk in memory, full chunks go through a ResultWriter.
+class ColumnarWriter {
+public:
+	ColumnarWriter();
+
+	bool open(const std::string&, int);
+	void write(const AllMetrics*);
+	void close();
+
+private:
+	struct MetricColumn {
+		std::string name;
+		ResultsColumnType type;
+		uint32_t width;
+		size_t offset;				// Place of the field in AllMetrics
+		uint64_t chunkOffset;			// Place of the column of node 0 in a chunk
+	};
+
+	ResultWriter output;
+	std::vector<MetricColumn> columns;
+	std::string chunk;
+	int nodes;
+	uint32_t samples;			// Samples in the chunk that is being filled
+
+	void writeChunk();
+};
+
+#endif
@@ -10,53 +10,611 @@
 #include <iostream>	// cin, cout
 #include <string>	// string, substr
 #include <sstream>	// stringstream
-#include <array>	// array
-#include <memory>	// pipe, decltype
+#include <algorithm>	// min, max, fill
+#include <iterator>	// size
+#include <cstring>	// memcpy, memset, strcmp, strncpy, strlen
+#include <initializer_list>	// initializer_list
+#include <cmath>	// sqrt
+#include <sys/resource.h>	// getrusage, rusage, RUSAGE_THREAD
+#include <unistd.h>	// sysconf
+#include <poll.h>	// poll, pollfd
 // Internal headers
 #include "metrics.h"
+#include "procfs-reader.h"
+#include "perf-counters.h"
+#include "process-tree.h"
 
 #define KILOBYTE 1024
 
+// Cumulative counters of the sources of one collector, all of them read at the same instant
+struct CounterSnapshot {
+	uint64_t timestamp;			// CLOCK_MONOTONIC in ns
+	int64_t realTime;			// CLOCK_REALTIME in ns, tags the section in the results
+	uint64_t cpuTimes[TOPOLOGY_CPU_TIMES];	// user, nice, system, idle, iowait, irq, softirq, steal, guest in USER_HZ
+	CpuTimesReading cpus;			// The same times of every logical CPU
+	CpuFrequencyReading frequency;		// Frequency, idle state and throttle counters of every logical CPU
+	uint64_t interrupts;			// intr from /proc/stat
+	uint64_t softInterrupts;		// softirq from /proc/stat
+	InterruptReading irqs;			// Busiest IRQ/CPU pairs since the previous snapshot
+	uint64_t contextSwitches;		// ctxt from /proc/stat
+	uint64_t processesCreated;		// processes (forks since boot) from /proc/stat
+	int processesRunning;			// procs_running from /proc/stat
+	int processesBlocked;			// procs_blocked from /proc/stat
+	int processesAll;			// Scheduling entities from /proc/loadavg
+	uint64_t processDataRead;		// rchar of the process tree in bytes
+	uint64_t processDataWritten;		// wchar of the process tree in bytes
+	uint64_t processReadCalls;		// syscr of the process tree
+	uint64_t processWriteCalls;		// syscw of the process tree
+	uint64_t processCpuTime;		// User and system time of the process tree in ms
+	uint64_t processContextSwitches;	// Context switches of the process tree
+	int processes;				// Live processes of the tree
+	int processThreads;			// Threads of the live processes
+	uint64_t processResident;		// Resident memory of the live processes in bytes
+	BlockDeviceReading disks;		// Counters of every block device from /proc/diskstats
+	uint64_t pageIn;			// pgpgin from /proc/vmstat in kB
+	uint64_t pageOut;			// pgpgout from /proc/vmstat in kB
+	uint64_t pageFaults;			// pgfault
+	uint64_t pageFaultsMajor;		// pgmajfault
+	uint64_t pageFree;			// pgfree
+	uint64_t pageActivate;			// pgactivate
+	uint64_t pageDeactivate;		// pgdeactivate
+	uint64_t thpFaultAlloc;			// thp_fault_alloc, huge pages given on a page fault
+	uint64_t thpFaultFallback;		// thp_fault_fallback, faults that got small pages instead
+	uint64_t thpCollapseAlloc;		// thp_collapse_alloc, huge pages assembled by khugepaged
+	uint64_t thpSplitPage;			// thp_split_page
+	uint64_t compactStall;			// compact_stall, allocations that ran direct compaction
+	uint64_t compactFail;			// compact_fail
+	uint64_t compactSuccess;		// compact_success
+	uint64_t numaPteUpdates;		// numa_pte_updates, PTEs marked for NUMA hinting faults
+	uint64_t numaHintFaults;		// numa_hint_faults
+	uint64_t numaHintFaultsLocal;		// numa_hint_faults_local
+	uint64_t numaPagesMigrated;		// numa_pages_migrated by NUMA balancing
+	NetworkReading network;			// Counters of every selected interface and of TCP and UDP
+	InfinibandReading infiniband;		// Port counters of every InfiniBand/RDMA device
+	PressureReading pressure;		// PSI of the node and of the cgroup of the monitored process
+	CgroupReading job;			// CPU, memory and I/O counters of the cgroup of the job
+	PerfCounterReading perf;		// Hardware counter rates since the previous snapshot
+	RaplReading rapl;			// Power of the RAPL domains since the previous snapshot
+	GpuReading gpu;				// Power since the previous snapshot, clocks and memory of every GPU
+
+	CounterSnapshot();
+};
+
+// Files that stay open for the whole run and are re-read with pread() on every sample
+static ProcfsFile loadavgFile("/proc/loadavg");
+static ProcfsFile statFile("/proc/stat");
+static ProcfsFile meminfoFile("/proc/meminfo");
+static ProcfsFile vmstatFile("/proc/vmstat");
+
+// Every collector keeps its last two snapshots, one of them is current and the other one previous
+static CounterSnapshot groupSnapshots[METRIC_GROUPS][2];
+static int currentSlots[METRIC_GROUPS];
+// Snapshots of the collector whose section is being calculated
+static CounterSnapshot *previousSnapshot = &groupSnapshots[0][1], *currentSnapshot = &groupSnapshots[0][0];
+
+// Hardware counters are opened on every CPU when the application starts
+static PerfCounters perfCounters;
+static bool perfCountersOpen = perfCounters.open();
+
+// Online CPUs and their cores, sockets and NUMA nodes are found once
+static CpuTopology cpuTopology;
+static bool cpuTopologyOpen = cpuTopology.open(TOPOLOGY_CPU_ROOT, TOPOLOGY_NODE_ROOT);
+
+// Frequency, idle state and throttle files of the same CPUs, and their MSRs when they can be read
+static CpuFrequency cpuFrequency;
+static bool cpuFrequencyOpen = cpuTopologyOpen && cpuFrequency.open(cpuTopology, TOPOLOGY_CPU_ROOT, MSR_ROOT);
+// Nominal frequency in MHz, -1 if not known
+static float baseFrequency = cpuFrequency.baseFrequency();
+
+// /proc/interrupts and /proc/softirqs stay open, the previous counters of every IRQ stay in the collector
+static InterruptCounters interruptCounters;
+static bool interruptCountersOpen = interruptCounters.open(INTERRUPTS_FILE, SOFTIRQS_FILE);
+
+// Block devices are listed once, /proc/diskstats stays open
+static BlockDevices blockDevices;
+static bool blockDevicesOpen = blockDevices.open(BLOCK_ROOT);
+
+// Interfaces are selected once, every one except NETWORK_EXCLUDE until it is changed
+static NetworkInterfaces networkInterfaces;
+static bool networkInterfacesOpen = networkInterfaces.open("", NETWORK_EXCLUDE);
+
+// InfiniBand ports are listed once, their counter files stay open
+static InfinibandPorts infinibandPorts;
+static bool infinibandPortsOpen = infinibandPorts.open(INFINIBAND_ROOT);
+
+// RAPL domains of every package are found once, their energy counters stay open
+static RaplPower raplPower;
+static bool raplOpen = raplPower.open(RAPL_ROOT);
+
+// The power meter is read by its own thread once it is set with setPowerMeter()
+static PowerMeter powerMeter;
+static bool powerMeterOpen = false;
+
+// NVML is loaded once and disables the GPU metrics when the library or the GPUs are missing
+static GpuDevices gpuDevices;
+static bool gpuDevicesOpen = gpuDevices.open(NVML_LIBRARY);
+
+// Pressure files of the node stay open, the cgroup ones follow the monitored process
+static PressureStall pressureStall;
+static bool pressureOpen = pressureStall.open(PRESSURE_ROOT);
+static bool pressureCgroupOpen = pressureStall.setProcess(GPROCESSID, CGROUP_ROOT);
+
+// Accounting files of the job follow the monitored process too, unless a cgroup is given with setJobCgroup()
+static CgroupAccounting jobCgroup;
+static bool jobCgroupOpen = jobCgroup.setProcess(GPROCESSID, CGROUP_ROOT);
+static bool jobCgroupGiven = false;
+
+// Process tree of GPROCESSID unless a target is given with setTargetProcess()
+static ProcessTree processTree;
+static bool processTreeOpen = processTree.open(GPROCESSID);
+
+// Names of the collectors for --collector-period, in the order of MetricGroup
+static const char* metricGroupNames[METRIC_GROUPS] = {
+	"system", "processor", "io", "process", "memory", "network", "power", "pressure", "job"};
+
+// Sum of the packages that have a given domain, -1 if none of them has it
+static float sumPackages(const double* power, int packages){
+
+	float sum = -1;
+	for(int i = 0; i < packages; i++)
+		if(power[i] >= 0) sum = (sum < 0 ? 0 : sum) + power[i];
+	return sum;
+};
+
+CounterSnapshot::CounterSnapshot(){
+	this->timestamp = COUNTER_MISSING;
+	this->realTime = 0;
+	for(uint64_t &time : this->cpuTimes) time = COUNTER_MISSING;
+	this->cpus.cpus = 0;
+	this->frequency.cpus = 0;
+	this->interrupts = COUNTER_MISSING;
+	this->softInterrupts = COUNTER_MISSING;
+	this->irqs.cpus = 0;
+	for(int kind = 0; kind < INTERRUPT_KINDS; kind++){
+		this->irqs.pairs[kind] = 0;
+		this->irqs.busiestCpu[kind] = -1;
+		this->irqs.busiestCpuRate[kind] = -1;
+	}
+	this->irqs.elapsedTime = 0;
+	this->contextSwitches = COUNTER_MISSING;
+	this->processesCreated = COUNTER_MISSING;
+	this->processesRunning = -1;
+	this->processesBlocked = -1;
+	this->processesAll = -1;
+	this->processDataRead = COUNTER_MISSING;
+	this->processDataWritten = COUNTER_MISSING;
+	this->processReadCalls = COUNTER_MISSING;
+	this->processWriteCalls = COUNTER_MISSING;
+	this->processCpuTime = COUNTER_MISSING;
+	this->processContextSwitches = COUNTER_MISSING;
+	this->processes = -1;
+	this->processThreads = -1;
+	this->processResident = COUNTER_MISSING;
+	this->disks.devices = 0;
+	this->pageIn = COUNTER_MISSING;
+	this->pageOut = COUNTER_MISSING;
+	this->pageFaults = COUNTER_MISSING;
+	this->pageFaultsMajor = COUNTER_MISSING;
+	this->pageFree = COUNTER_MISSING;
+	this->pageActivate = COUNTER_MISSING;
+	this->pageDeactivate = COUNTER_MISSING;
+	this->thpFaultAlloc = COUNTER_MISSING;
+	this->thpFaultFallback = COUNTER_MISSING;
+	this->thpCollapseAlloc = COUNTER_MISSING;
+	this->thpSplitPage = COUNTER_MISSING;
+	this->compactStall = COUNTER_MISSING;
+	this->compactFail = COUNTER_MISSING;
+	this->compactSuccess = COUNTER_MISSING;
+	this->numaPteUpdates = COUNTER_MISSING;
+	this->numaHintFaults = COUNTER_MISSING;
+	this->numaHintFaultsLocal = COUNTER_MISSING;
+	this->numaPagesMigrated = COUNTER_MISSING;
+	this->network.interfaces = 0;
+	this->network.tcpSegmentsSent = COUNTER_MISSING;
+	this->network.tcpRetransmits = COUNTER_MISSING;
+	this->network.tcpErrors = COUNTER_MISSING;
+	this->network.udpErrors = COUNTER_MISSING;
+	this->infiniband.ports = 0;
+	for(PressureCounters &counters : this->pressure.system) counters = {-1, -1, COUNTER_MISSING, COUNTER_MISSING};
+	for(PressureCounters &counters : this->pressure.cgroup) counters = {-1, -1, COUNTER_MISSING, COUNTER_MISSING};
+	this->pressure.triggerEvents = 0;
+	this->job = {COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING,
+		COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING,
+		COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING, COUNTER_MISSING};
+	this->pressure.firstTrigger = 0;
+	for(double &total : this->perf.totals) total = -1;
+	for(double &rate : this->perf.rates) rate = -1;
+	this->perf.elapsedTime = 0;
+	this->rapl.packages = 0;
+	for(auto &domain : this->rapl.power)
+		for(double &power : domain) power = -1;
+	this->rapl.elapsedTime = 0;
+	this->gpu.devices = 0;
+	this->gpu.elapsedTime = 0;
+};
+
+// Per second rate of a counter between the two snapshots, -1 if one of them is missing it
+static double deltaRate(uint64_t previous, uint64_t current){
+
+	if(previous == COUNTER_MISSING || current == COUNTER_MISSING || current < previous) return -1;
+	if(currentSnapshot->timestamp <= previousSnapshot->timestamp) return -1;
+
+	return (current - previous) / ((currentSnapshot->timestamp - previousSnapshot->timestamp) / 1e9);
+};
+
+static double counterRate(uint64_t CounterSnapshot::*counter){
+	return deltaRate(previousSnapshot->*counter, currentSnapshot->*counter);
+};
+
+// Increase of one counter per increase of another (e.g. ms spent reading per read), 0 if nothing happened
+static double rateRatio(double counterRate, double eventsRate){
+
+	if(counterRate < 0 || eventsRate < 0) return -1;
+	return eventsRate > 0 ? counterRate / eventsRate : 0;
+};
+
+// Selects the snapshots of a collector, so the rates of its section are calculated between them
+static void selectSnapshots(int group){
+	currentSnapshot = &groupSnapshots[group][currentSlots[group]];
+	previousSnapshot = &groupSnapshots[group][currentSlots[group] ^ 1];
+};
+
+void takeSnapshot(uint32_t groups){
+
+	// /proc/stat and the process tree serve several collectors, they are read once for all of them
+	std::string_view stat, text, line;
+	if(groups & (METRIC_BIT(METRIC_SYSTEM) | METRIC_BIT(METRIC_PROCESSOR) | METRIC_BIT(METRIC_JOB))) stat = statFile.read();
+	ProcessTreeReading tree;
+	bool treeRead = (groups & (METRIC_BIT(METRIC_INPUT_OUTPUT) | METRIC_BIT(METRIC_PROCESS))) && processTree.read(tree);
+	uint64_t value;
+
+	for(int group = 0; group < METRIC_GROUPS; group++){
+		if(!(groups & METRIC_BIT(group))) continue;
+		currentSlots[group] ^= 1;
+		selectSnapshots(group);
+		*currentSnapshot = CounterSnapshot();
+		CounterSnapshot &snapshot = *currentSnapshot;
+		snapshot.timestamp = monotonicTime();
+		snapshot.realTime = realTime();
+
+		switch(group){
+		case METRIC_SYSTEM:
+			findKeyValue(stat, "intr", snapshot.interrupts);
+			findKeyValue(stat, "softirq", snapshot.softInterrupts);
+			findKeyValue(stat, "ctxt", snapshot.contextSwitches);
+			findKeyValue(stat, "processes", snapshot.processesCreated);
+			if(findKeyValue(stat, "procs_running", value)) snapshot.processesRunning = value;
+			if(findKeyValue(stat, "procs_blocked", value)) snapshot.processesBlocked = value;
+
+			// Fourth field of /proc/loadavg is "running/all", /proc/stat has no total
+			text = loadavgFile.read();
+			nextToken(text);
+			nextToken(text);
+			nextToken(text);
+			if(parseUnsigned(text, value) && !text.empty() && text[0] == '/'){
+				text.remove_prefix(1);
+				if(parseUnsigned(text, value)) snapshot.processesAll = value;
+			}
+
+			// The IRQ matrices keep their previous values, so they cover the same interval
+			if(interruptCountersOpen) interruptCounters.read(snapshot.irqs, snapshot.timestamp);
+			break;
+
+		case METRIC_PROCESSOR:
+			// First line of /proc/stat is the sum over all processors
+			if(findLine(stat, "cpu ", line)) parseUnsignedList(line, snapshot.cpuTimes, TOPOLOGY_CPU_TIMES);
+			if(cpuTopologyOpen) cpuTopology.read(stat, snapshot.cpus);
+			if(cpuFrequencyOpen) cpuFrequency.read(snapshot.frequency);
+			if(perfCountersOpen) perfCounters.read(snapshot.perf);
+			break;
+
+		case METRIC_INPUT_OUTPUT:
+		case METRIC_PROCESS:
+			// Reading /proc/[pid]/io of other users' processes requires root
+			if(treeRead){
+				snapshot.processDataRead = tree.dataRead;
+				snapshot.processDataWritten = tree.dataWritten;
+				snapshot.processReadCalls = tree.readCalls;
+				snapshot.processWriteCalls = tree.writeCalls;
+				snapshot.processCpuTime = tree.cpuTime;
+				snapshot.processContextSwitches = tree.contextSwitches;
+				snapshot.processes = tree.processes;
+				snapshot.processThreads = tree.threads;
+				snapshot.processResident = tree.residentMemory;
+			}
+			if(group == METRIC_INPUT_OUTPUT && blockDevicesOpen) blockDevices.read(snapshot.disks);
+			break;
+
+		case METRIC_MEMORY: {
+			// THP, compaction and NUMA balancing counters are missing when the kernel is built without them
+			const KeyValueField vmstatFields[] = {
+				{"pgpgin", &snapshot.pageIn},
+				{"pgpgout", &snapshot.pageOut},
+				{"pgfault", &snapshot.pageFaults},
+				{"pgmajfault", &snapshot.pageFaultsMajor},
+				{"pgfree", &snapshot.pageFree},
+				{"pgactivate", &snapshot.pageActivate},
+				{"pgdeactivate", &snapshot.pageDeactivate},
+				{"thp_fault_alloc", &snapshot.thpFaultAlloc},
+				{"thp_fault_fallback", &snapshot.thpFaultFallback},
+				{"thp_collapse_alloc", &snapshot.thpCollapseAlloc},
+				{"thp_split_page", &snapshot.thpSplitPage},
+				{"compact_stall", &snapshot.compactStall},
+				{"compact_fail", &snapshot.compactFail},
+				{"compact_success", &snapshot.compactSuccess},
+				{"numa_pte_updates", &snapshot.numaPteUpdates},
+				{"numa_hint_faults", &snapshot.numaHintFaults},
+				{"numa_hint_faults_local", &snapshot.numaHintFaultsLocal},
+				{"numa_pages_migrated", &snapshot.numaPagesMigrated}};
+			findKeyValues(vmstatFile.read(), vmstatFields, std::size(vmstatFields));
+			break;
+		}
+
+		case METRIC_NETWORK:
+			if(networkInterfacesOpen) networkInterfaces.read(snapshot.network);
+			if(infinibandPortsOpen) infinibandPorts.read(snapshot.infiniband);
+			break;
+
+		case METRIC_POWER:
+			// RAPL and the GPU energy counters keep their previous values, so they cover the same interval
+			if(raplOpen) raplPower.read(snapshot.rapl, snapshot.timestamp);
+			if(gpuDevicesOpen) gpuDevices.read(snapshot.gpu, snapshot.timestamp);
+			break;
+
+		case METRIC_PRESSURE:
+			if(pressureOpen) pressureStall.read(snapshot.pressure);
+			break;
+
+		case METRIC_JOB:
+			// The share of the node is taken against the busy time of all CPUs in the same interval
+			if(findLine(stat, "cpu ", line)) parseUnsignedList(line, snapshot.cpuTimes, TOPOLOGY_CPU_TIMES);
+			if(jobCgroupOpen) jobCgroup.read(snapshot.job);
+			break;
+		}
+	}
+};
+
+bool setTargetProcess(int pid){
+
+	processTreeOpen = processTree.open(pid);
+	if(jobCgroupGiven) return processTreeOpen;
+	pressureCgroupOpen = pressureStall.setProcess(pid, CGROUP_ROOT);
+	jobCgroupOpen = jobCgroup.setProcess(pid, CGROUP_ROOT);
+	return processTreeOpen;
+};
+
+bool setJobCgroup(const std::string &directory){
+
+	// The pressure files of the cgroup are read from the same directory
+	jobCgroupGiven = true;
+	jobCgroupOpen = jobCgroup.open(directory);
+	pressureCgroupOpen = pressureStall.setCgroup(jobCgroup.directory());
+	return jobCgroupOpen;
+};
+
+bool setPowerMeter(const std::string &address, int period){
+
+	powerMeterOpen = powerMeter.open(address, period);
+	return powerMeterOpen;
+};
+
+bool setGpuLibrary(const std::string &library){
+
+	gpuDevicesOpen = gpuDevices.open(library);
+	return gpuDevicesOpen;
+};
+
+bool setNetworkInterfaces(const std::string &include, const std::string &exclude){
+
+	networkInterfacesOpen = networkInterfaces.open(include, exclude);
+	return networkInterfacesOpen;
+};
+
+bool setPressureTriggers(uint64_t stallTime){
+	return pressureOpen && pressureStall.setTriggers(stallTime);
+};
+
+bool waitForPressure(int timeout, int descriptor){
+
+	if(pressureStall.hasTriggers()) return pressureStall.waitForTrigger(timeout, descriptor);
+	pollfd waiting = {descriptor, POLLIN, 0};
+	if(descriptor >= 0) poll(&waiting, 1, timeout);
+	return false;
+};
+
+void getAllMetrics(AllMetrics &allMetrics, uint32_t groups){
+
+	takeSnapshot(groups);
+	allMetrics.groups = groups;
+	for(int group = 0; group < METRIC_GROUPS; group++){
+		allMetrics.timestamps[group] = 0;
+		if(!(groups & METRIC_BIT(group))) continue;
+		selectSnapshots(group);
+		allMetrics.timestamps[group] = currentSnapshot->realTime;
+
+		// The record is reused from tick to tick, a section starts from its defaults so that a value
+		// that could not be read this time is -1 or COUNTER_MISSING instead of one of an older sample
+		switch(group){
+		case METRIC_SYSTEM:
+			allMetrics.systemMetrics = SystemMetrics();
+			getSystemMetrics(allMetrics.systemMetrics);
+			break;
+		case METRIC_PROCESSOR:
+			allMetrics.processorMetrics = ProcessorMetrics();
+			getProcessorMetrics(allMetrics.processorMetrics);
+			break;
+		case METRIC_INPUT_OUTPUT:
+			allMetrics.inputOutputMetrics = InputOutputMetrics();
+			getInputOutputMetrics(allMetrics.inputOutputMetrics);
+			break;
+		case METRIC_PROCESS:
+			allMetrics.processMetrics = ProcessMetrics();
+			getProcessMetrics(allMetrics.processMetrics);
+			break;
+		case METRIC_MEMORY:
+			allMetrics.memoryMetrics = MemoryMetrics();
+			getMemoryMetrics(allMetrics.memoryMetrics);
+			break;
+		case METRIC_NETWORK:
+			allMetrics.networkMetrics = NetworkMetrics();
+			getNetworkMetrics(allMetrics.networkMetrics);
+			break;
+		case METRIC_POWER:
+			allMetrics.powerMetrics = PowerMetrics();
+			getPowerMetrics(allMetrics.powerMetrics);
+			break;
+		case METRIC_PRESSURE:
+			allMetrics.pressureMetrics = PressureMetrics();
+			getPressureMetrics(allMetrics.pressureMetrics);
+			break;
+		case METRIC_JOB:
+			allMetrics.jobMetrics = JobMetrics();
+			getJobMetrics(allMetrics.jobMetrics);
+			break;
+		}
+	}
+};
+
+void mergeMetrics(AllMetrics &latest, const AllMetrics &record){
+
+	latest.groups = record.groups;
+	latest.deadline = record.deadline;
+	latest.jitter = record.jitter;
+	latest.sampleRealTime = record.sampleRealTime;
+	latest.sampleMonotonicTime = record.sampleMonotonicTime;
+	latest.clockOffset = record.clockOffset;
+	latest.clockDrift = record.clockDrift;
+	for(int group = 0; group < METRIC_GROUPS; group++){
+		if(!(record.groups & METRIC_BIT(group))) continue;
+		latest.timestamps[group] = record.timestamps[group];
+
+		switch(group){
+		case METRIC_SYSTEM: latest.systemMetrics = record.systemMetrics; break;
+		case METRIC_PROCESSOR: latest.processorMetrics = record.processorMetrics; break;
+		case METRIC_INPUT_OUTPUT: latest.inputOutputMetrics = record.inputOutputMetrics; break;
+		case METRIC_PROCESS: latest.processMetrics = record.processMetrics; break;
+		case METRIC_MEMORY: latest.memoryMetrics = record.memoryMetrics; break;
+		case METRIC_NETWORK: latest.networkMetrics = record.networkMetrics; break;
+		case METRIC_POWER: latest.powerMetrics = record.powerMetrics; break;
+		case METRIC_PRESSURE: latest.pressureMetrics = record.pressureMetrics; break;
+		case METRIC_JOB: latest.jobMetrics = record.jobMetrics; break;
+		}
+	}
+};
+
+void correctTimestamps(AllMetrics &record, int64_t clockOffset, double clockDrift){
+
+	record.clockOffset = clockOffset;
+	record.clockDrift = clockDrift;
+	for(int group = 0; group < METRIC_GROUPS; group++)
+		if(record.groups & METRIC_BIT(group)) record.timestamps[group] -= clockOffset;
+};
+
+int countCpus(){
+	return cpuTopology.cpus();
+};
+
+int findMetricGroup(const std::string &name){
+
+	for(int group = 0; group < METRIC_GROUPS; group++)
+		if(name == metricGroupNames[group]) return group;
+	return -1;
+};
+
 SystemMetrics::SystemMetrics(){
 	this->processesRunning = -1;
 	this->processesAll = -1;
 	this->processesBlocked = -1;
+	this->contextSwitches = COUNTER_MISSING;
+	this->interrupts = COUNTER_MISSING;
+	this->processesCreated = COUNTER_MISSING;
 	this->contextSwitchRate = -1;
 	this->interruptRate = -1;
+	this->processCreationRate = -1;
+	this->softInterrupts = COUNTER_MISSING;
+	this->softInterruptRate = -1;
+	this->interruptCpu = -1;
+	this->interruptCpuRate = -1;
+	this->softInterruptCpu = -1;
+	this->softInterruptCpuRate = -1;
+	this->topInterrupts = 0;
+	this->topSoftInterrupts = 0;
+};
+
+InterruptMetrics::InterruptMetrics(){
+	this->name[0] = '\0';
+	this->device[0] = '\0';
+	this->cpu = -1;
+	this->count = COUNTER_MISSING;
+	this->rate = -1;
 };
 
 void SystemMetrics::printSystemMetrics(){
 
 	std::cout << "\n\t[SYSTEM METRICS]\n\n"
+		<< "Interrupts = " << this->interrupts << "\n"
 		<< "Interrupt Rate = " << this->interruptRate << " interrupts/sec\n"
+		<< "Context Switches = " << this->contextSwitches << "\n"
 		<< "Context Switch Rate = " << this->contextSwitchRate << " switches/sec\n"
+		<< "Processes Created = " << this->processesCreated << "\n"
+		<< "Process Creation Rate = " << this->processCreationRate << " processes/sec\n"
 		<< "All Processes = " << this->processesAll << "\n"
 		<< "Running Processes = " << this->processesRunning << "\n"
-		<< "Blocked Processes = " << this->processesBlocked << "\n";
+		<< "Blocked Processes = " << this->processesBlocked << "\n"
+		<< "Softirqs = " << this->softInterrupts << "\n"
+		<< "Softirq Rate = " << this->softInterruptRate << " softirqs/sec\n"
+		<< "Busiest IRQ CPU = " << this->interruptCpu << " (" << this->interruptCpuRate << " interrupts/sec)\n"
+		<< "Busiest Softirq CPU = " << this->softInterruptCpu << " (" << this->softInterruptCpuRate << " softirqs/sec)\n";
+
+	for(int i = 0; i < this->topInterrupts; i++){
+		const InterruptMetrics &interrupt = this->interruptMetrics[i];
+		std::cout << "IRQ " << interrupt.name << " on CPU " << interrupt.cpu << ": " << interrupt.rate << " interrupts/sec " << interrupt.device << "\n";
+	}
+	for(int i = 0; i < this->topSoftInterrupts; i++){
+		const InterruptMetrics &interrupt = this->softInterruptMetrics[i];
+		std::cout << interrupt.name << " on CPU " << interrupt.cpu << ": " << interrupt.rate << " softirqs/sec\n";
+	}
+};
+
+// Pairs of one kind from the collector, they are already sorted
+static int copyInterruptPairs(const InterruptReading &reading, InterruptKind kind, InterruptMetrics* interrupts){
+
+	for(int i = 0; i < std::min(reading.pairs[kind], INTERRUPT_TOP); i++){
+		InterruptMetrics &interrupt = interrupts[i];
+		const InterruptPair &pair = reading.top[kind][i];
+		memcpy(interrupt.name, pair.name, INTERRUPT_NAME_LENGTH);
+		memcpy(interrupt.device, pair.device, INTERRUPT_DEVICE_LENGTH);
+		interrupt.cpu = pair.cpu;
+		interrupt.count = pair.count;
+		interrupt.rate = pair.rate;
+	}
+	return reading.pairs[kind];
 };
 
 void getSystemMetrics(SystemMetrics &systemMetrics){
 
-	const char* command = "vmstat";
-	std::string output = exec(command), temp;
+	systemMetrics.interrupts = currentSnapshot->interrupts;					// number of interrupts
+	systemMetrics.contextSwitches = currentSnapshot->contextSwitches;			// number of context switches
+	systemMetrics.interruptRate = counterRate(&CounterSnapshot::interrupts);		// interrupts/sec
+	systemMetrics.contextSwitchRate = counterRate(&CounterSnapshot::contextSwitches);	// context switches/sec
+	systemMetrics.processesCreated = currentSnapshot->processesCreated;			// number of forks
+	systemMetrics.processCreationRate = counterRate(&CounterSnapshot::processesCreated);	// forks/sec
+	systemMetrics.softInterrupts = currentSnapshot->softInterrupts;				// number of softirqs
+	systemMetrics.softInterruptRate = counterRate(&CounterSnapshot::softInterrupts);	// softirqs/sec
 
-	temp = output.substr(219, 4);
-	systemMetrics.interruptRate = std::stoi(temp);		// interrupts/sec
-	temp = output.substr(224, 4);
-	systemMetrics.contextSwitchRate = std::stoi(temp);	// context switches/sec
-	
-	command = "cat /proc/loadavg | cut -d ' ' -f 4";
-	output = exec(command);
-
-	size_t slashPosition = output.find('/');
-	temp = output.substr(0, slashPosition);
-	systemMetrics.processesRunning = std::stoi(temp);	// number of processes
-	temp = output.substr(slashPosition+1);
-	systemMetrics.processesAll = std::stoi(temp);		// number of processes
- 
-	command = "ps -eo state | grep -c '^D'";
-	output = exec(command);
-	systemMetrics.processesBlocked = std::stoi(output);	// number of processes
+	// Rates of single IRQs on single CPUs come from the collector, only the busiest pairs are kept
+	const InterruptReading &irqs = currentSnapshot->irqs;
+	systemMetrics.interruptCpu = irqs.busiestCpu[INTERRUPT_HARD];				// CPU number
+	systemMetrics.interruptCpuRate = irqs.busiestCpuRate[INTERRUPT_HARD];			// interrupts/sec
+	systemMetrics.softInterruptCpu = irqs.busiestCpu[INTERRUPT_SOFT];			// CPU number
+	systemMetrics.softInterruptCpuRate = irqs.busiestCpuRate[INTERRUPT_SOFT];		// softirqs/sec
+	systemMetrics.topInterrupts = copyInterruptPairs(irqs, INTERRUPT_HARD, systemMetrics.interruptMetrics);
+	systemMetrics.topSoftInterrupts = copyInterruptPairs(irqs, INTERRUPT_SOFT, systemMetrics.softInterruptMetrics);
+
+	// The kernel counts these at the snapshot, no need to walk every process
+	systemMetrics.processesRunning = currentSnapshot->processesRunning;	// number of threads
+	systemMetrics.processesBlocked = currentSnapshot->processesBlocked;	// number of threads
+	systemMetrics.processesAll = currentSnapshot->processesAll;		// number of threads
 
 	//systemMetrics.printSystemMetrics();
 };
@@ -71,182 +629,525 @@ ProcessorMetrics::ProcessorMetrics(){
 	this->timeSoftIRQ = -1;
 	this->timeSteal = -1;
 	this->timeGuest = -1;
-	this->instructionsRetired = -1;
-	this->cycles = -1;
+	this->instructionsRetired = COUNTER_MISSING;
+	this->cycles = COUNTER_MISSING;
+	this->instructionsPerSecond = -1;
+	this->cyclesPerSecond = -1;
 	this->frequencyRelative = -1;
 	this->unhaltedFrequency = -1;
-	this->cacheL2Misses = -1;
-	this->cacheL2Requests = -1;
-	this->cacheLLCLoadMisses = -1;
+	this->cacheL2Requests = COUNTER_MISSING;
+	this->cacheL2Misses = COUNTER_MISSING;
+	this->cacheLLCLoads = COUNTER_MISSING;
+	this->cacheLLCStores = COUNTER_MISSING;
+	this->cacheLLCLoadMisses = COUNTER_MISSING;
+	this->cacheLLCStoreMisses = COUNTER_MISSING;
+	this->cacheL2RequestsPerSecond = -1;
+	this->cacheL2MissesPerSecond = -1;
+	this->cacheLLCLoadsPerSecond = -1;
+	this->cacheLLCStoresPerSecond = -1;
+	this->cacheLLCLoadMissesPerSecond = -1;
+	this->cacheLLCStoreMissesPerSecond = -1;
 	this->cacheLLCLoadMissRate = -1;
-	this->cacheLLCLoads = -1;
-	this->cacheLLCStoreMisses = -1;
 	this->cacheLLCStoreMissRate = -1;
-	this->cacheLLCStores = -1;
+	this->cpus = 0;
+	this->cores = 0;
+	this->sockets = 0;
+	this->numaNodes = 0;
+	this->cpuBusyMax = -1;
+	this->cpuBusyMin = -1;
+	this->cpuBusyDeviation = -1;
+	this->coreBusyMax = -1;
+	this->coreBusyMin = -1;
+	for(float &busy : this->socketBusy) busy = -1;
+	for(float &busy : this->nodeBusy) busy = -1;
+	this->frequencyMean = -1;
+	this->frequencyMin = -1;
+	this->frequencyMax = -1;
+	this->effectiveFrequency = -1;
+	this->coreThrottleRate = -1;
+	this->packageThrottleRate = -1;
+	this->coreThrottleTime = -1;
+	this->packageThrottleTime = -1;
+	this->idleStates = 0;
+	memset(this->idleStateNames, 0, sizeof(this->idleStateNames));
+	for(float &residency : this->idleStateResidency) residency = -1;
+	for(float &rate : this->idleStateRate) rate = -1;
+};
+
+CpuMetrics::CpuMetrics(){
+	this->cpu = -1;
+	this->core = -1;
+	this->socket = -1;
+	this->node = -1;
+	this->busy = -1;
+	this->user = -1;
+	this->system = -1;
+	this->ioWait = -1;
+	this->frequency = -1;
+	this->effectiveFrequency = -1;
+	this->idleResidency = -1;
+	this->throttleTime = -1;
 };
 
 void ProcessorMetrics::printProcessorMetrics(){
 
 	std::cout << "\n\t[PROCESSOR METRICS]\n\n"
-		<< "Time User = " << this->timeUser  << "\n"
-		<< "Time Nice = " << this->timeNice << "\n"
-		<< "Time System = " << this->timeSystem << "\n"
-		<< "Time Idle = " << this->timeIdle << "\n"
-		<< "Time I/O Wait = " << this->timeIoWait << "\n"
-		<< "Time IRQ = " << this->timeIRQ << "\n"
-		<< "Time Soft IRQ = " << this->timeSoftIRQ << "\n"
-		<< "Time Steal = " << this->timeSteal << "\n"
-		<< "Time Guest = " << this->timeGuest << "\n"
-		<< "Retired Instructions = " << this->instructionsRetired << "\n"
-		<< "Cycles = " << this->cycles << "\n"
-		<< "Relative Frequency = " << this->frequencyRelative << "\n"
-		<< "Unhalted Frequency = " << this->unhaltedFrequency << "\n"
-		<< "Cache L2 Requests = " << this->cacheL2Requests << "\n"
-		<< "Cache L2 Misses = " << this->cacheL2Misses << "\n"
-		<< "Cache LLC Loads = " << this->cacheLLCLoads << "\n"
-		<< "Cache LLC Load Misses = " << this->cacheLLCLoadMisses << "\n"
-		<< "Cache LLC Load Miss Rate = " << this->cacheLLCLoadMissRate << "\n"
-		<< "Cache LLC Stores = " << this->cacheLLCStores << "\n"
-		<< "Cache LLC Store Misses = " << this->cacheLLCStoreMisses << "\n"
-		<< "Cache LLC Store Miss Rate = " << this->cacheLLCStoreMissRate << "\n";
+		<< "Time User = " << this->timeUser  << " %\n"
+		<< "Time Nice = " << this->timeNice << " %\n"
+		<< "Time System = " << this->timeSystem << " %\n"
+		<< "Time Idle = " << this->timeIdle << " %\n"
+		<< "Time I/O Wait = " << this->timeIoWait << " %\n"
+		<< "Time IRQ = " << this->timeIRQ << " %\n"
+		<< "Time Soft IRQ = " << this->timeSoftIRQ << " %\n"
+		<< "Time Steal = " << this->timeSteal << " %\n"
+		<< "Time Guest = " << this->timeGuest << " %\n"
+		<< "Retired Instructions = " << this->instructionsRetired << " (" << this->instructionsPerSecond << "/sec)\n"
+		<< "Cycles = " << this->cycles << " (" << this->cyclesPerSecond << "/sec)\n"
+		<< "Relative Frequency = " << this->frequencyRelative << " %\n"
+		<< "Unhalted Frequency = " << this->unhaltedFrequency << " MHz\n"
+		<< "Cache L2 Requests = " << this->cacheL2Requests << " (" << this->cacheL2RequestsPerSecond << "/sec)\n"
+		<< "Cache L2 Misses = " << this->cacheL2Misses << " (" << this->cacheL2MissesPerSecond << "/sec)\n"
+		<< "Cache LLC Loads = " << this->cacheLLCLoads << " (" << this->cacheLLCLoadsPerSecond << "/sec)\n"
+		<< "Cache LLC Load Misses = " << this->cacheLLCLoadMisses << " (" << this->cacheLLCLoadMissesPerSecond << "/sec)\n"
+		<< "Cache LLC Load Miss Rate = " << this->cacheLLCLoadMissRate << " %\n"
+		<< "Cache LLC Stores = " << this->cacheLLCStores << " (" << this->cacheLLCStoresPerSecond << "/sec)\n"
+		<< "Cache LLC Store Misses = " << this->cacheLLCStoreMisses << " (" << this->cacheLLCStoreMissesPerSecond << "/sec)\n"
+		<< "Cache LLC Store Miss Rate = " << this->cacheLLCStoreMissRate << " %\n"
+		<< "CPUs = " << this->cpus << " (" << this->cores << " cores, " << this->sockets << " sockets, "
+			<< this->numaNodes << " NUMA nodes)\n"
+		<< "CPU Busy Max = " << this->cpuBusyMax << " %\n"
+		<< "CPU Busy Min = " << this->cpuBusyMin << " %\n"
+		<< "CPU Busy Deviation = " << this->cpuBusyDeviation << " %\n"
+		<< "Core Busy Max = " << this->coreBusyMax << " %\n"
+		<< "Core Busy Min = " << this->coreBusyMin << " %\n"
+		<< "Frequency = " << this->frequencyMean << " MHz (" << this->frequencyMin << " - " << this->frequencyMax << " MHz)\n"
+		<< "Effective Frequency = " << this->effectiveFrequency << " MHz\n"
+		<< "Core Throttling = " << this->coreThrottleRate << " events/sec, " << this->coreThrottleTime << " %\n"
+		<< "Package Throttling = " << this->packageThrottleRate << " events/sec, " << this->packageThrottleTime << " %\n";
+
+	for(int i = 0; i < this->idleStates; i++)
+		std::cout << "Idle State " << this->idleStateNames[i] << " = " << this->idleStateResidency[i] << " % ("
+			<< this->idleStateRate[i] << " entries/sec per CPU)\n";
+};
+
+// Share of every kind of time between two readings of a cpu line in %, false if a value is missing.
+// Guest time is already a part of user time, so it is left out of the total.
+static bool cpuTimeShares(const uint64_t* previous, const uint64_t* current, double* shares){
+
+	uint64_t deltas[TOPOLOGY_CPU_TIMES], total = 0;
+	for(int i = 0; i < TOPOLOGY_CPU_TIMES; i++){
+		if(previous[i] == COUNTER_MISSING || current[i] == COUNTER_MISSING || current[i] < previous[i]) return false;
+		deltas[i] = current[i] - previous[i];
+		if(i < TOPOLOGY_CPU_TIMES - 1) total += deltas[i];
+	}
+	if(!total) return false;
+
+	for(int i = 0; i < TOPOLOGY_CPU_TIMES; i++)
+		shares[i] = double(deltas[i]) / total * 100;
+	return true;
+};
+
+// Every logical CPU and its averages over physical cores, sockets and NUMA nodes
+static void getCpuMetrics(ProcessorMetrics &processorMetrics){
+
+	const CpuTimesReading &previous = previousSnapshot->cpus, &current = currentSnapshot->cpus;
+	processorMetrics.cpus = current.cpus;
+	processorMetrics.cores = cpuTopology.cores();
+	processorMetrics.sockets = cpuTopology.sockets();
+	processorMetrics.numaNodes = cpuTopology.nodes();
+	if(previous.cpus != current.cpus) return;
+
+	// Sums on the stack, there is no allocation per sample
+	double coreBusy[TOPOLOGY_MAX_CPUS] = {}, socketBusy[TOPOLOGY_MAX_SOCKETS] = {}, nodeBusy[TOPOLOGY_MAX_NODES] = {};
+	int coreCpus[TOPOLOGY_MAX_CPUS] = {}, socketCpus[TOPOLOGY_MAX_SOCKETS] = {}, nodeCpus[TOPOLOGY_MAX_NODES] = {};
+	double sum = 0, squares = 0;
+	int measured = 0;
+
+	for(int i = 0; i < current.cpus; i++){
+		const CpuPlacement &placement = cpuTopology.placement(i);
+		CpuMetrics &cpu = processorMetrics.cpuMetrics[i];
+		cpu.cpu = placement.cpu;
+		cpu.core = placement.core;
+		cpu.socket = placement.socket;
+		cpu.node = placement.node;
+
+		// user, nice, system, idle, iowait, irq, softirq, steal, guest
+		double shares[TOPOLOGY_CPU_TIMES];
+		if(!cpuTimeShares(previous.times[i], current.times[i], shares)) continue;
+		cpu.busy = 100 - shares[3] - shares[4];						// %
+		cpu.user = shares[0] + shares[1];						// %
+		cpu.system = shares[2] + shares[5] + shares[6];					// %
+		cpu.ioWait = shares[4];								// %
+
+		if(!measured || cpu.busy > processorMetrics.cpuBusyMax) processorMetrics.cpuBusyMax = cpu.busy;
+		if(!measured || cpu.busy < processorMetrics.cpuBusyMin) processorMetrics.cpuBusyMin = cpu.busy;
+		sum += cpu.busy;
+		squares += cpu.busy * cpu.busy;
+		measured++;
+
+		if(cpu.core < TOPOLOGY_MAX_CPUS){
+			coreBusy[cpu.core] += cpu.busy;
+			coreCpus[cpu.core]++;
+		}
+		if(cpu.socket < TOPOLOGY_MAX_SOCKETS){
+			socketBusy[cpu.socket] += cpu.busy;
+			socketCpus[cpu.socket]++;
+		}
+		if(cpu.node < TOPOLOGY_MAX_NODES){
+			nodeBusy[cpu.node] += cpu.busy;
+			nodeCpus[cpu.node]++;
+		}
+	}
+	if(!measured) return;
+
+	double mean = sum / measured;
+	processorMetrics.cpuBusyDeviation = std::sqrt(std::max(0.0, squares / measured - mean * mean));	// %
+
+	// A core with one saturated SMT sibling and one idle one is half busy
+	bool found = false;
+	for(int i = 0; i < std::min(processorMetrics.cores, TOPOLOGY_MAX_CPUS); i++){
+		if(!coreCpus[i]) continue;
+		double busy = coreBusy[i] / coreCpus[i];
+		if(!found || busy > processorMetrics.coreBusyMax) processorMetrics.coreBusyMax = busy;		// %
+		if(!found || busy < processorMetrics.coreBusyMin) processorMetrics.coreBusyMin = busy;		// %
+		found = true;
+	}
+	for(int i = 0; i < std::min(processorMetrics.sockets, TOPOLOGY_MAX_SOCKETS); i++)
+		if(socketCpus[i]) processorMetrics.socketBusy[i] = socketBusy[i] / socketCpus[i];		// %
+	for(int i = 0; i < std::min(processorMetrics.numaNodes, TOPOLOGY_MAX_NODES); i++)
+		if(nodeCpus[i]) processorMetrics.nodeBusy[i] = nodeBusy[i] / nodeCpus[i];			// %
+};
+
+static void getFrequencyMetrics(ProcessorMetrics &processorMetrics){
+
+	const CpuFrequencyReading &previous = previousSnapshot->frequency, &current = currentSnapshot->frequency;
+	processorMetrics.idleStates = cpuFrequency.idleStates();
+	for(int state = 0; state < processorMetrics.idleStates; state++)
+		memcpy(processorMetrics.idleStateNames[state], cpuFrequency.idleStateName(state), IDLE_NAME_LENGTH);
+	if(previous.cpus != current.cpus) return;
+
+	// Throttling is counted per core and per package, the totals are in ms
+	int cores = std::min(cpuTopology.cores(), TOPOLOGY_MAX_CPUS), sockets = std::min(cpuTopology.sockets(), TOPOLOGY_MAX_SOCKETS);
+	double coreThrottle[TOPOLOGY_MAX_CPUS], packageThrottle[TOPOLOGY_MAX_SOCKETS];
+	std::fill(coreThrottle, coreThrottle + cores, -1);
+	std::fill(packageThrottle, packageThrottle + sockets, -1);
+	double coreThrottleRate = -1, coreThrottleTime = -1, packageThrottleRate = -1, packageThrottleTime = -1;
+	for(int i = 0; i < cores; i++){
+		double events = deltaRate(previous.coreThrottleCount[i], current.coreThrottleCount[i]);
+		if(events >= 0) coreThrottleRate = std::max(coreThrottleRate, 0.0) + events;
+		double time = deltaRate(previous.coreThrottleTime[i], current.coreThrottleTime[i]);
+		if(time >= 0) coreThrottle[i] = std::min(time / 10, 100.0);
+		coreThrottleTime = std::max(coreThrottleTime, coreThrottle[i]);
+	}
+	for(int i = 0; i < sockets; i++){
+		double events = deltaRate(previous.packageThrottleCount[i], current.packageThrottleCount[i]);
+		if(events >= 0) packageThrottleRate = std::max(packageThrottleRate, 0.0) + events;
+		double time = deltaRate(previous.packageThrottleTime[i], current.packageThrottleTime[i]);
+		if(time >= 0) packageThrottle[i] = std::min(time / 10, 100.0);
+		packageThrottleTime = std::max(packageThrottleTime, packageThrottle[i]);
+	}
+	processorMetrics.coreThrottleRate = coreThrottleRate;						// events/sec
+	processorMetrics.coreThrottleTime = coreThrottleTime;						// %
+	processorMetrics.packageThrottleRate = packageThrottleRate;					// events/sec
+	processorMetrics.packageThrottleTime = packageThrottleTime;					// %
+
+	double frequencySum = 0, effectiveSum = 0;
+	int frequencies = 0, effectives = 0;
+	double residency[IDLE_MAX_STATES] = {}, entries[IDLE_MAX_STATES] = {};
+	int measured[IDLE_MAX_STATES] = {};
+
+	for(int i = 0; i < current.cpus; i++){
+		const CpuPlacement &placement = cpuTopology.placement(i);
+		CpuMetrics &cpu = processorMetrics.cpuMetrics[i];
+
+		cpu.frequency = current.frequency[i];							// MHz
+		if(cpu.frequency >= 0){
+			if(!frequencies || cpu.frequency < processorMetrics.frequencyMin) processorMetrics.frequencyMin = cpu.frequency;
+			if(!frequencies || cpu.frequency > processorMetrics.frequencyMax) processorMetrics.frequencyMax = cpu.frequency;
+			frequencySum += cpu.frequency;
+			frequencies++;
+		}
+
+		// Both registers count only while the CPU is not halted, so their ratio is the frequency it ran at
+		double aperf = deltaRate(previous.aperf[i], current.aperf[i]), mperf = deltaRate(previous.mperf[i], current.mperf[i]);
+		if(aperf >= 0 && mperf > 0 && baseFrequency > 0){
+			cpu.effectiveFrequency = aperf / mperf * baseFrequency;					// MHz
+			effectiveSum += cpu.effectiveFrequency;
+			effectives++;
+		}
+
+		// The idle times are in us, POLL spins in the kernel instead of idling the core
+		double idle = -1;
+		for(int state = 0; state < processorMetrics.idleStates; state++){
+			double time = deltaRate(previous.idleTime[i][state], current.idleTime[i][state]);
+			double usage = deltaRate(previous.idleUsage[i][state], current.idleUsage[i][state]);
+			if(time < 0) continue;
+			residency[state] += time / 1e4;
+			entries[state] += std::max(usage, 0.0);
+			measured[state]++;
+			if(strcmp(processorMetrics.idleStateNames[state], "POLL")) idle = std::max(idle, 0.0) + time / 1e4;
+		}
+		cpu.idleResidency = idle >= 0 ? std::min(idle, 100.0) : -1;				// %
+
+		double throttle = placement.core < cores ? coreThrottle[placement.core] : -1;
+		if(placement.socket < sockets) throttle = std::max(throttle, packageThrottle[placement.socket]);
+		cpu.throttleTime = throttle;								// %
+	}
+
+	processorMetrics.frequencyMean = frequencies ? frequencySum / frequencies : -1;			// MHz
+	processorMetrics.effectiveFrequency = effectives ? effectiveSum / effectives : -1;		// MHz
+	for(int state = 0; state < processorMetrics.idleStates; state++){
+		processorMetrics.idleStateResidency[state] = measured[state] ? residency[state] / measured[state] : -1;	// %
+		processorMetrics.idleStateRate[state] = measured[state] ? entries[state] / measured[state] : -1;	// entries/sec
+	}
 };
 
 void getProcessorMetrics(ProcessorMetrics &processorMetrics){
 
-	const char* command = "cat /proc/cpuinfo | grep 'processor' -c";
-	std::string output = exec(command), temp;
-	int numberOfProcessors = std::stoi(output);
-
-	command = "cat /proc/stat";
-	output = exec(command);
-	std::stringstream streamOne(output);
-
-	streamOne >> temp;		// Get rid of 'cpu' at the beggining
-	streamOne >> temp;
-	processorMetrics.timeUser = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeNice = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeSystem = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeIdle = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeIoWait = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeIRQ = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeSoftIRQ = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeSteal = std::stoi(temp);		// USER_HZ
-	streamOne >> temp;
-	processorMetrics.timeGuest = std::stoi(temp);		// USER_HZ
-	
-	// sed 's/[\xE2\x80\xAF]//g' is getting rid of special white space characters
-	command = "perf stat -e 'l2_rqsts.references,l2_rqsts.miss,LLC-loads,LLC-stores,LLC-load-misses,LLC-store-misses' --all-cpus sleep 1 2>&1 | awk '/^[ ]*[0-9]/{print $1}' | sed 's/[\xE2\x80\xAF]//g'";
-	output = exec(command);
-	std::stringstream streamTwo(output);
-
-	streamTwo >> temp;
-	processorMetrics.cacheL2Requests = std::stoi(temp);
-	streamTwo >> temp;
-	processorMetrics.cacheL2Misses = std::stoi(temp);
-	streamTwo >> temp;
-	processorMetrics.cacheLLCLoads = std::stoi(temp);
-	streamTwo >> temp;
-	processorMetrics.cacheLLCStores = std::stoi(temp);
-	streamTwo >> temp;
-	processorMetrics.cacheLLCLoadMisses = std::stoi(temp);
-	streamTwo >> temp;
-	processorMetrics.cacheLLCStoreMisses = std::stoi(temp);
-	
+	// Share of every kind of time in the interval
+	double* times[] = {
+		&processorMetrics.timeUser, &processorMetrics.timeNice, &processorMetrics.timeSystem,
+		&processorMetrics.timeIdle, &processorMetrics.timeIoWait, &processorMetrics.timeIRQ,
+		&processorMetrics.timeSoftIRQ, &processorMetrics.timeSteal, &processorMetrics.timeGuest};
+	double shares[TOPOLOGY_CPU_TIMES];
+	if(cpuTimeShares(previousSnapshot->cpuTimes, currentSnapshot->cpuTimes, shares))
+		for(int i = 0; i < TOPOLOGY_CPU_TIMES; i++)
+			*times[i] = shares[i];							// %
+
+	if(cpuTopologyOpen) getCpuMetrics(processorMetrics);
+	if(cpuFrequencyOpen) getFrequencyMetrics(processorMetrics);
+
+	// Counters are opened once and read with the snapshot, the rates cover the time since the previous one
+	const PerfCounterReading &reading = currentSnapshot->perf;
+	uint64_t* counters[] = {
+		&processorMetrics.instructionsRetired, &processorMetrics.cycles, nullptr,
+		&processorMetrics.cacheL2Requests, &processorMetrics.cacheL2Misses,
+		&processorMetrics.cacheLLCLoads, &processorMetrics.cacheLLCLoadMisses,
+		&processorMetrics.cacheLLCStores, &processorMetrics.cacheLLCStoreMisses};
+	double* rates[] = {
+		&processorMetrics.instructionsPerSecond, &processorMetrics.cyclesPerSecond, nullptr,
+		&processorMetrics.cacheL2RequestsPerSecond, &processorMetrics.cacheL2MissesPerSecond,
+		&processorMetrics.cacheLLCLoadsPerSecond, &processorMetrics.cacheLLCLoadMissesPerSecond,
+		&processorMetrics.cacheLLCStoresPerSecond, &processorMetrics.cacheLLCStoreMissesPerSecond};
+	for(int i = 0; i < COUNTER_EVENTS; i++){
+		if(!counters[i]) continue;
+		if(reading.totals[i] >= 0) *counters[i] = uint64_t(reading.totals[i]);		// number of events
+		*rates[i] = reading.rates[i];							// events/sec
+	}
+
+	// Unhalted cycles against unhalted reference cycles gives the frequency relative to the nominal one.
+	// Without perf the MSRs give the same ratio, averaged over the CPUs instead of weighted by their cycles.
+	double frequencyRelative = -1;
+	if(reading.rates[COUNTER_CYCLES] >= 0 && reading.rates[COUNTER_REF_CYCLES] > 0)
+		frequencyRelative = reading.rates[COUNTER_CYCLES] / reading.rates[COUNTER_REF_CYCLES] * 100;
+	else if(processorMetrics.effectiveFrequency >= 0 && baseFrequency > 0)
+		frequencyRelative = processorMetrics.effectiveFrequency / baseFrequency * 100;
+	processorMetrics.frequencyRelative = frequencyRelative;								// %
+	processorMetrics.unhaltedFrequency = frequencyRelative >= 0 && baseFrequency > 0 ? frequencyRelative / 100 * baseFrequency : -1;	// MHz
+
 	// Check division by zero and calculate miss rate
-	if(processorMetrics.cacheLLCLoads)
-		processorMetrics.cacheLLCLoadMissRate = float(processorMetrics.cacheLLCLoadMisses) / float(processorMetrics.cacheLLCLoads) * 100; 
-	if(processorMetrics.cacheLLCStores)
-		processorMetrics.cacheLLCStoreMissRate = float(processorMetrics.cacheLLCStoreMisses) / float(processorMetrics.cacheLLCStores) * 100;
-
-	command = "perf stat -e instructions,cycles,cpu-clock,cpu-clock:u sleep 1 2>&1 | awk '/^[ ]*[0-9]/{print $1}' | sed 's/[\xE2\x80\xAF]//g' | tr ',' '.'";
-	output = exec(command);
-	std::stringstream streamThree(output);
-
-	streamThree >> temp;
-	processorMetrics.instructionsRetired = std::stoi(temp); 	// number of instructions
-	streamThree >> temp;
-	processorMetrics.cycles = std::stoi(temp); 			// number of cycles
-	streamThree >> temp;
-	processorMetrics.frequencyRelative = std::stof(temp);		// MHz
-	streamThree >> temp;
-	processorMetrics.unhaltedFrequency = std::stof(temp); 		// MHz
+	if(processorMetrics.cacheLLCLoadsPerSecond > 0 && processorMetrics.cacheLLCLoadMissesPerSecond >= 0)
+		processorMetrics.cacheLLCLoadMissRate = processorMetrics.cacheLLCLoadMissesPerSecond / processorMetrics.cacheLLCLoadsPerSecond * 100;
+	if(processorMetrics.cacheLLCStoresPerSecond > 0 && processorMetrics.cacheLLCStoreMissesPerSecond >= 0)
+		processorMetrics.cacheLLCStoreMissRate = processorMetrics.cacheLLCStoreMissesPerSecond / processorMetrics.cacheLLCStoresPerSecond * 100;
 
 	//processorMetrics.printProcessorMetrics();
 };
 
 InputOutputMetrics::InputOutputMetrics(){
 	this->processID = GPROCESSID;
-	this->dataRead = -1;
-	this->readTime = -1;
+	this->dataRead = COUNTER_MISSING;
+	this->dataWritten = COUNTER_MISSING;
+	this->readOperations = COUNTER_MISSING;
+	this->writeOperations = COUNTER_MISSING;
+	this->dataReadRate = -1;
+	this->dataWrittenRate = -1;
 	this->readOperationsRate = -1;
-	this->dataWritten = -1;
-	this->writeTime = -1;
 	this->writeOperationsRate = -1;
+	this->diskReadRate = -1;
+	this->diskWriteRate = -1;
+	this->diskDataReadRate = -1;
+	this->diskDataWrittenRate = -1;
+	this->diskReadTime = -1;
+	this->diskWriteTime = -1;
+	this->diskUtilization = -1;
+	this->devices = 0;
+};
+
+BlockDeviceMetrics::BlockDeviceMetrics(){
+	this->name[0] = '\0';
+	this->stacked = 0;
+	this->reads = COUNTER_MISSING;
+	this->writes = COUNTER_MISSING;
+	this->dataRead = COUNTER_MISSING;
+	this->dataWritten = COUNTER_MISSING;
+	this->readRate = -1;
+	this->writeRate = -1;
+	this->dataReadRate = -1;
+	this->dataWrittenRate = -1;
+	this->readTime = -1;
+	this->writeTime = -1;
+	this->flushRate = -1;
 	this->flushTime = -1;
-	this->flushOperationsRate = -1;
+	this->queueDepth = -1;
+	this->utilization = -1;
 };
 
 void InputOutputMetrics::printInputOutputMetrics(){
 
 	std::cout << "\n\t[INPUT/OUTPUT METRICS]\n\n"
 		<< "Process ID = " << this->processID << "\n"
-		<< "Data Read = " << this->dataRead << " MB\n"
-		<< "Read Time = " << this->readTime << " ms\n"
-		<< "Read Operations Rate = " << this->readOperationsRate << "\n"
-		<< "Data Written = " << this->dataWritten << " MB\n"
-		<< "Write Time = " << this->writeTime << " ms\n"
-		<< "Write Operations Rate = " << this->writeOperationsRate << "\n"
-		<< "Flush Time = " << this->flushTime << " ms\n"
-		<< "Flush Operations Rate = " << this->flushOperationsRate << "\n";
+		<< "Data Read = " << this->dataRead << " B (" << this->dataReadRate << " MB/s)\n"
+		<< "Read Operations = " << this->readOperations << " (" << this->readOperationsRate << "/s)\n"
+		<< "Data Written = " << this->dataWritten << " B (" << this->dataWrittenRate << " MB/s)\n"
+		<< "Write Operations = " << this->writeOperations << " (" << this->writeOperationsRate << "/s)\n"
+		<< "Disk Reads = " << this->diskReadRate << "/s (" << this->diskDataReadRate << " MB/s, " << this->diskReadTime << " ms)\n"
+		<< "Disk Writes = " << this->diskWriteRate << "/s (" << this->diskDataWrittenRate << " MB/s, " << this->diskWriteTime << " ms)\n"
+		<< "Disk Utilization = " << this->diskUtilization << " %\n";
+
+	for(int i = 0; i < this->devices; i++){
+		const BlockDeviceMetrics &device = this->deviceMetrics[i];
+		std::cout << device.name << (device.stacked ? " (stacked)" : "") << ": "
+			<< device.readRate << " reads/s, " << device.dataReadRate << " MB/s, " << device.readTime << " ms; "
+			<< device.writeRate << " writes/s, " << device.dataWrittenRate << " MB/s, " << device.writeTime << " ms; "
+			<< device.flushRate << " flushes/s, " << device.flushTime << " ms; "
+			<< "queue " << device.queueDepth << ", " << device.utilization << " %\n";
+	}
 };
 
 
 void getInputOutputMetrics(InputOutputMetrics &inputOutputMetrics){
 
-	const char* command = "awk '{ print $2 }' /proc/$$/io";
-	std::string output = exec(command), temp;
-	std::stringstream streamOne(output);
-	
-	streamOne >> temp;
-	inputOutputMetrics.dataRead = std::stof(temp) / KILOBYTE;	// MB
-	streamOne >> temp;
-	inputOutputMetrics.dataWritten = std::stof(temp) / KILOBYTE;	// MB
-	streamOne >> temp;
-	inputOutputMetrics.readOperationsRate = std::stoi(temp);	// Number of operations
-	streamOne >> temp;	
-	inputOutputMetrics.writeOperationsRate = std::stoi(temp);	// Number of operations
-	streamOne >> temp;
-
-	command = "iostat -d -k | awk '/^[^ ]/ {device=$1} $1 ~ /sda/ {print 1000*$10/($4*$3), 1000*$11/($4*$3), $6/$4, $7/$6}'";
-	output = exec(command);
-	std::stringstream streamTwo(output);
-
-	streamTwo >> temp;
-	inputOutputMetrics.readTime = std::stof(temp);			// ms
-	streamTwo >> temp;
-	inputOutputMetrics.writeTime = std::stof(temp);			// ms
-	streamTwo >> temp;
-	inputOutputMetrics.flushOperationsRate = std::stof(temp);	// operations/sec
-	streamTwo >> temp;
-	inputOutputMetrics.flushTime = std::stof(temp);			// ms
+	inputOutputMetrics.processID = processTree.root();
+	inputOutputMetrics.dataRead = currentSnapshot->processDataRead;				// bytes
+	inputOutputMetrics.dataWritten = currentSnapshot->processDataWritten;			// bytes
+	inputOutputMetrics.readOperations = currentSnapshot->processReadCalls;			// number of operations
+	inputOutputMetrics.writeOperations = currentSnapshot->processWriteCalls;			// number of operations
+	inputOutputMetrics.readOperationsRate = counterRate(&CounterSnapshot::processReadCalls);	// operations/sec
+	inputOutputMetrics.writeOperationsRate = counterRate(&CounterSnapshot::processWriteCalls);	// operations/sec
+
+	double readRate = counterRate(&CounterSnapshot::processDataRead);
+	double writeRate = counterRate(&CounterSnapshot::processDataWritten);
+	if(readRate >= 0) inputOutputMetrics.dataReadRate = readRate / KILOBYTE / KILOBYTE;		// MB/s
+	if(writeRate >= 0) inputOutputMetrics.dataWrittenRate = writeRate / KILOBYTE / KILOBYTE;	// MB/s
+
+	// Devices keep their slots for the whole run, so both snapshots have them in the same order
+	const BlockDeviceReading &previous = previousSnapshot->disks, &current = currentSnapshot->disks;
+	double diskReadRate = 0, diskWriteRate = 0, sectorReadRate = 0, sectorWriteRate = 0, readTimeRate = 0, writeTimeRate = 0, utilization = 0;
+	bool measured = false;
+
+	inputOutputMetrics.devices = current.devices;
+	for(int i = 0; i < current.devices; i++){
+		BlockDeviceMetrics &device = inputOutputMetrics.deviceMetrics[i];
+		memcpy(device.name, current.names[i], BLOCK_NAME_LENGTH);
+		device.stacked = current.stacked[i];
+		if(!current.found[i]) continue;
+
+		const BlockDeviceCounters &now = current.counters[i];
+		device.reads = now.reads;								// number of operations
+		device.writes = now.writes;								// number of operations
+		device.dataRead = now.sectorsRead * BLOCK_SECTOR_SIZE;					// bytes
+		device.dataWritten = now.sectorsWritten * BLOCK_SECTOR_SIZE;				// bytes
+		if(i >= previous.devices || !previous.found[i]) continue;
+
+		const BlockDeviceCounters &before = previous.counters[i];
+		device.readRate = deltaRate(before.reads, now.reads);					// operations/sec
+		device.writeRate = deltaRate(before.writes, now.writes);				// operations/sec
+		device.flushRate = deltaRate(before.flushes, now.flushes);				// operations/sec
+		double sectorsRead = deltaRate(before.sectorsRead, now.sectorsRead);
+		double sectorsWritten = deltaRate(before.sectorsWritten, now.sectorsWritten);
+		double readTime = deltaRate(before.readTime, now.readTime);
+		double writeTime = deltaRate(before.writeTime, now.writeTime);
+		double busyTime = deltaRate(before.busyTime, now.busyTime);
+		double queueTime = deltaRate(before.queueTime, now.queueTime);
+		if(sectorsRead >= 0) device.dataReadRate = sectorsRead * BLOCK_SECTOR_SIZE / KILOBYTE / KILOBYTE;		// MB/s
+		if(sectorsWritten >= 0) device.dataWrittenRate = sectorsWritten * BLOCK_SECTOR_SIZE / KILOBYTE / KILOBYTE;	// MB/s
+
+		// Times are in ms per second, the average time of a single request is the time per request
+		device.readTime = rateRatio(readTime, device.readRate);					// ms
+		device.writeTime = rateRatio(writeTime, device.writeRate);				// ms
+		device.flushTime = rateRatio(deltaRate(before.flushTime, now.flushTime), device.flushRate);	// ms
+		if(queueTime >= 0) device.queueDepth = queueTime / 1000;				// requests
+		if(busyTime >= 0) device.utilization = std::min(busyTime / 10, 100.0);			// %
+
+		// dm and md pass their I/O to other devices of the list, counting them too would count it twice
+		if(device.stacked || device.readRate < 0 || device.writeRate < 0) continue;
+		measured = true;
+		diskReadRate += device.readRate;
+		diskWriteRate += device.writeRate;
+		sectorReadRate += std::max(sectorsRead, 0.0);
+		sectorWriteRate += std::max(sectorsWritten, 0.0);
+		readTimeRate += std::max(readTime, 0.0);
+		writeTimeRate += std::max(writeTime, 0.0);
+		utilization = std::max(utilization, device.utilization);
+	}
+
+	if(measured){
+		inputOutputMetrics.diskReadRate = diskReadRate;						// operations/sec
+		inputOutputMetrics.diskWriteRate = diskWriteRate;						// operations/sec
+		inputOutputMetrics.diskDataReadRate = sectorReadRate * BLOCK_SECTOR_SIZE / KILOBYTE / KILOBYTE;	// MB/s
+		inputOutputMetrics.diskDataWrittenRate = sectorWriteRate * BLOCK_SECTOR_SIZE / KILOBYTE / KILOBYTE;	// MB/s
+		inputOutputMetrics.diskReadTime = rateRatio(readTimeRate, diskReadRate);			// ms
+		inputOutputMetrics.diskWriteTime = rateRatio(writeTimeRate, diskWriteRate);			// ms
+		inputOutputMetrics.diskUtilization = utilization;					// %
+	}
 
 	//inputOutputMetrics.printInputOutputMetrics();
 };
 
+ProcessMetrics::ProcessMetrics(){
+	this->processID = GPROCESSID;
+	this->processes = -1;
+	this->threads = -1;
+	this->cpuTime = COUNTER_MISSING;
+	this->cpuUsage = -1;
+	this->memoryResident = -1;
+	this->contextSwitches = COUNTER_MISSING;
+	this->contextSwitchRate = -1;
+};
+
+void ProcessMetrics::printProcessMetrics(){
+
+	std::cout << "\n\t[PROCESS METRICS]\n\n"
+		<< "Process ID = " << this->processID << "\n"
+		<< "Processes = " << this->processes << "\n"
+		<< "Threads = " << this->threads << "\n"
+		<< "CPU Time = " << this->cpuTime << " ms\n"
+		<< "CPU Usage = " << this->cpuUsage << " %\n"
+		<< "Resident Memory = " << this->memoryResident << " MB\n"
+		<< "Context Switches = " << this->contextSwitches << "\n"
+		<< "Context Switch Rate = " << this->contextSwitchRate << " switches/sec\n";
+};
+
+// Sums over the target process and all of its descendants, see process-tree.h
+void getProcessMetrics(ProcessMetrics &processMetrics){
+
+	processMetrics.processID = processTree.root();
+	processMetrics.processes = currentSnapshot->processes;					// number of processes
+	processMetrics.threads = currentSnapshot->processThreads;				// number of threads
+	processMetrics.cpuTime = currentSnapshot->processCpuTime;				// ms
+	processMetrics.contextSwitches = currentSnapshot->processContextSwitches;		// number of context switches
+	processMetrics.contextSwitchRate = counterRate(&CounterSnapshot::processContextSwitches);	// context switches/sec
+
+	// ms of CPU time per second, 1000 ms/s is one CPU fully used
+	double cpuRate = counterRate(&CounterSnapshot::processCpuTime);
+	if(cpuRate >= 0) processMetrics.cpuUsage = cpuRate / 10;					// %
+	if(currentSnapshot->processResident != COUNTER_MISSING)
+		processMetrics.memoryResident = double(currentSnapshot->processResident) / KILOBYTE / KILOBYTE;	// MB
+
+	//processMetrics.printProcessMetrics();
+};
+
 MemoryMetrics::MemoryMetrics(){
+	this->memoryTotal = -1;
 	this->memoryUsed = -1;
+	this->memoryAvailable = -1;
 	this->memoryCached = -1;
 	this->swapUsed = -1;
 	this->swapCached = -1;
 	this->memoryActive = -1;
 	this->memoryInactive = -1;
+	this->memoryHugePages = -1;
 	this->pageInRate = -1;
 	this->pageOutRate = -1;
 	this->pageFaultRate = -1;
@@ -254,97 +1155,176 @@ MemoryMetrics::MemoryMetrics(){
 	this->pageFreeRate = -1;
 	this->pageActivateRate = -1;
 	this->pageDeactivateRate = -1;
-	this->memoryReadRate = -1;
-	this->memoryWriteRate = -1;
-	this->memoryIoRate = -1;
+	this->blockReadRate = -1;
+	this->blockWriteRate = -1;
+	this->blockIoRate = -1;
+	this->thpFaultRate = -1;
+	this->thpFallbackRate = -1;
+	this->thpCollapseRate = -1;
+	this->thpSplitRate = -1;
+	this->compactionStallRate = -1;
+	this->compactionFailRate = -1;
+	this->compactionSuccessRate = -1;
+	this->numaPteUpdateRate = -1;
+	this->numaHintFaultRate = -1;
+	this->numaHintFaultLocalRatio = -1;
+	this->numaMigrationRate = -1;
 };
 
 void MemoryMetrics::printMemoryMetrics(){
 
 	std::cout << "\n\t[MEMORY METRICS]\n\n"
+		<< "Memory Total = " << this->memoryTotal << " MB\n"
 		<< "Memory Used = " << this->memoryUsed << " MB\n"
+		<< "Memory Available = " << this->memoryAvailable << " MB\n"
 		<< "Memory Cached = " << this->memoryCached << " MB\n"
 		<< "Swap Used = " << this->swapUsed << " MB\n"
 		<< "Swap Cached = " << this->swapCached << " MB\n"
 		<< "Memory Active = " << this->memoryActive << " MB\n"
 		<< "Memory Inactive = " << this->memoryInactive << " MB\n"
-		<< "Page Read Rate = " << this->pageInRate << "\n"
-		<< "Page Save Rate = " << this->pageOutRate << "\n"
+		<< "Memory Huge Pages = " << this->memoryHugePages << " MB\n"
+		<< "Paged In Rate = " << this->pageInRate << " kB/s\n"
+		<< "Paged Out Rate = " << this->pageOutRate << " kB/s\n"
 		<< "Page Fault Rate = " << this->pageFaultRate << "\n"
 		<< "Page Fault Major Rate = " << this->pageFaultsMajorRate << "\n"
 		<< "Page Release Rate = " << this->pageFreeRate << "\n"
 		<< "Page Activate Rate = " << this->pageActivateRate << "\n"
 		<< "Page Deactivate Rate = " << this->pageDeactivateRate << "\n"
-		<< "Memory Read Rate = " << this->memoryReadRate << " MB/s\n"
-		<< "Memory Write Rate = " << this->memoryWriteRate << " MB/s\n"
-		<< "Memory I/O Rate = " << this->memoryIoRate << " MB/s\n";
+		<< "Block Read Rate = " << this->blockReadRate << " MB/s\n"
+		<< "Block Write Rate = " << this->blockWriteRate << " MB/s\n"
+		<< "Block I/O Rate = " << this->blockIoRate << " MB/s\n"
+		<< "THP Fault Rate = " << this->thpFaultRate << "\n"
+		<< "THP Fallback Rate = " << this->thpFallbackRate << "\n"
+		<< "THP Collapse Rate = " << this->thpCollapseRate << "\n"
+		<< "THP Split Rate = " << this->thpSplitRate << "\n"
+		<< "Compaction Stall Rate = " << this->compactionStallRate << "\n"
+		<< "Compaction Fail Rate = " << this->compactionFailRate << "\n"
+		<< "Compaction Success Rate = " << this->compactionSuccessRate << "\n"
+		<< "NUMA PTE Update Rate = " << this->numaPteUpdateRate << "\n"
+		<< "NUMA Hint Fault Rate = " << this->numaHintFaultRate << "\n"
+		<< "NUMA Hint Fault Local Ratio = " << this->numaHintFaultLocalRatio << " %\n"
+		<< "NUMA Migration Rate = " << this->numaMigrationRate << "\n";
 };
 
 
 void getMemoryMetrics(MemoryMetrics &memoryMetrics){
 
-	const char* command = "grep -v -e 'anon' -e 'file' /proc/meminfo | grep -E '^(MemTotal|Cached|SwapCached|SwapTotal|SwapFree|Active|Inactive)' | awk '{print $2}'";
-	std::string output = exec(command), temp, swapFree;
-	std::stringstream streamOne(output);
-
-	streamOne >> temp;
-	memoryMetrics.memoryUsed = std::stof(temp);
-	memoryMetrics.memoryUsed = memoryMetrics.memoryUsed / KILOBYTE;		// MB
-	streamOne >> temp;
-	memoryMetrics.memoryCached = std::stof(temp);
-	memoryMetrics.memoryCached = memoryMetrics.memoryCached / KILOBYTE;	// MB
-	streamOne >> temp;
-	memoryMetrics.swapCached = std::stof(temp);
-	memoryMetrics.swapCached = memoryMetrics.swapCached / KILOBYTE;		// MB
-	streamOne >> temp;
-	memoryMetrics.memoryActive = std::stof(temp);
-	memoryMetrics.memoryActive = memoryMetrics.memoryActive / KILOBYTE;	// MB
-	streamOne >> temp;
-	memoryMetrics.memoryInactive = std::stof(temp);
-	memoryMetrics.memoryInactive = memoryMetrics.memoryInactive / KILOBYTE;	// MB
-	streamOne >> temp;
-	streamOne >> swapFree;
-	memoryMetrics.swapUsed = std::stof(temp) - std::stof(swapFree);
-	memoryMetrics.swapUsed = memoryMetrics.swapUsed / KILOBYTE;		// MB
-
-	command = "sar -r -B 1 1 | awk 'NR==4{print $2,$3,$4,$5,$6,$7,$8}'";
-	output = exec(command);
-	std::stringstream streamTwo(output);
-
-	streamTwo >> temp;
-	memoryMetrics.pageInRate = std::stof(temp);			// pages/sec
-	streamTwo >> temp;
-	memoryMetrics.pageOutRate = std::stof(temp);			// pages/sec
-	streamTwo >> temp;
-	memoryMetrics.pageFaultRate = std::stof(temp);			// pages/sec
-	streamTwo >> temp;
-	memoryMetrics.pageFaultsMajorRate = std::stof(temp);		// pages/sec
-	streamTwo >> temp;
-	memoryMetrics.pageFreeRate = std::stof(temp);			// pages/sec
-	streamTwo >> temp;	
-	memoryMetrics.pageActivateRate = std::stof(temp);		// kpages/sec
-	streamTwo >> temp;
-	memoryMetrics.pageDeactivateRate = std::stof(temp);		// kpages/sec
-
-	command = "sar -b 1 1 | awk 'NR==4{print $6/1024,$7/1024,($6+$7)/1024}'";
-	output = exec(command);
-	std::stringstream streamThree(output);
-
-	streamThree >> temp;
-	memoryMetrics.memoryReadRate = std::stof(temp);			// MB/s
-	streamThree >> temp;
-	memoryMetrics.memoryWriteRate = std::stof(temp);		// MB/s
-	streamThree >> temp;
-	memoryMetrics.memoryIoRate = std::stof(temp);			// MB/s
+	// All of the values in /proc/meminfo are in kB
+	uint64_t memoryTotal = COUNTER_MISSING, memoryAvailable = COUNTER_MISSING, cached = COUNTER_MISSING,
+		swapCached = COUNTER_MISSING, active = COUNTER_MISSING, inactive = COUNTER_MISSING,
+		swapTotal = COUNTER_MISSING, swapFree = COUNTER_MISSING, hugePages = COUNTER_MISSING;
+	const KeyValueField meminfoFields[] = {
+		{"MemTotal", &memoryTotal},
+		{"MemAvailable", &memoryAvailable},
+		{"Cached", &cached},
+		{"SwapCached", &swapCached},
+		{"Active", &active},
+		{"Inactive", &inactive},
+		{"SwapTotal", &swapTotal},
+		{"SwapFree", &swapFree},
+		{"AnonHugePages", &hugePages}};
+	findKeyValues(meminfoFile.read(), meminfoFields, std::size(meminfoFields));
+
+	auto megabytes = [](uint64_t value){ return value == COUNTER_MISSING ? -1 : double(value) / KILOBYTE; };
+	memoryMetrics.memoryTotal = megabytes(memoryTotal);						// MB
+	memoryMetrics.memoryAvailable = megabytes(memoryAvailable);					// MB
+	memoryMetrics.memoryCached = megabytes(cached);							// MB
+	memoryMetrics.swapCached = megabytes(swapCached);						// MB
+	memoryMetrics.memoryActive = megabytes(active);							// MB
+	memoryMetrics.memoryInactive = megabytes(inactive);						// MB
+	memoryMetrics.memoryHugePages = megabytes(hugePages);						// MB
+	// MemAvailable counts the cache that can be dropped, MemFree alone would make every node look full
+	if(memoryTotal != COUNTER_MISSING && memoryAvailable != COUNTER_MISSING)
+		memoryMetrics.memoryUsed = megabytes(memoryTotal - memoryAvailable);			// MB
+	if(swapTotal != COUNTER_MISSING && swapFree != COUNTER_MISSING)
+		memoryMetrics.swapUsed = megabytes(swapTotal - swapFree);				// MB
+
+	// pgpgin and pgpgout are counted in kB despite their names
+	memoryMetrics.pageInRate = counterRate(&CounterSnapshot::pageIn);				// kB/sec
+	memoryMetrics.pageOutRate = counterRate(&CounterSnapshot::pageOut);				// kB/sec
+	memoryMetrics.pageFaultRate = counterRate(&CounterSnapshot::pageFaults);			// pages/sec
+	memoryMetrics.pageFaultsMajorRate = counterRate(&CounterSnapshot::pageFaultsMajor);		// pages/sec
+	memoryMetrics.pageFreeRate = counterRate(&CounterSnapshot::pageFree);				// pages/sec
+	memoryMetrics.pageActivateRate = counterRate(&CounterSnapshot::pageActivate);			// pages/sec
+	memoryMetrics.pageDeactivateRate = counterRate(&CounterSnapshot::pageDeactivate);		// pages/sec
+
+	// Paging traffic between memory and the block devices, what sar -b reported as bread/s and bwrtn/s
+	if(memoryMetrics.pageInRate >= 0 && memoryMetrics.pageOutRate >= 0){
+		memoryMetrics.blockReadRate = memoryMetrics.pageInRate / KILOBYTE;				// MB/s
+		memoryMetrics.blockWriteRate = memoryMetrics.pageOutRate / KILOBYTE;				// MB/s
+		memoryMetrics.blockIoRate = memoryMetrics.blockReadRate + memoryMetrics.blockWriteRate;	// MB/s
+	}
+
+	memoryMetrics.thpFaultRate = counterRate(&CounterSnapshot::thpFaultAlloc);			// pages/sec
+	memoryMetrics.thpFallbackRate = counterRate(&CounterSnapshot::thpFaultFallback);		// faults/sec
+	memoryMetrics.thpCollapseRate = counterRate(&CounterSnapshot::thpCollapseAlloc);		// pages/sec
+	memoryMetrics.thpSplitRate = counterRate(&CounterSnapshot::thpSplitPage);			// pages/sec
+	memoryMetrics.compactionStallRate = counterRate(&CounterSnapshot::compactStall);		// stalls/sec
+	memoryMetrics.compactionFailRate = counterRate(&CounterSnapshot::compactFail);			// stalls/sec
+	memoryMetrics.compactionSuccessRate = counterRate(&CounterSnapshot::compactSuccess);		// stalls/sec
+	memoryMetrics.numaPteUpdateRate = counterRate(&CounterSnapshot::numaPteUpdates);		// PTEs/sec
+	memoryMetrics.numaHintFaultRate = counterRate(&CounterSnapshot::numaHintFaults);		// faults/sec
+	memoryMetrics.numaMigrationRate = counterRate(&CounterSnapshot::numaPagesMigrated);		// pages/sec
+
+	double localRatio = rateRatio(counterRate(&CounterSnapshot::numaHintFaultsLocal), memoryMetrics.numaHintFaultRate);
+	if(localRatio >= 0) memoryMetrics.numaHintFaultLocalRatio = localRatio * 100;			// %
 	
 	//memoryMetrics.printMemoryMetrics();
 };
 
 NetworkMetrics::NetworkMetrics(){
-	this->receivedData = -1;
+	this->receivedData = COUNTER_MISSING;
+	this->receivedBytes = COUNTER_MISSING;
 	this->receivePacketRate = -1;
-	this->sentData = -1;
+	this->sentData = COUNTER_MISSING;
+	this->sentBytes = COUNTER_MISSING;
 	this->sendPacketsRate = -1;
+	this->dropRate = -1;
+	this->errorRate = -1;
+	this->tcpRetransmits = COUNTER_MISSING;
+	this->tcpRetransmitRate = -1;
+	this->tcpRetransmitRatio = -1;
+	this->tcpErrorRate = -1;
+	this->udpErrors = COUNTER_MISSING;
+	this->udpErrorRate = -1;
+	this->interfaces = 0;
+	this->infinibandTransmitRate = -1;
+	this->infinibandReceiveRate = -1;
+	this->infinibandPorts = 0;
+};
+
+NetworkInterfaceMetrics::NetworkInterfaceMetrics(){
+	this->name[0] = '\0';
+	this->receivedBytes = COUNTER_MISSING;
+	this->receivedPackets = COUNTER_MISSING;
+	this->sentBytes = COUNTER_MISSING;
+	this->sentPackets = COUNTER_MISSING;
+	this->receiveRate = -1;
+	this->sendRate = -1;
+	this->receivePacketRate = -1;
+	this->sendPacketRate = -1;
+	this->receiveDropRate = -1;
+	this->sendDropRate = -1;
+	this->receiveErrorRate = -1;
+	this->sendErrorRate = -1;
+};
+
+InfinibandPortMetrics::InfinibandPortMetrics(){
+	this->name[0] = '\0';
+	this->state = -1;
+	this->linkRate = -1;
+	this->transmitRate = -1;
+	this->receiveRate = -1;
+	this->transmitPacketRate = -1;
+	this->receivePacketRate = -1;
+	this->utilization = -1;
+	this->waitRate = -1;
+	this->linkErrors = -1;
+	this->receiveErrors = -1;
+	this->transmitDiscards = -1;
+	this->transportErrors = -1;
+	this->outOfBuffer = -1;
+	this->saturatedCounters = 0;
 };
 
 void NetworkMetrics::printNetworkMetrics(){
@@ -352,32 +1332,170 @@ void NetworkMetrics::printNetworkMetrics(){
 	std::cout << "\n\t[NETWORK METRICS]\n\n"
 		<< "Receive Packet Rate = " << this->receivePacketRate << " KB/s\n"
 		<< "Send Packet Rate = " << this->sendPacketsRate << " KB/s\n"
-		<< "Packets Received = " << this->receivedData << "\n"
-		<< "Packets Sent = " << this->sentData << "\n";
+		<< "Packets Received = " << this->receivedData << " (" << this->receivedBytes << " B)\n"
+		<< "Packets Sent = " << this->sentData << " (" << this->sentBytes << " B)\n"
+		<< "Drop Rate = " << this->dropRate << " packets/sec\n"
+		<< "Error Rate = " << this->errorRate << " errors/sec\n"
+		<< "TCP Retransmits = " << this->tcpRetransmits << " (" << this->tcpRetransmitRate << "/s, " << this->tcpRetransmitRatio << " %)\n"
+		<< "TCP Error Rate = " << this->tcpErrorRate << " segments/sec\n"
+		<< "UDP Errors = " << this->udpErrors << " (" << this->udpErrorRate << "/s)\n";
+
+	for(int i = 0; i < this->interfaces; i++){
+		const NetworkInterfaceMetrics &interface = this->interfaceMetrics[i];
+		std::cout << interface.name << ": "
+			<< interface.receiveRate << " KB/s, " << interface.receivePacketRate << " packets/s, "
+			<< interface.receiveDropRate << " drops/s, " << interface.receiveErrorRate << " errors/s received; "
+			<< interface.sendRate << " KB/s, " << interface.sendPacketRate << " packets/s, "
+			<< interface.sendDropRate << " drops/s, " << interface.sendErrorRate << " errors/s sent\n";
+	}
+
+	if(this->infinibandPorts > 0)
+		std::cout << "InfiniBand = " << this->infinibandReceiveRate << " KB/s received, "
+			<< this->infinibandTransmitRate << " KB/s sent\n";
+	for(int i = 0; i < this->infinibandPorts; i++){
+		const InfinibandPortMetrics &port = this->infinibandMetrics[i];
+		std::cout << port.name << " (state " << port.state << ", " << port.linkRate << " Gb/s): "
+			<< port.receiveRate << " KB/s, " << port.receivePacketRate << " packets/s received; "
+			<< port.transmitRate << " KB/s, " << port.transmitPacketRate << " packets/s sent; "
+			<< port.utilization << " %, " << port.waitRate << " wait ticks/s, "
+			<< port.linkErrors << " link, " << port.receiveErrors << " receive, " << port.transmitDiscards << " discard, "
+			<< port.transportErrors << " transport errors, " << port.outOfBuffer << " out of buffer\n";
+	}
 };
 
 
+static void getInfinibandMetrics(NetworkMetrics &networkMetrics){
+
+	// Ports keep their slots for the whole run, like the interfaces
+	const InfinibandReading &previous = previousSnapshot->infiniband, &current = currentSnapshot->infiniband;
+	bool interval = previous.ports == current.ports && previousSnapshot->timestamp != COUNTER_MISSING
+		&& currentSnapshot->timestamp > previousSnapshot->timestamp;
+	double seconds = interval ? (currentSnapshot->timestamp - previousSnapshot->timestamp) / 1e9 : 0;
+	double transmitRate = 0, receiveRate = 0;
+	bool measured = false;
+
+	networkMetrics.infinibandPorts = current.ports;
+	for(int i = 0; i < current.ports; i++){
+		InfinibandPortMetrics &port = networkMetrics.infinibandMetrics[i];
+		memcpy(port.name, current.names[i], INFINIBAND_NAME_LENGTH);
+		port.state = current.state[i];
+		port.linkRate = current.linkRate[i];							// Gb/sec
+		for(int j = 0; j < INFINIBAND_COUNTERS; j++)
+			if(current.bits[i][j] > 0 && current.bits[i][j] < 64 && current.counters[i][j] == (uint64_t(1) << current.bits[i][j]) - 1) port.saturatedCounters++;
+		if(!interval) continue;
+
+		// Increase of every counter, -1 where it is missing, saturated or was reset
+		double increase[INFINIBAND_COUNTERS];
+		uint64_t delta;
+		for(int j = 0; j < INFINIBAND_COUNTERS; j++)
+			increase[j] = infinibandDelta(previous.counters[i][j], current.counters[i][j], current.bits[i][j], delta) ? delta : -1;
+		// Error counters that could be read are summed, -1 only if none of them could
+		auto sum = [&increase](std::initializer_list<int> counters){
+			double total = -1;
+			for(int counter : counters)
+				if(increase[counter] >= 0) total = std::max(total, 0.0) + increase[counter];
+			return total;
+		};
+
+		// port_xmit_data and port_rcv_data count 4 byte words
+		if(increase[INFINIBAND_XMIT_DATA] >= 0) port.transmitRate = increase[INFINIBAND_XMIT_DATA] * 4 / seconds / KILOBYTE;	// KB/sec
+		if(increase[INFINIBAND_RCV_DATA] >= 0) port.receiveRate = increase[INFINIBAND_RCV_DATA] * 4 / seconds / KILOBYTE;	// KB/sec
+		if(increase[INFINIBAND_XMIT_PACKETS] >= 0) port.transmitPacketRate = increase[INFINIBAND_XMIT_PACKETS] / seconds;	// packets/sec
+		if(increase[INFINIBAND_RCV_PACKETS] >= 0) port.receivePacketRate = increase[INFINIBAND_RCV_PACKETS] / seconds;		// packets/sec
+		if(increase[INFINIBAND_XMIT_WAIT] >= 0) port.waitRate = increase[INFINIBAND_XMIT_WAIT] / seconds;			// ticks/sec
+		double busiest = std::max(port.transmitRate, port.receiveRate);
+		if(busiest >= 0 && port.linkRate > 0) port.utilization = busiest * KILOBYTE * 8 / (port.linkRate * 1e9) * 100;	// %
+
+		port.linkErrors = sum({INFINIBAND_SYMBOL_ERROR, INFINIBAND_LINK_ERROR_RECOVERY, INFINIBAND_LINK_DOWNED,
+			INFINIBAND_LOCAL_LINK_INTEGRITY_ERRORS, INFINIBAND_EXCESSIVE_BUFFER_OVERRUN_ERRORS});		// errors
+		port.receiveErrors = sum({INFINIBAND_RCV_ERRORS, INFINIBAND_RCV_REMOTE_PHYSICAL_ERRORS,
+			INFINIBAND_RCV_SWITCH_RELAY_ERRORS, INFINIBAND_RCV_CONSTRAINT_ERRORS, INFINIBAND_VL15_DROPPED});	// packets
+		port.transmitDiscards = sum({INFINIBAND_XMIT_DISCARDS, INFINIBAND_XMIT_CONSTRAINT_ERRORS});		// packets
+		if(infinibandDelta(previous.hwErrors[i], current.hwErrors[i], 64, delta)) port.transportErrors = delta;	// errors
+		if(infinibandDelta(previous.outOfBuffer[i], current.outOfBuffer[i], 64, delta)) port.outOfBuffer = delta;	// packets
+
+		if(port.transmitRate < 0 || port.receiveRate < 0) continue;
+		measured = true;
+		transmitRate += port.transmitRate;
+		receiveRate += port.receiveRate;
+	}
+
+	if(measured){
+		networkMetrics.infinibandTransmitRate = transmitRate;	// KB/sec
+		networkMetrics.infinibandReceiveRate = receiveRate;	// KB/sec
+	}
+};
+
 void getNetworkMetrics(NetworkMetrics &networkMetrics){
 
-	const char* command = "ifstat 1 1 | tail -1 | awk '{ print $1, $2 }'";
-	std::string output = exec(command), temp;
-	std::stringstream streamOne(output);
+	// Interfaces keep their slots for the whole run, so both snapshots have them in the same order
+	const NetworkReading &previous = previousSnapshot->network, &current = currentSnapshot->network;
+	uint64_t receivedBytes = 0, receivedPackets = 0, sentBytes = 0, sentPackets = 0;
+	double receiveRate = 0, sendRate = 0, dropRate = 0, errorRate = 0;
+	bool measured = false, counted = false;
+
+	networkMetrics.interfaces = current.interfaces;
+	for(int i = 0; i < current.interfaces; i++){
+		NetworkInterfaceMetrics &interface = networkMetrics.interfaceMetrics[i];
+		memcpy(interface.name, current.names[i], NETWORK_NAME_LENGTH);
+		if(!current.found[i]) continue;
+
+		const NetworkInterfaceCounters &now = current.counters[i];
+		interface.receivedBytes = now.receivedBytes;						// bytes
+		interface.receivedPackets = now.receivedPackets;					// number of packets
+		interface.sentBytes = now.sentBytes;							// bytes
+		interface.sentPackets = now.sentPackets;						// number of packets
+		counted = true;
+		receivedBytes += now.receivedBytes;
+		receivedPackets += now.receivedPackets;
+		sentBytes += now.sentBytes;
+		sentPackets += now.sentPackets;
+		if(i >= previous.interfaces || !previous.found[i]) continue;
+
+		// Counters go back to 0 when an interface is recreated, deltaRate() gives -1 for that sample
+		const NetworkInterfaceCounters &before = previous.counters[i];
+		double received = deltaRate(before.receivedBytes, now.receivedBytes);
+		double sent = deltaRate(before.sentBytes, now.sentBytes);
+		if(received >= 0) interface.receiveRate = received / KILOBYTE;				// KB/sec
+		if(sent >= 0) interface.sendRate = sent / KILOBYTE;					// KB/sec
+		interface.receivePacketRate = deltaRate(before.receivedPackets, now.receivedPackets);	// packets/sec
+		interface.sendPacketRate = deltaRate(before.sentPackets, now.sentPackets);		// packets/sec
+		interface.receiveDropRate = deltaRate(before.receiveDrops, now.receiveDrops);		// packets/sec
+		interface.sendDropRate = deltaRate(before.sendDrops, now.sendDrops);			// packets/sec
+		interface.receiveErrorRate = deltaRate(before.receiveErrors, now.receiveErrors);	// errors/sec
+		interface.sendErrorRate = deltaRate(before.sendErrors, now.sendErrors);			// errors/sec
 
-	streamOne >> temp;
-	networkMetrics.receivePacketRate = std::stof(temp);		// KB/sec
-	streamOne >> temp;
-	networkMetrics.sendPacketsRate = std::stof(temp);		// KB/sec
+		if(interface.receiveRate < 0 || interface.sendRate < 0) continue;
+		measured = true;
+		receiveRate += interface.receiveRate;
+		sendRate += interface.sendRate;
+		dropRate += std::max(interface.receiveDropRate, 0.0) + std::max(interface.sendDropRate, 0.0);
+		errorRate += std::max(interface.receiveErrorRate, 0.0) + std::max(interface.sendErrorRate, 0.0);
+	}
 
-	// Default interface: eth0
-	// des01 interface: ep0s31f6
-	command = "cat /proc/net/dev | awk '/^ *enp0s31f6:/ {rx=$3; tx=$11; print rx,tx; exit}'";
-	output = exec(command);
-	std::stringstream streamTwo(output);
+	if(counted){
+		networkMetrics.receivedData = receivedPackets;		// number of packets
+		networkMetrics.receivedBytes = receivedBytes;		// bytes
+		networkMetrics.sentData = sentPackets;			// number of packets
+		networkMetrics.sentBytes = sentBytes;			// bytes
+	}
+	if(measured){
+		networkMetrics.receivePacketRate = receiveRate;		// KB/sec
+		networkMetrics.sendPacketsRate = sendRate;		// KB/sec
+		networkMetrics.dropRate = dropRate;			// packets/sec
+		networkMetrics.errorRate = errorRate;			// errors/sec
+	}
 
-	streamTwo >> temp;
-	networkMetrics.receivedData = std::stoi(temp);			// number of packets
-	streamTwo >> temp;
-	networkMetrics.sentData = std::stoi(temp);			// number of packets
+	networkMetrics.tcpRetransmits = current.tcpRetransmits;						// segments
+	networkMetrics.udpErrors = current.udpErrors;							// datagrams
+	networkMetrics.tcpRetransmitRate = deltaRate(previous.tcpRetransmits, current.tcpRetransmits);	// segments/sec
+	networkMetrics.tcpErrorRate = deltaRate(previous.tcpErrors, current.tcpErrors);			// segments/sec
+	networkMetrics.udpErrorRate = deltaRate(previous.udpErrors, current.udpErrors);			// datagrams/sec
+	networkMetrics.tcpRetransmitRatio = rateRatio(networkMetrics.tcpRetransmitRate,
+		deltaRate(previous.tcpSegmentsSent, current.tcpSegmentsSent));
+	if(networkMetrics.tcpRetransmitRatio > 0) networkMetrics.tcpRetransmitRatio *= 100;		// %
+
+	getInfinibandMetrics(networkMetrics);
 
 	//networkMetrics.printNetworkMetrics();
 };
@@ -386,7 +1504,18 @@ PowerMetrics::PowerMetrics(){
 	this->processorPower = -1;
 	this->memoryPower = -1;
 	this->systemPower = -1;
-	this->gpuPower = 1;
+	this->packages = 0;
+	for(int i = 0; i < RAPL_MAX_PACKAGES; i++){
+		this->packagePower[i] = -1;
+		this->corePower[i] = -1;
+		this->dramPower[i] = -1;
+	}
+	this->platformPower = -1;
+	this->meterPower = -1;
+	this->meterEnergy = -1;
+	this->meterPeakPower = -1;
+	this->meterSamples = 0;
+	this->gpuPower = -1;
 	this->gpuTemperature = -1;
 	this->gpuFanSpeed = -1;
 	this->gpuMemoryTotal = -1;
@@ -394,6 +1523,21 @@ PowerMetrics::PowerMetrics(){
 	this->gpuMemoryFree = -1;
 	this->gpuClocksCurrentSM = -1;
 	this->gpuClocksCurrentMemory = -1;
+	this->gpus = 0;
+};
+
+GpuDeviceMetrics::GpuDeviceMetrics(){
+	this->name[0] = '\0';
+	this->power = -1;
+	this->temperature = -1;
+	this->fanSpeed = -1;
+	this->memoryTotal = -1;
+	this->memoryUsed = -1;
+	this->memoryFree = -1;
+	this->clocksSM = -1;
+	this->clocksMemory = -1;
+	this->utilization = -1;
+	this->memoryUtilization = -1;
 };
 
 void PowerMetrics::printPowerMetrics(){
@@ -401,7 +1545,13 @@ void PowerMetrics::printPowerMetrics(){
 	std::cout << "\n\t[POWER METRICS]\n"
 		<< "Processor = " << this->processorPower << "W\n"
 		<< "Memory = " << this->memoryPower << "W\n"
-		<< "System = " << this->systemPower << "W\n"
+		<< "System = " << this->systemPower << "W\n";
+	for(int i = 0; i < this->packages; i++)
+		std::cout << "Package " << i << " = " << this->packagePower[i] << "W (cores "
+			<< this->corePower[i] << "W, memory " << this->dramPower[i] << "W)\n";
+	std::cout << "Platform = " << this->platformPower << "W\n"
+		<< "Meter = " << this->meterPower << "W (" << this->meterEnergy << " J, peak " << this->meterPeakPower << "W, "
+		<< this->meterSamples << " readings)\n"
 		<< "GPU = " << this->gpuPower << "W\n"
 		<< "GPU Temperature = " << this->gpuTemperature << "C\n"		
 		<< "GPU Fan Speed = " << this->gpuFanSpeed << "%\n"
@@ -410,68 +1560,287 @@ void PowerMetrics::printPowerMetrics(){
 		<< "GPU Memory Free = " << this->gpuMemoryFree << "MB\n"
 		<< "GPU Clocks Current SM = " << this->gpuClocksCurrentSM << "MHz\n"
 		<< "GPU Clocks Current Memory = " << this->gpuClocksCurrentMemory << "MHz\n";
+	for(int i = 0; i < this->gpus; i++){
+		const GpuDeviceMetrics &gpu = this->gpuMetrics[i];
+		std::cout << "GPU " << i << " (" << gpu.name << ") = " << gpu.power << "W, " << gpu.temperature << "C, "
+			<< gpu.utilization << "% busy, " << gpu.memoryUsed << "/" << gpu.memoryTotal << "MB, "
+			<< gpu.clocksSM << "/" << gpu.clocksMemory << "MHz\n";
+	}
 };
 
 void getPowerMetrics(PowerMetrics &powerMetrics){
 
-	const char* command = "perf stat -e power/energy-cores/,power/energy-ram/,power/energy-pkg/ sleep 1 2>&1 | awk '/Joules/ {print $1}' | tr ',' '.'";
-	std::string output = exec(command), temp;
-	std::stringstream streamOne(output);
-	
-	streamOne >> temp;
-	powerMetrics.processorPower = std::stof(temp);
-	streamOne >> temp;
-	powerMetrics.memoryPower = std::stof(temp);
-	streamOne >> temp;
-	powerMetrics.systemPower = std::stof(temp);
-
-	command = "nvidia-smi --query-gpu=power.draw,temperature.gpu,fan.speed,memory.total,memory.used,memory.free,clocks.current.sm,clocks.current.memory --format=csv,nounits,noheader | tr ',' ' '";
-	output = exec(command);
-	std::stringstream streamTwo(output);
-	
-	streamTwo >> temp;
-	powerMetrics.gpuPower = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuTemperature = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuFanSpeed = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuMemoryTotal = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuMemoryUsed = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuMemoryFree = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuClocksCurrentSM = std::stof(temp);
-	streamTwo >> temp >> temp;
-	powerMetrics.gpuClocksCurrentMemory = std::stof(temp);
+	// Energy counters were read with the snapshot, so the power covers the time since the previous one
+	const RaplReading &reading = currentSnapshot->rapl;
+	if(reading.elapsedTime > 0){
+		powerMetrics.packages = reading.packages;
+		powerMetrics.processorPower = sumPackages(reading.power[RAPL_CORE], reading.packages);	// W
+		powerMetrics.memoryPower = sumPackages(reading.power[RAPL_DRAM], reading.packages);	// W
+		powerMetrics.systemPower = sumPackages(reading.power[RAPL_PACKAGE], reading.packages);	// W
+		for(int i = 0; i < reading.packages; i++){
+			powerMetrics.packagePower[i] = reading.power[RAPL_PACKAGE][i];		// W
+			powerMetrics.corePower[i] = reading.power[RAPL_CORE][i];		// W
+			powerMetrics.dramPower[i] = reading.power[RAPL_DRAM][i];		// W
+		}
+		powerMetrics.platformPower = reading.power[RAPL_PSYS][0];			// W
+	}
+
+	// The meter sees the whole node at the wall, so it replaces the package power as the system power
+	MeterReading meter;
+	if(powerMeterOpen && previousSnapshot->timestamp != COUNTER_MISSING
+		&& powerMeter.read(previousSnapshot->timestamp, currentSnapshot->timestamp, meter)){
+		powerMetrics.meterPower = meter.power;						// W
+		powerMetrics.meterEnergy = meter.energy;					// J
+		powerMetrics.meterPeakPower = meter.peakPower;					// W
+		powerMetrics.meterSamples = meter.samples;					// number of readings
+		powerMetrics.systemPower = meter.power;						// W
+	}
+
+	// Every GPU separately, the node values add up the power and memory and take the hottest GPU and fastest fan
+	const GpuReading &gpu = currentSnapshot->gpu;
+	float power = -1, temperature = -1, fanSpeed = -1, memoryTotal = -1, memoryUsed = -1, memoryFree = -1;
+	float clocksSM = 0, clocksMemory = 0;
+	int clocked = 0;
+	powerMetrics.gpus = gpu.devices;
+	for(int i = 0; i < gpu.devices; i++){
+		GpuDeviceMetrics &device = powerMetrics.gpuMetrics[i];
+		memcpy(device.name, gpu.names[i], GPU_NAME_LENGTH);
+		device.power = gpu.power[i];							// W
+		device.temperature = gpu.temperature[i];					// C
+		device.fanSpeed = gpu.fanSpeed[i];						// %
+		device.memoryTotal = gpu.memoryTotal[i];					// MB
+		device.memoryUsed = gpu.memoryUsed[i];						// MB
+		device.memoryFree = gpu.memoryFree[i];						// MB
+		device.clocksSM = gpu.clockSM[i];						// MHz
+		device.clocksMemory = gpu.clockMemory[i];					// MHz
+		device.utilization = gpu.utilization[i];					// %
+		device.memoryUtilization = gpu.memoryUtilization[i];				// %
+
+		if(device.power >= 0) power = std::max(power, 0.0f) + device.power;
+		if(device.memoryTotal >= 0){
+			memoryTotal = std::max(memoryTotal, 0.0f) + device.memoryTotal;
+			memoryUsed = std::max(memoryUsed, 0.0f) + device.memoryUsed;
+			memoryFree = std::max(memoryFree, 0.0f) + device.memoryFree;
+		}
+		temperature = std::max(temperature, device.temperature);
+		fanSpeed = std::max(fanSpeed, device.fanSpeed);
+		if(device.clocksSM < 0 || device.clocksMemory < 0) continue;
+		clocksSM += device.clocksSM;
+		clocksMemory += device.clocksMemory;
+		clocked++;
+	}
+	powerMetrics.gpuPower = power;									// W
+	powerMetrics.gpuTemperature = temperature;							// C
+	powerMetrics.gpuFanSpeed = fanSpeed;								// %
+	powerMetrics.gpuMemoryTotal = memoryTotal;							// MB
+	powerMetrics.gpuMemoryUsed = memoryUsed;							// MB
+	powerMetrics.gpuMemoryFree = memoryFree;							// MB
+	powerMetrics.gpuClocksCurrentSM = clocked ? clocksSM / clocked : -1;				// MHz
+	powerMetrics.gpuClocksCurrentMemory = clocked ? clocksMemory / clocked : -1;			// MHz
 	
 	//powerMetrics.printPowerMetrics();
 };
 
+PressureResourceMetrics::PressureResourceMetrics(){
+	this->someAvg10 = -1;
+	this->fullAvg10 = -1;
+	this->someTotal = COUNTER_MISSING;
+	this->fullTotal = COUNTER_MISSING;
+	this->someStall = -1;
+	this->fullStall = -1;
+	this->someStallRatio = -1;
+	this->fullStallRatio = -1;
+};
+
+PressureMetrics::PressureMetrics(){
+	this->triggerEvents = 0;
+	this->firstTriggerDelay = -1;
+};
+
+void PressureMetrics::printPressureMetrics(){
+
+	const char* names[PRESSURE_RESOURCES] = {"CPU", "Memory", "I/O"};
+	std::cout << "\n\t[PRESSURE METRICS]\n\n";
+	for(int i = 0; i < PRESSURE_RESOURCES; i++)
+		std::cout << names[i] << " Some Stall = " << this->system[i].someStallRatio << " % (avg10 " << this->system[i].someAvg10 << " %)\n"
+			<< names[i] << " Full Stall = " << this->system[i].fullStallRatio << " % (avg10 " << this->system[i].fullAvg10 << " %)\n"
+			<< "Cgroup " << names[i] << " Some Stall = " << this->cgroup[i].someStallRatio << " %\n"
+			<< "Cgroup " << names[i] << " Full Stall = " << this->cgroup[i].fullStallRatio << " %\n";
+	std::cout << "Trigger Events = " << this->triggerEvents << "\n"
+		<< "First Trigger Delay = " << this->firstTriggerDelay << " ms\n";
+};
+
+// Stall time of one pressure file during the interval, the totals are in us
+static void getPressureResource(PressureResourceMetrics &metrics, const PressureCounters &previous, const PressureCounters &current){
+
+	metrics.someAvg10 = current.someAvg10;								// %
+	metrics.fullAvg10 = current.fullAvg10;								// %
+	metrics.someTotal = current.someTotal;								// us
+	metrics.fullTotal = current.fullTotal;								// us
+
+	// Stalled us per second, 10^6 of them would be the whole interval
+	double someRate = deltaRate(previous.someTotal, current.someTotal);
+	double fullRate = deltaRate(previous.fullTotal, current.fullTotal);
+	if(someRate >= 0){
+		metrics.someStall = current.someTotal - previous.someTotal;				// us
+		metrics.someStallRatio = someRate / 1e4;						// %
+	}
+	if(fullRate >= 0){
+		metrics.fullStall = current.fullTotal - previous.fullTotal;				// us
+		metrics.fullStallRatio = fullRate / 1e4;						// %
+	}
+};
+
+void getPressureMetrics(PressureMetrics &pressureMetrics){
+
+	const PressureReading &previous = previousSnapshot->pressure, &current = currentSnapshot->pressure;
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		getPressureResource(pressureMetrics.system[i], previous.system[i], current.system[i]);
+		if(pressureCgroupOpen) getPressureResource(pressureMetrics.cgroup[i], previous.cgroup[i], current.cgroup[i]);
+	}
+
+	// Triggers are counted while the sampler sleeps, they belong to the interval that ends with this snapshot
+	pressureMetrics.triggerEvents = current.triggerEvents;
+	pressureMetrics.firstTriggerDelay = -1;
+	if(current.triggerEvents && previousSnapshot->timestamp != COUNTER_MISSING && current.firstTrigger >= previousSnapshot->timestamp)
+		pressureMetrics.firstTriggerDelay = (current.firstTrigger - previousSnapshot->timestamp) / 1e6;	// ms
+
+	//pressureMetrics.printPressureMetrics();
+};
+
+JobMetrics::JobMetrics(){
+	memset(this->cgroup, 0, sizeof(this->cgroup));
+	this->cpuUsage = -1;
+	this->cpuUser = -1;
+	this->cpuSystem = -1;
+	this->cpuShare = -1;
+	this->throttledPeriods = -1;
+	this->throttledTime = -1;
+	this->memoryCurrent = -1;
+	this->memoryAnon = -1;
+	this->memoryFile = -1;
+	this->memoryKernel = -1;
+	this->memoryShmem = -1;
+	this->pageFaultRate = -1;
+	this->majorFaultRate = -1;
+	this->dataReadRate = -1;
+	this->dataWrittenRate = -1;
+	this->readRate = -1;
+	this->writeRate = -1;
+	this->power = -1;
+};
+
+void JobMetrics::printJobMetrics(){
+	std::cout << "Cgroup = " << this->cgroup << "\n"
+		<< "CPU Usage = " << this->cpuUsage << " % (user " << this->cpuUser << " %, system " << this->cpuSystem << " %)\n"
+		<< "CPU Share of the Node = " << this->cpuShare << " %\n"
+		<< "Throttled = " << this->throttledPeriods << " % of periods, " << this->throttledTime << " ms/s\n"
+		<< "Memory = " << this->memoryCurrent << " MB (anon " << this->memoryAnon << " MB, file " << this->memoryFile
+		<< " MB, kernel " << this->memoryKernel << " MB, shmem " << this->memoryShmem << " MB)\n"
+		<< "Page Faults = " << this->pageFaultRate << " /s, major " << this->majorFaultRate << " /s\n"
+		<< "Data Read = " << this->dataReadRate << " MB/s, Data Written = " << this->dataWrittenRate << " MB/s\n"
+		<< "Read Operations = " << this->readRate << " /s, Write Operations = " << this->writeRate << " /s\n"
+		<< "Power = " << this->power << " W\n";
+};
+
+// Bytes of one memory.stat or memory.current value in MB, -1 if missing
+static double cgroupMegabytes(uint64_t bytes){
+	return bytes == COUNTER_MISSING ? -1 : double(bytes) / KILOBYTE / KILOBYTE;
+};
+
+void getJobMetrics(JobMetrics &jobMetrics){
+
+	// The end of the path tells jobs apart, e.g. .../job_42/step_0
+	std::string directory = jobCgroup.directory();
+	if(!directory.rfind(CGROUP_ROOT, 0)) directory.erase(0, strlen(CGROUP_ROOT));
+	if(directory.size() >= CGROUP_PATH_LENGTH) directory.erase(0, directory.size() - CGROUP_PATH_LENGTH + 1);
+	strncpy(jobMetrics.cgroup, directory.c_str(), CGROUP_PATH_LENGTH - 1);
+	if(!jobCgroupOpen) return;
+
+	const CgroupReading &previous = previousSnapshot->job, &current = currentSnapshot->job;
+
+	// us of CPU time per second, 10^6 of them are one CPU fully used
+	double usage = deltaRate(previous.usageTime, current.usageTime);
+	double user = deltaRate(previous.userTime, current.userTime);
+	double system = deltaRate(previous.systemTime, current.systemTime);
+	if(usage >= 0) jobMetrics.cpuUsage = usage / 1e4;						// %
+	if(user >= 0) jobMetrics.cpuUser = user / 1e4;							// %
+	if(system >= 0) jobMetrics.cpuSystem = system / 1e4;						// %
+
+	// The periods are counted only while cpu.max limits the cgroup
+	double periods = deltaRate(previous.periods, current.periods);
+	double throttled = deltaRate(previous.throttledPeriods, current.throttledPeriods);
+	double throttledTime = deltaRate(previous.throttledTime, current.throttledTime);
+	if(rateRatio(throttled, periods) >= 0) jobMetrics.throttledPeriods = rateRatio(throttled, periods) * 100;	// %
+	if(throttledTime >= 0) jobMetrics.throttledTime = throttledTime / 1000;			// ms/s
+
+	jobMetrics.memoryCurrent = cgroupMegabytes(current.memoryCurrent);				// MB
+	jobMetrics.memoryAnon = cgroupMegabytes(current.memoryAnon);					// MB
+	jobMetrics.memoryFile = cgroupMegabytes(current.memoryFile);					// MB
+	jobMetrics.memoryKernel = cgroupMegabytes(current.memoryKernel);				// MB
+	jobMetrics.memoryShmem = cgroupMegabytes(current.memoryShmem);					// MB
+	jobMetrics.pageFaultRate = deltaRate(previous.pageFaults, current.pageFaults);			// faults/sec
+	jobMetrics.majorFaultRate = deltaRate(previous.majorFaults, current.majorFaults);		// faults/sec
+
+	double bytesRead = deltaRate(previous.bytesRead, current.bytesRead);
+	double bytesWritten = deltaRate(previous.bytesWritten, current.bytesWritten);
+	if(bytesRead >= 0) jobMetrics.dataReadRate = bytesRead / KILOBYTE / KILOBYTE;			// MB/s
+	if(bytesWritten >= 0) jobMetrics.dataWrittenRate = bytesWritten / KILOBYTE / KILOBYTE;		// MB/s
+	jobMetrics.readRate = deltaRate(previous.readOperations, current.readOperations);		// operations/sec
+	jobMetrics.writeRate = deltaRate(previous.writeOperations, current.writeOperations);		// operations/sec
+
+	// Busy time of the node is everything but idle and iowait, guest is already a part of user
+	uint64_t busy = 0;
+	for(int i = 0; i < TOPOLOGY_CPU_TIMES - 1; i++){
+		if(i == 3 || i == 4) continue;
+		if(previousSnapshot->cpuTimes[i] == COUNTER_MISSING || currentSnapshot->cpuTimes[i] == COUNTER_MISSING
+			|| currentSnapshot->cpuTimes[i] < previousSnapshot->cpuTimes[i]) return;
+		busy += currentSnapshot->cpuTimes[i] - previousSnapshot->cpuTimes[i];
+	}
+	if(usage < 0 || !busy) return;
+	double busyTime = double(busy) / sysconf(_SC_CLK_TCK) * 1e6;					// us
+	double jobTime = current.usageTime - previous.usageTime;					// us
+	jobMetrics.cpuShare = std::min(jobTime / busyTime * 100, 100.0);				// %
+
+	// Energy is split by CPU time, the same way the node is shared by the jobs running on it. The power
+	// comes from the last sample of the power collector, which can run at another period.
+	const RaplReading &reading = groupSnapshots[METRIC_POWER][currentSlots[METRIC_POWER]].rapl;
+	float packagePower = reading.elapsedTime > 0 ? sumPackages(reading.power[RAPL_PACKAGE], reading.packages) : -1;
+	if(packagePower >= 0) jobMetrics.power = packagePower * jobMetrics.cpuShare / 100;		// W
+
+	//jobMetrics.printJobMetrics();
+};
+
 AllMetrics::AllMetrics(){
+	this->groups = 0;
+	for(int64_t &timestamp : this->timestamps) timestamp = 0;
+	this->deadline = 0;
+	this->jitter = 0;
+	this->sampleRealTime = 0;
+	this->sampleMonotonicTime = 0;
+	this->clockOffset = 0;
+	this->clockDrift = 0;
 	this->systemMetrics = SystemMetrics();
 	this->processorMetrics = ProcessorMetrics();
 	this->inputOutputMetrics = InputOutputMetrics();
+	this->processMetrics = ProcessMetrics();
 	this->memoryMetrics = MemoryMetrics();
 	this->networkMetrics = NetworkMetrics();
 	this->powerMetrics = PowerMetrics();
+	this->pressureMetrics = PressureMetrics();
+	this->jobMetrics = JobMetrics();
 };
 
-// Execute a Linux command and return the output using std::string
-std::string exec(const char* cmd){
-
-	std::array<char, 128> buffer;
-	std::string result;
-	std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
+// Resources used so far by the calling thread. Neither the threads of the writer and the power meter
+// nor the launched command, whose CPU time would land in RUSAGE_CHILDREN once it is reaped, count.
+SamplingCost getSamplingCost(){
 
-	if (!pipe)
-		throw std::runtime_error("popen() failed!");
-	while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr)
-		result += buffer.data();
+	SamplingCost samplingCost;
+	struct rusage thread;
+	getrusage(RUSAGE_THREAD, &thread);
 
-	if(!result.length())
-		std::cout << "\n\n\t[ERROR] String returned by exec() has length 0\n";
+	samplingCost.cpuTime = (thread.ru_utime.tv_sec + thread.ru_stime.tv_sec) * 1000.0
+		+ (thread.ru_utime.tv_usec + thread.ru_stime.tv_usec) / 1000.0;
 
-	return result;
-};
\ No newline at end of file
+	return samplingCost;
+};
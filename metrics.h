@@ -8,135 +8,476 @@
 
 // External libraries
 #include <string>	// string
+#include <cstdint>	// uint64_t, UINT64_MAX
+// Internal headers
+#include "rapl-power.h"
+#include "block-devices.h"
+#include "network-interfaces.h"
+#include "infiniband-ports.h"
+#include "gpu-devices.h"
+#include "power-meter.h"
+#include "cpu-topology.h"
+#include "cpu-frequency.h"
+#include "pressure-stall.h"
+#include "cgroup-accounting.h"
+#include "interrupt-counters.h"
 
 #ifndef METRICS_H
 #define METRICS_H
-#define GPROCESSID 1				// PID of process that we are focused on (G stands for global)
+#define GPROCESSID 1				// Default root of the monitored process tree (G stands for global)
+#define COUNTER_MISSING UINT64_MAX		// Cumulative counter that could not be read
+#define METRIC_BIT(group) (1u << (group))	// Bit of a collector in a set of collectors
+#define METRIC_ALL_GROUPS ((1u << METRIC_GROUPS) - 1)
+
+// Sections of AllMetrics, every one is filled by its own collector at its own period
+enum MetricGroup {
+	METRIC_SYSTEM,
+	METRIC_PROCESSOR,
+	METRIC_INPUT_OUTPUT,
+	METRIC_PROCESS,
+	METRIC_MEMORY,
+	METRIC_NETWORK,
+	METRIC_POWER,
+	METRIC_PRESSURE,
+	METRIC_JOB,
+	METRIC_GROUPS
+};
+
+struct InterruptMetrics {
+	char name[INTERRUPT_NAME_LENGTH];	// IRQ number or name, e.g. 35, LOC, NET_RX
+	char device[INTERRUPT_DEVICE_LENGTH];	// Handlers of the IRQ, e.g. eth0-TxRx-0, empty for softirqs
+	int cpu;				// CPU that handled them
+	uint64_t count;				// Handled on this CPU since boot
+	double rate;				// Handled on this CPU per second
+
+	InterruptMetrics();
+};
 
 struct SystemMetrics {
-	int processesRunning;			// Number of processes in the R state
-	int processesAll;			// Number of all processes
-	int processesBlocked;			// Number of processes waiting for I/O operation to complete
-	int contextSwitchRate;			// Number of context switches per second
-	int interruptRate;			// Number of all interrupts handled per second
+	int processesRunning;			// Number of threads in the R state (procs_running)
+	int processesAll;			// Number of all threads (kernel scheduling entities)
+	int processesBlocked;			// Number of threads waiting for I/O operation to complete (procs_blocked)
+	uint64_t contextSwitches;		// Number of context switches since boot
+	uint64_t interrupts;			// Number of all interrupts handled since boot
+	uint64_t processesCreated;		// Number of forks and clones since boot
+	double contextSwitchRate;		// Number of context switches per second
+	double interruptRate;			// Number of all interrupts handled per second
+	double processCreationRate;		// Number of forks and clones per second
+	uint64_t softInterrupts;		// Number of softirqs handled since boot
+	double softInterruptRate;		// Number of softirqs handled per second
+	int interruptCpu;			// CPU handling the most interrupts, -1 if none was handled
+	double interruptCpuRate;		// Interrupts handled per second by interruptCpu
+	int softInterruptCpu;			// CPU handling the most softirqs, -1 if none was handled
+	double softInterruptCpuRate;		// Softirqs handled per second by softInterruptCpu
+	int topInterrupts;			// Number of pairs in interruptMetrics
+	InterruptMetrics interruptMetrics[INTERRUPT_TOP];	// Busiest IRQ/CPU pairs of /proc/interrupts, busiest first
+	int topSoftInterrupts;			// Number of pairs in softInterruptMetrics
+	InterruptMetrics softInterruptMetrics[INTERRUPT_TOP];	// Busiest softirq/CPU pairs of /proc/softirqs
 
 	SystemMetrics();
     	void printSystemMetrics();
 };
 
+struct CpuMetrics {
+	int cpu;				// Logical CPU number, cpuN in /proc/stat
+	int core;				// Physical core numbered from 0 over all sockets, SMT siblings share it
+	int socket;				// Socket numbered from 0
+	int node;				// NUMA node numbered from 0
+	float busy;				// Time not spent idle or waiting for I/O in %
+	float user;				// Time spent in user space, nice included, in %
+	float system;				// Time spent in kernel space, IRQ and SoftIRQ included, in %
+	float ioWait;				// Time spent waiting for I/O operation to complete in %
+	float frequency;			// scaling_cur_freq in MHz
+	float effectiveFrequency;		// Frequency while not halted from APERF/MPERF in MHz
+	float idleResidency;			// Time spent in idle states other than POLL in %
+	float throttleTime;			// Time the core or its package was thermally throttled in %
+
+	CpuMetrics();
+};
+
 struct ProcessorMetrics {
-	int timeUser;				// Time spent in user space
-	int timeNice;				// Time spent in user with low priority space
-	int timeSystem;				// Time spent in system space
-	int timeIdle;				// Time spent on idle task
-	int timeIoWait;				// Time spent waiting for I/O operation to complete
-	int timeIRQ;				// Interrupt handling time
-	int timeSoftIRQ;			// SoftIRQ handling time
-	int timeSteal;				// Time spent in other OSs in visualization mode
-	int timeGuest;				// Virtual CPU uptime for other OSs under kernel control
-	int instructionsRetired;		// Number of instructions executed by the processor
-	int cycles;				// Number of cycles executed by the processor
-	float frequencyRelative;		// CPU clock frequency in MHz
-	float unhaltedFrequency;		// unhalted CPU clock frequency in MHz
-	int cacheL2Requests;			// L2 cache requests issued by the processor
-	int cacheL2Misses;			// L2 cache misses
-	int cacheLLCLoads;			// Number of cache loads from the Last Level Cache
-	int cacheLLCStores;			// Number of cache stores to the LLC
-	int cacheLLCLoadMisses;			// Number of LLC load misses 
-	float cacheLLCLoadMissRate;		// LLC load misses divided by LLC loads
-	int cacheLLCStoreMisses;		// Number of LLC store misses
-	float cacheLLCStoreMissRate;		// LLC store misses divided by LLC stores
+	double timeUser;			// Time spent in user space in %
+	double timeNice;			// Time spent in user with low priority space in %
+	double timeSystem;			// Time spent in system space in %
+	double timeIdle;			// Time spent on idle task in %
+	double timeIoWait;			// Time spent waiting for I/O operation to complete in %
+	double timeIRQ;				// Interrupt handling time in %
+	double timeSoftIRQ;			// SoftIRQ handling time in %
+	double timeSteal;			// Time spent in other OSs in visualization mode in %
+	double timeGuest;			// Virtual CPU uptime for other OSs under kernel control in %
+	uint64_t instructionsRetired;		// Number of instructions executed by the processor since the start
+	uint64_t cycles;			// Number of cycles executed by the processor since the start
+	double instructionsPerSecond;		// Number of instructions executed by the processor per second
+	double cyclesPerSecond;			// Number of cycles executed by the processor per second
+	double frequencyRelative;		// Unhalted clock frequency relative to the nominal one in %
+	double unhaltedFrequency;		// Unhalted CPU clock frequency in MHz
+	uint64_t cacheL2Requests;		// L2 cache requests issued by the processor since the start
+	uint64_t cacheL2Misses;			// L2 cache misses since the start
+	uint64_t cacheLLCLoads;			// Number of cache loads from the Last Level Cache since the start
+	uint64_t cacheLLCStores;		// Number of cache stores to the LLC since the start
+	uint64_t cacheLLCLoadMisses;		// Number of LLC load misses since the start
+	uint64_t cacheLLCStoreMisses;		// Number of LLC store misses since the start
+	double cacheL2RequestsPerSecond;	// L2 cache requests per second
+	double cacheL2MissesPerSecond;		// L2 cache misses per second
+	double cacheLLCLoadsPerSecond;		// LLC loads per second
+	double cacheLLCStoresPerSecond;		// LLC stores per second
+	double cacheLLCLoadMissesPerSecond;	// LLC load misses per second
+	double cacheLLCStoreMissesPerSecond;	// LLC store misses per second
+	double cacheLLCLoadMissRate;		// LLC load misses divided by LLC loads in %
+	double cacheLLCStoreMissRate;		// LLC store misses divided by LLC stores in %
+	int cpus;				// Number of logical CPUs online
+	int cores;				// Number of physical cores
+	int sockets;				// Number of sockets
+	int numaNodes;				// Number of NUMA nodes
+	double cpuBusyMax;			// Busy time of the busiest logical CPU in %
+	double cpuBusyMin;			// Busy time of the least busy logical CPU in %
+	double cpuBusyDeviation;		// Standard deviation of the busy time over the logical CPUs
+	double coreBusyMax;			// Busy time of the busiest physical core, its SMT siblings averaged, in %
+	double coreBusyMin;			// Busy time of the least busy physical core in %
+	float socketBusy[TOPOLOGY_MAX_SOCKETS];	// Busy time of each socket in %
+	float nodeBusy[TOPOLOGY_MAX_NODES];	// Busy time of each NUMA node in %
+	double frequencyMean;			// scaling_cur_freq averaged over the logical CPUs in MHz
+	double frequencyMin;			// scaling_cur_freq of the slowest logical CPU in MHz
+	double frequencyMax;			// scaling_cur_freq of the fastest logical CPU in MHz
+	double effectiveFrequency;		// Frequency while not halted from APERF/MPERF averaged over the CPUs in MHz
+	double coreThrottleRate;		// Thermal throttling events of all cores per second
+	double packageThrottleRate;		// Thermal throttling events of all packages per second
+	double coreThrottleTime;		// Time the most throttled core was throttled in %
+	double packageThrottleTime;		// Time the most throttled package was throttled in %
+	int idleStates;				// Number of cpuidle states, e.g. POLL, C1, C1E, C6
+	char idleStateNames[IDLE_MAX_STATES][IDLE_NAME_LENGTH];	// Name of every idle state
+	float idleStateResidency[IDLE_MAX_STATES];	// Time spent in every idle state averaged over the CPUs in %
+	float idleStateRate[IDLE_MAX_STATES];	// Entries to every idle state per second and CPU
+	CpuMetrics cpuMetrics[TOPOLOGY_MAX_CPUS];	// Every logical CPU, only the first cpus are valid
 
     	ProcessorMetrics();
     	void printProcessorMetrics();
 };
 
+struct BlockDeviceMetrics {
+	char name[BLOCK_NAME_LENGTH];		// Name of the device, e.g. sda, nvme0n1, md0
+	int stacked;				// 1 for dm and md devices, they are left out of the node totals
+	uint64_t reads;				// Reads completed since boot
+	uint64_t writes;			// Writes completed since boot
+	uint64_t dataRead;			// Data read since boot in bytes
+	uint64_t dataWritten;			// Data written since boot in bytes
+	double readRate;			// Reads completed per second
+	double writeRate;			// Writes completed per second
+	double dataReadRate;			// Data read per second in MB/s
+	double dataWrittenRate;			// Data written per second in MB/s
+	double readTime;			// Average time of a read in ms
+	double writeTime;			// Average time of a write in ms
+	double flushRate;			// Flushes completed per second
+	double flushTime;			// Average time of a flush in ms
+	double queueDepth;			// Average number of requests in flight
+	double utilization;			// Time with at least one request in flight in %
+
+	BlockDeviceMetrics();
+};
+
 struct InputOutputMetrics {
 	int processID;				// Process ID of a given task 
-	float dataRead;				// Data read
-	float readTime;				// Data read time
-	int readOperationsRate;			// Amount of read operations per second
-	float dataWritten;			// Data written
-	float writeTime;			// Data write time
-	int writeOperationsRate;		// Amount of write operations per second
-	float flushTime;			// Flush execution time
-	float flushOperationsRate;		// Amount of flush operations per second
+	uint64_t dataRead;			// Data read by the process since its start in bytes
+	uint64_t dataWritten;			// Data written by the process since its start in bytes
+	uint64_t readOperations;		// Read system calls of the process since its start
+	uint64_t writeOperations;		// Write system calls of the process since its start
+	double dataReadRate;			// Data read per second in MB/s
+	double dataWrittenRate;			// Data written per second in MB/s
+	double readOperationsRate;		// Amount of read operations per second
+	double writeOperationsRate;		// Amount of write operations per second
+	double diskReadRate;			// Reads completed per second by all devices of the node
+	double diskWriteRate;			// Writes completed per second by all devices of the node
+	double diskDataReadRate;		// Data read per second from all devices of the node in MB/s
+	double diskDataWrittenRate;		// Data written per second to all devices of the node in MB/s
+	double diskReadTime;			// Average time of a read on the node in ms
+	double diskWriteTime;			// Average time of a write on the node in ms
+	double diskUtilization;			// Utilization of the busiest device in %
+	int devices;				// Number of block devices in deviceMetrics
+	BlockDeviceMetrics deviceMetrics[BLOCK_MAX_DEVICES];	// Every block device of the node
 
 	InputOutputMetrics();
    	void printInputOutputMetrics();
 };
 
+struct ProcessMetrics {
+	int processID;				// Root of the monitored process tree
+	int processes;				// Processes of the tree alive at the sample
+	int threads;				// Threads of these processes
+	uint64_t cpuTime;			// User and system time of the whole tree in ms, exited processes included
+	double cpuUsage;			// CPU time of the tree per second in % of one CPU
+	double memoryResident;			// Resident memory of the live processes in MB
+	uint64_t contextSwitches;		// Voluntary and involuntary context switches of the tree
+	double contextSwitchRate;		// Context switches of the tree per second
+
+	ProcessMetrics();
+	void printProcessMetrics();
+};
+
 struct MemoryMetrics {
-	float memoryUsed;			// RAM used
-	float memoryCached;			// Cache for files read from disk
-	float swapUsed;				// Swap memory used
-	float swapCached;			// Data previously written from memory to disk,
+	double memoryTotal;			// RAM installed
+	double memoryUsed;			// RAM used, MemTotal - MemAvailable
+	double memoryAvailable;			// RAM that can be allocated without swapping
+	double memoryCached;			// Cache for files read from disk
+	double swapUsed;			// Swap memory used
+	double swapCached;			// Data previously written from memory to disk,
 						// fetched back and still in the swap file
-	float memoryActive;			// Data used in the last period
-	float memoryInactive;			// Data used before memoryActive
-	float pageInRate;			// Pages read
-	float pageOutRate;			// Pages saved
-	float pageFaultRate;			// No page status
-	float pageFaultsMajorRate;		// Page missing (need to load from disk)
-	float pageFreeRate;			// Page release
-	float pageActivateRate;			// Page activation
-	float pageDeactivateRate;		// Page deactivation
-	float memoryReadRate;			// Reading from memory
-	float memoryWriteRate;			// Writing to memory
-	float memoryIoRate;			// Requests to read/write data from all I/O devices
+	double memoryActive;			// Data used in the last period
+	double memoryInactive;			// Data used before memoryActive
+	double memoryHugePages;			// Anonymous memory in transparent huge pages
+	double pageInRate;			// Data paged in from block devices in kB/s
+	double pageOutRate;			// Data paged out to block devices in kB/s
+	double pageFaultRate;			// No page status
+	double pageFaultsMajorRate;		// Page missing (need to load from disk)
+	double pageFreeRate;			// Page release
+	double pageActivateRate;		// Page activation
+	double pageDeactivateRate;		// Page deactivation
+	double blockReadRate;			// pageInRate in MB/s, read from block devices
+	double blockWriteRate;			// pageOutRate in MB/s, written to block devices
+	double blockIoRate;			// blockReadRate + blockWriteRate
+	double thpFaultRate;			// Transparent huge pages allocated on a page fault
+	double thpFallbackRate;			// Faults that wanted a huge page and got small pages
+	double thpCollapseRate;			// Huge pages assembled from small pages by khugepaged
+	double thpSplitRate;			// Huge pages split into small pages
+	double compactionStallRate;		// Allocations that stalled for direct compaction
+	double compactionFailRate;		// Direct compactions that freed no block large enough
+	double compactionSuccessRate;		// Direct compactions that freed a block large enough
+	double numaPteUpdateRate;		// Pages marked for NUMA hinting faults
+	double numaHintFaultRate;		// NUMA hinting faults
+	double numaHintFaultLocalRatio;		// Hinting faults on memory of the local node in %
+	double numaMigrationRate;		// Pages moved to another node by NUMA balancing
 
 	MemoryMetrics();
     	void printMemoryMetrics();
 };
 
+struct NetworkInterfaceMetrics {
+	char name[NETWORK_NAME_LENGTH];		// Name of the interface, e.g. eth0, ib0
+	uint64_t receivedBytes;			// Bytes received since the interface came up
+	uint64_t receivedPackets;		// Packets received since the interface came up
+	uint64_t sentBytes;			// Bytes sent since the interface came up
+	uint64_t sentPackets;			// Packets sent since the interface came up
+	double receiveRate;			// Data received per second in KB/s
+	double sendRate;			// Data sent per second in KB/s
+	double receivePacketRate;		// Packets received per second
+	double sendPacketRate;			// Packets sent per second
+	double receiveDropRate;			// Received packets dropped per second
+	double sendDropRate;			// Packets to send dropped per second
+	double receiveErrorRate;		// Receive errors per second
+	double sendErrorRate;			// Send errors per second
+
+	NetworkInterfaceMetrics();
+};
+
+struct InfinibandPortMetrics {
+	char name[INFINIBAND_NAME_LENGTH];	// Device and port, e.g. mlx5_0/1
+	int state;				// Port state, 4 is ACTIVE
+	float linkRate;				// Signalling rate of the link in Gb/s
+	double transmitRate;			// Data sent per second in KB/s
+	double receiveRate;			// Data received per second in KB/s
+	double transmitPacketRate;		// Packets sent per second
+	double receivePacketRate;		// Packets received per second
+	double utilization;			// Busier direction against the link rate in %
+	double waitRate;			// port_xmit_wait ticks per second, data to send and no credits
+	double linkErrors;			// Symbol, integrity, overrun errors, recoveries and link downs in the interval
+	double receiveErrors;			// Packets received with errors or dropped in the interval
+	double transmitDiscards;		// Packets discarded or not sent in the interval
+	double transportErrors;			// Retransmits, timeouts and sequence errors of hw_counters in the interval
+	double outOfBuffer;			// Packets dropped for lack of receive WQEs in the interval
+	int saturatedCounters;			// Legacy counters stuck at their maximum, their deltas are missing
+
+	InfinibandPortMetrics();
+};
+
 struct NetworkMetrics {
-	int receivedData;			// All of the packets sent
-	float receivePacketRate;		// packets that are being received in KB/s
-	int sentData;				// All of the packets sent
-	float sendPacketsRate;			// packets that are being sent in KB/s
+	// Totals of the selected interfaces
+	uint64_t receivedData;			// All of the packets received
+	uint64_t receivedBytes;			// All of the bytes received
+	double receivePacketRate;		// Data received per second in KB/s
+	uint64_t sentData;			// All of the packets sent
+	uint64_t sentBytes;			// All of the bytes sent
+	double sendPacketsRate;			// Data sent per second in KB/s
+	double dropRate;			// Packets dropped per second in both directions
+	double errorRate;			// Receive and send errors per second
+	// Protocol counters of the whole node
+	uint64_t tcpRetransmits;		// TCP segments retransmitted since boot
+	double tcpRetransmitRate;		// TCP segments retransmitted per second
+	double tcpRetransmitRatio;		// Retransmitted TCP segments per segment sent in %
+	double tcpErrorRate;			// TCP segments received with errors per second
+	uint64_t udpErrors;			// UDP datagrams lost on receive errors or full buffers since boot
+	double udpErrorRate;			// UDP datagrams lost per second
+	int interfaces;				// Number of interfaces in interfaceMetrics
+	NetworkInterfaceMetrics interfaceMetrics[NETWORK_MAX_INTERFACES];	// Every selected interface of the node
+	// InfiniBand and RDMA ports, whose traffic does not go through the interfaces above
+	double infinibandTransmitRate;		// Data sent through every port per second in KB/s
+	double infinibandReceiveRate;		// Data received through every port per second in KB/s
+	int infinibandPorts;			// Number of ports in infinibandMetrics
+	InfinibandPortMetrics infinibandMetrics[INFINIBAND_MAX_PORTS];	// Every port of the node
 
 	NetworkMetrics();
     	void printNetworkMetrics();
 };
 
+struct GpuDeviceMetrics {
+	char name[GPU_NAME_LENGTH];		// Product name of the GPU
+	float power;				// Power consumed by the GPU in W
+	float temperature;			// Temperature of the GPU in C
+	float fanSpeed;				// Fan speed in %, -1 without a fan
+	float memoryTotal;			// Memory of the GPU in MB
+	float memoryUsed;			// Memory allocated on the GPU in MB
+	float memoryFree;			// Memory free to use in MB
+	float clocksSM;				// SM clock in MHz
+	float clocksMemory;			// Memory clock in MHz
+	float utilization;			// Time a kernel was running in %
+	float memoryUtilization;		// Time the memory was read or written in %
+
+	GpuDeviceMetrics();
+};
+
 struct PowerMetrics {
 	float processorPower;			// Power consumed by processor
 	float memoryPower;			// Power consumed by memory
-	float systemPower;			// Power consumed by system overall
-	float gpuPower;				// Power consumed by GPU
-	float gpuTemperature;			// Temperature of the GPU
-	float gpuFanSpeed;			// Fan speed of the GPU
-	float gpuMemoryTotal;			// Total memory available for GPU
-	float gpuMemoryUsed;			// Memory used by GPU
-	float gpuMemoryFree;			// Memory free to use by GPU
-	float gpuClocksCurrentSM;		// Current clocks
-	float gpuClocksCurrentMemory;		// Current clocks memory
+	float systemPower;			// Power consumed by system overall, from the power meter when there is one
+	int packages;				// Number of processor packages (sockets) with RAPL domains
+	float packagePower[RAPL_MAX_PACKAGES];	// Power consumed by each package
+	float corePower[RAPL_MAX_PACKAGES];	// Power consumed by the cores of each package
+	float dramPower[RAPL_MAX_PACKAGES];	// Power consumed by memory attached to each package
+	float platformPower;			// Power consumed by the whole platform (psys domain)
+	float meterPower;			// Average power measured by the power meter at the wall
+	float meterEnergy;			// Energy measured by the power meter during the interval in J
+	float meterPeakPower;			// Highest reading of the power meter during the interval
+	int meterSamples;			// Readings of the power meter during the interval
+	float gpuPower;				// Power consumed by all of the GPUs
+	float gpuTemperature;			// Temperature of the hottest GPU
+	float gpuFanSpeed;			// Fan speed of the fastest fan
+	float gpuMemoryTotal;			// Total memory of all of the GPUs
+	float gpuMemoryUsed;			// Memory used on all of the GPUs
+	float gpuMemoryFree;			// Memory free to use on all of the GPUs
+	float gpuClocksCurrentSM;		// Mean SM clock of the GPUs
+	float gpuClocksCurrentMemory;		// Mean memory clock of the GPUs
+	int gpus;				// Number of GPUs in gpuMetrics
+	GpuDeviceMetrics gpuMetrics[GPU_MAX_DEVICES];	// Every GPU of the node
 
 	PowerMetrics();
 	void printPowerMetrics();
 };
 
+struct PressureResourceMetrics {
+	double someAvg10;			// Share of the last 10 s with at least one task stalled in %
+	double fullAvg10;			// Share of the last 10 s with all non-idle tasks stalled at once in %
+	uint64_t someTotal;			// Time with at least one task stalled since boot in us
+	uint64_t fullTotal;			// Time with all non-idle tasks stalled since boot in us
+	double someStall;			// Time with at least one task stalled during the interval in us
+	double fullStall;			// Time with all non-idle tasks stalled during the interval in us
+	double someStallRatio;			// someStall divided by the interval in %
+	double fullStallRatio;			// fullStall divided by the interval in %
+
+	PressureResourceMetrics();
+};
+
+struct PressureMetrics {
+	PressureResourceMetrics system[PRESSURE_RESOURCES];	// cpu, memory and io of the whole node
+	PressureResourceMetrics cgroup[PRESSURE_RESOURCES];	// The same for the cgroup of the monitored process
+	int triggerEvents;			// PSI triggers fired during the interval
+	double firstTriggerDelay;		// Time from the start of the interval to the first trigger in ms
+
+	PressureMetrics();
+	void printPressureMetrics();
+};
+
+// Resources used by the cgroup of the job, so they can be told apart from the rest of a shared node
+struct JobMetrics {
+	char cgroup[CGROUP_PATH_LENGTH];	// Directory relative to the cgroup root, the end is kept when it is longer
+	double cpuUsage;			// CPU time of the cgroup per second in % of one CPU
+	double cpuUser;				// User time of the cgroup per second in % of one CPU
+	double cpuSystem;			// System time of the cgroup per second in % of one CPU
+	double cpuShare;			// Share of the busy CPU time of the whole node in %
+	double throttledPeriods;		// Periods of cpu.max in which the cgroup was throttled in %
+	double throttledTime;			// Time the cgroup was throttled by cpu.max in ms per second
+	double memoryCurrent;			// Memory charged to the cgroup in MB
+	double memoryAnon;			// Anonymous memory of the cgroup in MB
+	double memoryFile;			// Page cache charged to the cgroup in MB
+	double memoryKernel;			// Kernel memory charged to the cgroup in MB
+	double memoryShmem;			// Shared memory and tmpfs of the cgroup in MB
+	double pageFaultRate;			// Page faults of the cgroup per second
+	double majorFaultRate;			// Page faults of the cgroup that needed I/O per second
+	double dataReadRate;			// Data read by the cgroup from block devices in MB/s
+	double dataWrittenRate;			// Data written by the cgroup to block devices in MB/s
+	double readRate;			// Read operations of the cgroup per second
+	double writeRate;			// Write operations of the cgroup per second
+	double power;				// Package power of the node times cpuShare in W
+
+	JobMetrics();
+	void printJobMetrics();
+};
+
 struct AllMetrics {
-	//std::string nodeTimestamp;
+	uint32_t groups;			// Collectors sampled for this record, METRIC_BIT of every one
+	int64_t timestamps[METRIC_GROUPS];	// CLOCK_REALTIME of the sample of every section in ns, 0 if not in groups,
+						// on the clock of rank 0 once corrected by the root
+	int64_t deadline;			// CLOCK_REALTIME of the tick in ns, the same on every node
+	int64_t jitter;				// Time from the deadline to the wake-up of the node in ns
+	int64_t sampleRealTime;			// CLOCK_REALTIME of the wake-up on the clock of the node in ns
+	int64_t sampleMonotonicTime;		// CLOCK_MONOTONIC of the same instant in ns
+	int64_t clockOffset;			// Clock of the node minus the clock of rank 0 in ns, set by the root
+	double clockDrift;			// Drift of the clock of the node to the clock of rank 0 in ppm, set by the root
 	SystemMetrics systemMetrics;
 	ProcessorMetrics processorMetrics;
 	InputOutputMetrics inputOutputMetrics;
+	ProcessMetrics processMetrics;
 	MemoryMetrics memoryMetrics;
 	NetworkMetrics networkMetrics;
 	PowerMetrics powerMetrics;
+	PressureMetrics pressureMetrics;
+	JobMetrics jobMetrics;
 
 	AllMetrics();
 };
 
+// Reading the counter sources of the given collectors, the rates of every section are calculated
+// between the two last snapshots of its own collector
+void takeSnapshot(uint32_t = METRIC_ALL_GROUPS);
+// Sections of the given collectors, the other ones are left as they are
+void getAllMetrics(AllMetrics&, uint32_t = METRIC_ALL_GROUPS);
+// Copies the sections of the collectors sampled for a record over the last values of every section
+void mergeMetrics(AllMetrics&, const AllMetrics&);
+// Sets the clock offset and drift of a record that arrived on the root and moves its timestamps to the clock of rank 0
+void correctTimestamps(AllMetrics&, int64_t, double);
+// MetricGroup of a collector name, e.g. "power" or "io", -1 if there is no such collector
+int findMetricGroup(const std::string&);
+// Logical CPUs of the node, the entries of cpuMetrics that can be valid
+int countCpus();
+
+// Process tree followed by the I/O and process metrics, GPROCESSID until it is changed
+bool setTargetProcess(int);
+// cgroup v2 directory of the job, relative to CGROUP_ROOT or the full path, instead of the one of the process
+bool setJobCgroup(const std::string&);
+// Power meter at host[:port] or a serial device[@baud], read every given period in ms
+bool setPowerMeter(const std::string&, int);
+// File name or path of libnvidia-ml, e.g. the stub built from nvml-stub.cpp, instead of NVML_LIBRARY
+bool setGpuLibrary(const std::string&);
+// Comma separated include and exclude lists of interface names, globs allowed
+bool setNetworkInterfaces(const std::string&, const std::string&);
+// PSI triggers on cpu, memory and io that fire after the given stall time in us within PRESSURE_TRIGGER_WINDOW
+bool setPressureTriggers(uint64_t);
+// Sleeps for up to the given time in ms, or until the given descriptor becomes readable, and returns
+// true if a PSI trigger fired meanwhile. Without triggers and without a descriptor it returns false right away.
+bool waitForPressure(int, int = -1);
+
 // Fetching the metrics into structures
 void getSystemMetrics(SystemMetrics&);
 void getProcessorMetrics(ProcessorMetrics&);
 void getInputOutputMetrics(InputOutputMetrics&);
+void getProcessMetrics(ProcessMetrics&);
 void getMemoryMetrics(MemoryMetrics&);
 void getNetworkMetrics(NetworkMetrics&);
 void getPowerMetrics(PowerMetrics&);
+void getPressureMetrics(PressureMetrics&);
+void getJobMetrics(JobMetrics&);
+
+struct SamplingCost {
+	double cpuTime;				// CPU time of the sampling thread in ms
+};
 
-// Getting the output from system to string
-std::string exec(const char*);
+SamplingCost getSamplingCost();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+//
+//	network-interfaces.cpp - file with definitions of the network collector reading /proc/net/dev and /proc/net/snmp
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// sort
+#include <cstring>	// strncpy
+#include <fnmatch.h>	// fnmatch
+// Internal headers
+#include "network-interfaces.h"
+
+bool parseNetDevLine(std::string_view line, std::string_view &name, NetworkInterfaceCounters &counters){
+
+	size_t colon = line.find(':');
+	if(colon == std::string_view::npos) return false;
+	name = line.substr(0, colon);
+	while(!name.empty() && name.front() == ' ') name.remove_prefix(1);
+	line.remove_prefix(colon + 1);
+
+	// bytes packets errs drop fifo frame compressed multicast, the same for transmit with colls and carrier
+	uint64_t fields[16];
+	if(parseUnsignedList(line, fields, 16) < 16) return false;
+
+	counters.receivedBytes = fields[0];
+	counters.receivedPackets = fields[1];
+	counters.receiveErrors = fields[2];
+	counters.receiveDrops = fields[3];
+	counters.sentBytes = fields[8];
+	counters.sentPackets = fields[9];
+	counters.sendErrors = fields[10];
+	counters.sendDrops = fields[11];
+	return !name.empty();
+};
+
+bool findSnmpValue(std::string_view text, std::string_view protocol, std::string_view key, uint64_t &value){
+
+	std::string_view names, values;
+	if(!findLine(text, protocol, names)) return false;
+
+	// The values follow right after the line of names
+	size_t namesEnd = text.find('\n', names.data() - text.data());
+	if(namesEnd == std::string_view::npos || !findLine(text.substr(namesEnd + 1), protocol, values)) return false;
+
+	while(!names.empty()){
+		std::string_view name = nextToken(names);
+		skipWhitespace(values);
+		if(name == key) return parseUnsigned(values, value);
+
+		// Some values are signed, e.g. MaxConn is -1 when there is no limit
+		nextToken(values);
+	}
+	return false;
+};
+
+bool matchesInterfaceList(const char* name, const std::string &patterns){
+
+	size_t start = 0;
+	while(start <= patterns.size()){
+		size_t end = patterns.find(',', start);
+		if(end == std::string::npos) end = patterns.size();
+		std::string pattern = patterns.substr(start, end - start);
+		if(!pattern.empty() && !fnmatch(pattern.c_str(), name, 0)) return true;
+		start = end + 1;
+	}
+	return false;
+};
+
+NetworkInterfaces::NetworkInterfaces(){
+	this->interfaces = 0;
+};
+
+bool NetworkInterfaces::open(const std::string &include, const std::string &exclude){
+
+	this->interfaces = 0;
+	if(!this->netDevFile.open("/proc/net/dev")) return false;
+	this->snmpFile.open("/proc/net/snmp");
+
+	// The first two lines of /proc/net/dev are the header
+	std::vector<std::string> found;
+	std::string_view text = this->netDevFile.read(), name;
+	NetworkInterfaceCounters counters;
+	while(!text.empty()){
+		if(!parseNetDevLine(nextLine(text), name, counters) || name.size() >= NETWORK_NAME_LENGTH) continue;
+
+		std::string interface(name);
+		if(!include.empty() && !matchesInterfaceList(interface.c_str(), include)) continue;
+		if(matchesInterfaceList(interface.c_str(), exclude)) continue;
+		found.push_back(interface);
+	}
+
+	// Sorted, so the same machine always puts the same interface in the same slot
+	std::sort(found.begin(), found.end());
+	for(const std::string &interface : found){
+		if(this->interfaces == NETWORK_MAX_INTERFACES) break;
+		strncpy(this->names[this->interfaces], interface.c_str(), NETWORK_NAME_LENGTH);
+		this->interfaces++;
+	}
+	return true;
+};
+
+bool NetworkInterfaces::isOpen() const {
+	return this->netDevFile.isOpen();
+};
+
+bool NetworkInterfaces::read(NetworkReading &reading){
+
+	reading.interfaces = this->interfaces;
+	for(int i = 0; i < this->interfaces; i++){
+		strncpy(reading.names[i], this->names[i], NETWORK_NAME_LENGTH);
+		reading.found[i] = false;
+	}
+	reading.tcpSegmentsSent = reading.tcpRetransmits = reading.tcpErrors = reading.udpErrors = UINT64_MAX;
+	if(!this->netDevFile.isOpen()) return false;
+
+	std::string_view text = this->netDevFile.read(), name;
+	NetworkInterfaceCounters counters;
+	while(!text.empty()){
+		if(!parseNetDevLine(nextLine(text), name, counters)) continue;
+		for(int i = 0; i < this->interfaces; i++)
+			if(name == this->names[i]){
+				reading.counters[i] = counters;
+				reading.found[i] = true;
+				break;
+			}
+	}
+
+	// Protocol counters are kept for the whole network namespace, not per interface
+	text = this->snmpFile.read();
+	uint64_t inErrors, receiveBufferErrors, sendBufferErrors;
+	findSnmpValue(text, "Tcp: ", "OutSegs", reading.tcpSegmentsSent);
+	findSnmpValue(text, "Tcp: ", "RetransSegs", reading.tcpRetransmits);
+	findSnmpValue(text, "Tcp: ", "InErrs", reading.tcpErrors);
+	if(findSnmpValue(text, "Udp: ", "InErrors", inErrors) && findSnmpValue(text, "Udp: ", "RcvbufErrors", receiveBufferErrors)
+		&& findSnmpValue(text, "Udp: ", "SndbufErrors", sendBufferErrors))
+		reading.udpErrors = inErrors + receiveBufferErrors + sendBufferErrors;
+	return true;
+};
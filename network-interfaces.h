@@ -0,0 +1,76 @@
+//
+//	network-interfaces.h - header file with the network collector reading /proc/net/dev and /proc/net/snmp
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef NETWORK_INTERFACES_H
+#define NETWORK_INTERFACES_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define NETWORK_MAX_INTERFACES 16		// Interfaces reported separately, the rest is left out
+#define NETWORK_NAME_LENGTH 16			// IFNAMSIZ, room for the interface name with the terminating zero
+#define NETWORK_EXCLUDE "lo"			// Default exclude list, loopback traffic never leaves the node
+
+// Receive and transmit counters of one line of /proc/net/dev, cumulative since the interface came up
+struct NetworkInterfaceCounters {
+	uint64_t receivedBytes;
+	uint64_t receivedPackets;
+	uint64_t receiveErrors;
+	uint64_t receiveDrops;
+	uint64_t sentBytes;
+	uint64_t sentPackets;
+	uint64_t sendErrors;
+	uint64_t sendDrops;
+};
+
+struct NetworkReading {
+	int interfaces;						// Number of interfaces selected
+	char names[NETWORK_MAX_INTERFACES][NETWORK_NAME_LENGTH];	// e.g. eth0, ib0, enp0s31f6
+	bool found[NETWORK_MAX_INTERFACES];			// Interface was listed in /proc/net/dev at the read
+	NetworkInterfaceCounters counters[NETWORK_MAX_INTERFACES];
+	uint64_t tcpSegmentsSent;				// Tcp OutSegs from /proc/net/snmp
+	uint64_t tcpRetransmits;				// Tcp RetransSegs
+	uint64_t tcpErrors;					// Tcp InErrs, segments received with errors
+	uint64_t udpErrors;					// Udp InErrors, RcvbufErrors and SndbufErrors
+};
+
+// Interfaces are listed once from /proc/net/dev and filtered with comma separated glob lists, the same
+// form as btl_tcp_if_include / btl_tcp_if_exclude of mpirun (e.g. "docker*,lo"). Every interface keeps
+// its slot for the whole run, /proc/net/dev and /proc/net/snmp stay open and are read once per sample.
+class NetworkInterfaces {
+public:
+	NetworkInterfaces();
+
+	// Include list (empty takes every interface) and exclude list
+	bool open(const std::string& = "", const std::string& = NETWORK_EXCLUDE);
+	bool isOpen() const;
+
+	bool read(NetworkReading&);
+
+private:
+	int interfaces;
+	char names[NETWORK_MAX_INTERFACES][NETWORK_NAME_LENGTH];
+	ProcfsFile netDevFile;
+	ProcfsFile snmpFile;
+};
+
+// "name: 8 receive counters 8 transmit counters", the name can be padded with spaces
+bool parseNetDevLine(std::string_view, std::string_view&, NetworkInterfaceCounters&);
+
+// /proc/net/snmp has a line of names and a line of values for every protocol (e.g. "Tcp:")
+bool findSnmpValue(std::string_view, std::string_view, std::string_view, uint64_t&);
+
+// Name matches one of the comma separated glob patterns
+bool matchesInterfaceList(const char*, const std::string&);
+
+#endif
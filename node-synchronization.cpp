@@ -6,44 +6,151 @@
 // 				    Jakub Wasniewski @wisnia01
 //
 
+// External libraries
+#include <ctime>        // clock_nanosleep, TIMER_ABSTIME
+#include <cerrno>       // EINTR
+#include <algorithm>    // clamp
+#include <vector>       // vector
 // Internal headers
 #include "node-synchronization.h"
 #include "metrics.h"
+#include "target-launcher.h"
+#include "procfs-reader.h"
+
+// Create MPI data type for InterruptMetricsType
+MPI_Datatype createMpiInterruptMetricsType(){
+
+    int blockLengths[] = {INTERRUPT_NAME_LENGTH, INTERRUPT_DEVICE_LENGTH, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_CHAR, MPI_INT, MPI_UINT64_T,
+        MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct InterruptMetrics, name),
+        offsetof(struct InterruptMetrics, device),
+        offsetof(struct InterruptMetrics, cpu),
+        offsetof(struct InterruptMetrics, count),
+        offsetof(struct InterruptMetrics, rate)};
+
+    MPI_Datatype structType, interruptMetricsType;
+    MPI_Type_create_struct(5, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside SystemMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(InterruptMetrics), &interruptMetricsType);
+    MPI_Type_commit(&interruptMetricsType);
+    MPI_Type_free(&structType);
+
+    return interruptMetricsType;
+};
 
 // Create MPI data type for SystemMetricsType
 MPI_Datatype createMpiSystemMetricsType(){
 
-    int blockLengths[] = {1, 1, 1, 1, 1};
+    MPI_Datatype interruptMetricsType = createMpiInterruptMetricsType();
+
+    int blockLengths[] = {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1};
+    blockLengths[16] = INTERRUPT_TOP;
+    blockLengths[18] = INTERRUPT_TOP;
     MPI_Datatype metricTypes[] = {
-        MPI_INT, MPI_INT, MPI_INT, MPI_INT, MPI_INT};
+        MPI_INT, MPI_INT, MPI_INT, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_UINT64_T, MPI_DOUBLE, MPI_INT,
+        MPI_DOUBLE, MPI_INT, MPI_DOUBLE, MPI_INT,
+        interruptMetricsType, MPI_INT, interruptMetricsType};
     MPI_Aint metricOffsets[] = {
         offsetof(struct SystemMetrics, processesRunning),
         offsetof(struct SystemMetrics, processesAll),
         offsetof(struct SystemMetrics, processesBlocked),
+        offsetof(struct SystemMetrics, contextSwitches),
+        offsetof(struct SystemMetrics, interrupts),
+        offsetof(struct SystemMetrics, processesCreated),
         offsetof(struct SystemMetrics, contextSwitchRate),
-        offsetof(struct SystemMetrics, interruptRate)};
+        offsetof(struct SystemMetrics, interruptRate),
+        offsetof(struct SystemMetrics, processCreationRate),
+        offsetof(struct SystemMetrics, softInterrupts),
+        offsetof(struct SystemMetrics, softInterruptRate),
+        offsetof(struct SystemMetrics, interruptCpu),
+        offsetof(struct SystemMetrics, interruptCpuRate),
+        offsetof(struct SystemMetrics, softInterruptCpu),
+        offsetof(struct SystemMetrics, softInterruptCpuRate),
+        offsetof(struct SystemMetrics, topInterrupts),
+        offsetof(struct SystemMetrics, interruptMetrics),
+        offsetof(struct SystemMetrics, topSoftInterrupts),
+        offsetof(struct SystemMetrics, softInterruptMetrics)};
 
     MPI_Datatype systemMetricsType;
-    MPI_Type_create_struct(5, blockLengths, metricOffsets, metricTypes, &systemMetricsType);
+    MPI_Type_create_struct(19, blockLengths, metricOffsets, metricTypes, &systemMetricsType);
     MPI_Type_commit(&systemMetricsType);
+    MPI_Type_free(&interruptMetricsType);
 
     return systemMetricsType;
 };
 
-// Create MPI data type for ProcessorMetricsType
-MPI_Datatype createMpiProcessorMetricsType(){
+// Create MPI data type for CpuMetricsType
+MPI_Datatype createMpiCpuMetricsType(){
+
+    int blockLengths[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_INT, MPI_INT, MPI_INT, MPI_INT,
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct CpuMetrics, cpu),
+        offsetof(struct CpuMetrics, core),
+        offsetof(struct CpuMetrics, socket),
+        offsetof(struct CpuMetrics, node),
+        offsetof(struct CpuMetrics, busy),
+        offsetof(struct CpuMetrics, user),
+        offsetof(struct CpuMetrics, system),
+        offsetof(struct CpuMetrics, ioWait),
+        offsetof(struct CpuMetrics, frequency),
+        offsetof(struct CpuMetrics, effectiveFrequency),
+        offsetof(struct CpuMetrics, idleResidency),
+        offsetof(struct CpuMetrics, throttleTime)};
+
+    MPI_Datatype structType, cpuMetricsType;
+    MPI_Type_create_struct(12, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside ProcessorMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(CpuMetrics), &cpuMetricsType);
+    MPI_Type_commit(&cpuMetricsType);
+    MPI_Type_free(&structType);
+
+    return cpuMetricsType;
+};
+
+// Create MPI data type for ProcessorMetricsType, with the first given entries of cpuMetrics only
+MPI_Datatype createMpiProcessorMetricsType(int cpus){
+
+    MPI_Datatype cpuMetricsType = createMpiCpuMetricsType();
 
     int blockLengths[] = {
-        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
         1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-        1};
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1};
+    blockLengths[38] = TOPOLOGY_MAX_SOCKETS;
+    blockLengths[39] = TOPOLOGY_MAX_NODES;
+    blockLengths[49] = IDLE_MAX_STATES * IDLE_NAME_LENGTH;
+    blockLengths[50] = IDLE_MAX_STATES;
+    blockLengths[51] = IDLE_MAX_STATES;
+    blockLengths[52] = std::clamp(cpus, 1, TOPOLOGY_MAX_CPUS);
     MPI_Datatype metricTypes[] = {
-        MPI_INT, MPI_INT, MPI_INT, MPI_INT, 
-        MPI_INT, MPI_INT, MPI_INT, MPI_INT, 
-        MPI_INT, MPI_INT, MPI_INT, MPI_FLOAT, 
-        MPI_FLOAT, MPI_INT, MPI_INT, MPI_INT, 
-        MPI_INT, MPI_INT, MPI_FLOAT, MPI_INT,
-        MPI_FLOAT};
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_UINT64_T, MPI_UINT64_T, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_UINT64_T, MPI_UINT64_T, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_INT, MPI_INT, MPI_INT,
+        MPI_INT, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_FLOAT, MPI_FLOAT,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_INT, MPI_CHAR, MPI_FLOAT, MPI_FLOAT,
+        cpuMetricsType};
     MPI_Aint metricOffsets[] = {
         offsetof(struct ProcessorMetrics, timeUser),
         offsetof(struct ProcessorMetrics, timeNice),
@@ -56,6 +163,8 @@ MPI_Datatype createMpiProcessorMetricsType(){
         offsetof(struct ProcessorMetrics, timeGuest),
         offsetof(struct ProcessorMetrics, instructionsRetired),
         offsetof(struct ProcessorMetrics, cycles),
+        offsetof(struct ProcessorMetrics, instructionsPerSecond),
+        offsetof(struct ProcessorMetrics, cyclesPerSecond),
         offsetof(struct ProcessorMetrics, frequencyRelative),
         offsetof(struct ProcessorMetrics, unhaltedFrequency),
         offsetof(struct ProcessorMetrics, cacheL2Requests),
@@ -63,61 +172,182 @@ MPI_Datatype createMpiProcessorMetricsType(){
         offsetof(struct ProcessorMetrics, cacheLLCLoads),
         offsetof(struct ProcessorMetrics, cacheLLCStores),
         offsetof(struct ProcessorMetrics, cacheLLCLoadMisses),
-        offsetof(struct ProcessorMetrics, cacheLLCLoadMissRate),
         offsetof(struct ProcessorMetrics, cacheLLCStoreMisses),
-        offsetof(struct ProcessorMetrics, cacheLLCStoreMissRate)};
+        offsetof(struct ProcessorMetrics, cacheL2RequestsPerSecond),
+        offsetof(struct ProcessorMetrics, cacheL2MissesPerSecond),
+        offsetof(struct ProcessorMetrics, cacheLLCLoadsPerSecond),
+        offsetof(struct ProcessorMetrics, cacheLLCStoresPerSecond),
+        offsetof(struct ProcessorMetrics, cacheLLCLoadMissesPerSecond),
+        offsetof(struct ProcessorMetrics, cacheLLCStoreMissesPerSecond),
+        offsetof(struct ProcessorMetrics, cacheLLCLoadMissRate),
+        offsetof(struct ProcessorMetrics, cacheLLCStoreMissRate),
+        offsetof(struct ProcessorMetrics, cpus),
+        offsetof(struct ProcessorMetrics, cores),
+        offsetof(struct ProcessorMetrics, sockets),
+        offsetof(struct ProcessorMetrics, numaNodes),
+        offsetof(struct ProcessorMetrics, cpuBusyMax),
+        offsetof(struct ProcessorMetrics, cpuBusyMin),
+        offsetof(struct ProcessorMetrics, cpuBusyDeviation),
+        offsetof(struct ProcessorMetrics, coreBusyMax),
+        offsetof(struct ProcessorMetrics, coreBusyMin),
+        offsetof(struct ProcessorMetrics, socketBusy),
+        offsetof(struct ProcessorMetrics, nodeBusy),
+        offsetof(struct ProcessorMetrics, frequencyMean),
+        offsetof(struct ProcessorMetrics, frequencyMin),
+        offsetof(struct ProcessorMetrics, frequencyMax),
+        offsetof(struct ProcessorMetrics, effectiveFrequency),
+        offsetof(struct ProcessorMetrics, coreThrottleRate),
+        offsetof(struct ProcessorMetrics, packageThrottleRate),
+        offsetof(struct ProcessorMetrics, coreThrottleTime),
+        offsetof(struct ProcessorMetrics, packageThrottleTime),
+        offsetof(struct ProcessorMetrics, idleStates),
+        offsetof(struct ProcessorMetrics, idleStateNames),
+        offsetof(struct ProcessorMetrics, idleStateResidency),
+        offsetof(struct ProcessorMetrics, idleStateRate),
+        offsetof(struct ProcessorMetrics, cpuMetrics)};
 
     MPI_Datatype processorMetricsType;
-    MPI_Type_create_struct(21, blockLengths, metricOffsets, metricTypes, &processorMetricsType);
+    MPI_Type_create_struct(53, blockLengths, metricOffsets, metricTypes, &processorMetricsType);
     MPI_Type_commit(&processorMetricsType);
+    MPI_Type_free(&cpuMetricsType);
 
     return processorMetricsType;
 };
 
+// Create MPI data type for BlockDeviceMetricsType
+MPI_Datatype createMpiBlockDeviceMetricsType(){
+
+    int blockLengths[] = {
+        BLOCK_NAME_LENGTH, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_INT, MPI_UINT64_T, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct BlockDeviceMetrics, name),
+        offsetof(struct BlockDeviceMetrics, stacked),
+        offsetof(struct BlockDeviceMetrics, reads),
+        offsetof(struct BlockDeviceMetrics, writes),
+        offsetof(struct BlockDeviceMetrics, dataRead),
+        offsetof(struct BlockDeviceMetrics, dataWritten),
+        offsetof(struct BlockDeviceMetrics, readRate),
+        offsetof(struct BlockDeviceMetrics, writeRate),
+        offsetof(struct BlockDeviceMetrics, dataReadRate),
+        offsetof(struct BlockDeviceMetrics, dataWrittenRate),
+        offsetof(struct BlockDeviceMetrics, readTime),
+        offsetof(struct BlockDeviceMetrics, writeTime),
+        offsetof(struct BlockDeviceMetrics, flushRate),
+        offsetof(struct BlockDeviceMetrics, flushTime),
+        offsetof(struct BlockDeviceMetrics, queueDepth),
+        offsetof(struct BlockDeviceMetrics, utilization)};
+
+    MPI_Datatype structType, blockDeviceMetricsType;
+    MPI_Type_create_struct(16, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside InputOutputMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(BlockDeviceMetrics), &blockDeviceMetricsType);
+    MPI_Type_commit(&blockDeviceMetricsType);
+    MPI_Type_free(&structType);
+
+    return blockDeviceMetricsType;
+};
+
 // Create MPI data type for InputOutputMetricsType
 MPI_Datatype createMpiInputOutputMetricsType(){
-    
-    int blockLengths[] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+    MPI_Datatype blockDeviceMetricsType = createMpiBlockDeviceMetricsType();
+
+    int blockLengths[] = {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1};
+    blockLengths[17] = BLOCK_MAX_DEVICES;
     MPI_Datatype metricTypes[] = {
-        MPI_INT, MPI_FLOAT, MPI_FLOAT, 
-        MPI_INT, MPI_FLOAT, MPI_FLOAT, 
-        MPI_INT, MPI_FLOAT, MPI_FLOAT};
+        MPI_INT, MPI_UINT64_T, MPI_UINT64_T, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_INT, blockDeviceMetricsType};
     MPI_Aint metricOffsets[] = {
         offsetof(struct InputOutputMetrics, processID),
         offsetof(struct InputOutputMetrics, dataRead),
-        offsetof(struct InputOutputMetrics, readTime),
-        offsetof(struct InputOutputMetrics, readOperationsRate),
         offsetof(struct InputOutputMetrics, dataWritten),
-        offsetof(struct InputOutputMetrics, writeTime),
+        offsetof(struct InputOutputMetrics, readOperations),
+        offsetof(struct InputOutputMetrics, writeOperations),
+        offsetof(struct InputOutputMetrics, dataReadRate),
+        offsetof(struct InputOutputMetrics, dataWrittenRate),
+        offsetof(struct InputOutputMetrics, readOperationsRate),
         offsetof(struct InputOutputMetrics, writeOperationsRate),
-        offsetof(struct InputOutputMetrics, flushTime),
-        offsetof(struct InputOutputMetrics, flushOperationsRate)};
+        offsetof(struct InputOutputMetrics, diskReadRate),
+        offsetof(struct InputOutputMetrics, diskWriteRate),
+        offsetof(struct InputOutputMetrics, diskDataReadRate),
+        offsetof(struct InputOutputMetrics, diskDataWrittenRate),
+        offsetof(struct InputOutputMetrics, diskReadTime),
+        offsetof(struct InputOutputMetrics, diskWriteTime),
+        offsetof(struct InputOutputMetrics, diskUtilization),
+        offsetof(struct InputOutputMetrics, devices),
+        offsetof(struct InputOutputMetrics, deviceMetrics)};
 
     MPI_Datatype inputOutputMetricsType;
-    MPI_Type_create_struct(9, blockLengths, metricOffsets, metricTypes, &inputOutputMetricsType);
+    MPI_Type_create_struct(18, blockLengths, metricOffsets, metricTypes, &inputOutputMetricsType);
     MPI_Type_commit(&inputOutputMetricsType);
+    MPI_Type_free(&blockDeviceMetricsType);
 
-	return inputOutputMetricsType;
+    return inputOutputMetricsType;
 };
 
 
+// Create MPI data type for ProcessMetricsType
+MPI_Datatype createMpiProcessMetricsType(){
+
+    int blockLengths[] = {
+        1, 1, 1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_INT, MPI_INT, MPI_INT, MPI_UINT64_T,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_UINT64_T, MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct ProcessMetrics, processID),
+        offsetof(struct ProcessMetrics, processes),
+        offsetof(struct ProcessMetrics, threads),
+        offsetof(struct ProcessMetrics, cpuTime),
+        offsetof(struct ProcessMetrics, cpuUsage),
+        offsetof(struct ProcessMetrics, memoryResident),
+        offsetof(struct ProcessMetrics, contextSwitches),
+        offsetof(struct ProcessMetrics, contextSwitchRate)};
+
+    MPI_Datatype processMetricsType;
+    MPI_Type_create_struct(8, blockLengths, metricOffsets, metricTypes, &processMetricsType);
+    MPI_Type_commit(&processMetricsType);
+
+    return processMetricsType;
+};
+
 // Create MPI data type for MemoryMetricsType
 MPI_Datatype createMpiMemoryMetricsType(){
 
     int blockLengths[] = {
-        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
     MPI_Datatype metricTypes[] = {
-        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, 
-        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, 
-        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
-        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT};
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE};
     MPI_Aint metricOffsets[] = {
+        offsetof(struct MemoryMetrics, memoryTotal),
         offsetof(struct MemoryMetrics, memoryUsed),
+        offsetof(struct MemoryMetrics, memoryAvailable),
         offsetof(struct MemoryMetrics, memoryCached),
         offsetof(struct MemoryMetrics, swapUsed),
         offsetof(struct MemoryMetrics, swapCached),
         offsetof(struct MemoryMetrics, memoryActive),
         offsetof(struct MemoryMetrics, memoryInactive),
+        offsetof(struct MemoryMetrics, memoryHugePages),
         offsetof(struct MemoryMetrics, pageInRate),
         offsetof(struct MemoryMetrics, pageOutRate),
         offsetof(struct MemoryMetrics, pageFaultRate),
@@ -125,49 +355,211 @@ MPI_Datatype createMpiMemoryMetricsType(){
         offsetof(struct MemoryMetrics, pageFreeRate),
         offsetof(struct MemoryMetrics, pageActivateRate),
         offsetof(struct MemoryMetrics, pageDeactivateRate),
-        offsetof(struct MemoryMetrics, memoryReadRate),
-        offsetof(struct MemoryMetrics, memoryWriteRate),
-        offsetof(struct MemoryMetrics, memoryIoRate)};
+        offsetof(struct MemoryMetrics, blockReadRate),
+        offsetof(struct MemoryMetrics, blockWriteRate),
+        offsetof(struct MemoryMetrics, blockIoRate),
+        offsetof(struct MemoryMetrics, thpFaultRate),
+        offsetof(struct MemoryMetrics, thpFallbackRate),
+        offsetof(struct MemoryMetrics, thpCollapseRate),
+        offsetof(struct MemoryMetrics, thpSplitRate),
+        offsetof(struct MemoryMetrics, compactionStallRate),
+        offsetof(struct MemoryMetrics, compactionFailRate),
+        offsetof(struct MemoryMetrics, compactionSuccessRate),
+        offsetof(struct MemoryMetrics, numaPteUpdateRate),
+        offsetof(struct MemoryMetrics, numaHintFaultRate),
+        offsetof(struct MemoryMetrics, numaHintFaultLocalRatio),
+        offsetof(struct MemoryMetrics, numaMigrationRate)};
 
     MPI_Datatype memoryMetricsType;
-    MPI_Type_create_struct(16, blockLengths, metricOffsets, metricTypes, &memoryMetricsType);
+    MPI_Type_create_struct(30, blockLengths, metricOffsets, metricTypes, &memoryMetricsType);
     MPI_Type_commit(&memoryMetricsType);
 
     return memoryMetricsType;
 };
 
+// Create MPI data type for NetworkInterfaceMetricsType
+MPI_Datatype createMpiNetworkInterfaceMetricsType(){
+
+    int blockLengths[] = {
+        NETWORK_NAME_LENGTH, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_UINT64_T, MPI_UINT64_T, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(NetworkInterfaceMetrics, name),
+        offsetof(NetworkInterfaceMetrics, receivedBytes),
+        offsetof(NetworkInterfaceMetrics, receivedPackets),
+        offsetof(NetworkInterfaceMetrics, sentBytes),
+        offsetof(NetworkInterfaceMetrics, sentPackets),
+        offsetof(NetworkInterfaceMetrics, receiveRate),
+        offsetof(NetworkInterfaceMetrics, sendRate),
+        offsetof(NetworkInterfaceMetrics, receivePacketRate),
+        offsetof(NetworkInterfaceMetrics, sendPacketRate),
+        offsetof(NetworkInterfaceMetrics, receiveDropRate),
+        offsetof(NetworkInterfaceMetrics, sendDropRate),
+        offsetof(NetworkInterfaceMetrics, receiveErrorRate),
+        offsetof(NetworkInterfaceMetrics, sendErrorRate)};
+
+    MPI_Datatype structType, networkInterfaceMetricsType;
+    MPI_Type_create_struct(13, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside NetworkMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(NetworkInterfaceMetrics), &networkInterfaceMetricsType);
+    MPI_Type_commit(&networkInterfaceMetricsType);
+    MPI_Type_free(&structType);
+
+    return networkInterfaceMetricsType;
+};
+
+// Create MPI data type for InfinibandPortMetrics
+MPI_Datatype createMpiInfinibandPortMetricsType(){
+
+    int blockLengths[] = {
+        INFINIBAND_NAME_LENGTH, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_INT, MPI_FLOAT, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_INT};
+    MPI_Aint metricOffsets[] = {
+        offsetof(InfinibandPortMetrics, name),
+        offsetof(InfinibandPortMetrics, state),
+        offsetof(InfinibandPortMetrics, linkRate),
+        offsetof(InfinibandPortMetrics, transmitRate),
+        offsetof(InfinibandPortMetrics, receiveRate),
+        offsetof(InfinibandPortMetrics, transmitPacketRate),
+        offsetof(InfinibandPortMetrics, receivePacketRate),
+        offsetof(InfinibandPortMetrics, utilization),
+        offsetof(InfinibandPortMetrics, waitRate),
+        offsetof(InfinibandPortMetrics, linkErrors),
+        offsetof(InfinibandPortMetrics, receiveErrors),
+        offsetof(InfinibandPortMetrics, transmitDiscards),
+        offsetof(InfinibandPortMetrics, transportErrors),
+        offsetof(InfinibandPortMetrics, outOfBuffer),
+        offsetof(InfinibandPortMetrics, saturatedCounters)};
+
+    MPI_Datatype structType, infinibandPortMetricsType;
+    MPI_Type_create_struct(15, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside NetworkMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(InfinibandPortMetrics), &infinibandPortMetricsType);
+    MPI_Type_commit(&infinibandPortMetricsType);
+    MPI_Type_free(&structType);
+
+    return infinibandPortMetricsType;
+};
+
 // Create MPI data type for NetworkMetricsType
 MPI_Datatype createMpiNetworkMetricsType(){
 
-    int blockLengths[] = {1, 1, 1, 1};
+    MPI_Datatype networkInterfaceMetricsType = createMpiNetworkInterfaceMetricsType();
+    MPI_Datatype infinibandPortMetricsType = createMpiInfinibandPortMetricsType();
+
+    int blockLengths[] = {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    blockLengths[15] = NETWORK_MAX_INTERFACES;
+    blockLengths[19] = INFINIBAND_MAX_PORTS;
     MPI_Datatype metricTypes[] = {
-        MPI_INT, MPI_FLOAT, MPI_INT, MPI_FLOAT};
+        MPI_UINT64_T, MPI_UINT64_T, MPI_DOUBLE, MPI_UINT64_T,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_UINT64_T, MPI_DOUBLE, MPI_INT, networkInterfaceMetricsType,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_INT, infinibandPortMetricsType};
     MPI_Aint metricOffsets[] = {
         offsetof(NetworkMetrics, receivedData),
+        offsetof(NetworkMetrics, receivedBytes),
         offsetof(NetworkMetrics, receivePacketRate),
         offsetof(NetworkMetrics, sentData),
-        offsetof(NetworkMetrics, sendPacketsRate)};
+        offsetof(NetworkMetrics, sentBytes),
+        offsetof(NetworkMetrics, sendPacketsRate),
+        offsetof(NetworkMetrics, dropRate),
+        offsetof(NetworkMetrics, errorRate),
+        offsetof(NetworkMetrics, tcpRetransmits),
+        offsetof(NetworkMetrics, tcpRetransmitRate),
+        offsetof(NetworkMetrics, tcpRetransmitRatio),
+        offsetof(NetworkMetrics, tcpErrorRate),
+        offsetof(NetworkMetrics, udpErrors),
+        offsetof(NetworkMetrics, udpErrorRate),
+        offsetof(NetworkMetrics, interfaces),
+        offsetof(NetworkMetrics, interfaceMetrics),
+        offsetof(NetworkMetrics, infinibandTransmitRate),
+        offsetof(NetworkMetrics, infinibandReceiveRate),
+        offsetof(NetworkMetrics, infinibandPorts),
+        offsetof(NetworkMetrics, infinibandMetrics)};
 
     MPI_Datatype networkMetricsType;
-    MPI_Type_create_struct(4, blockLengths, metricOffsets, metricTypes, &networkMetricsType);
+    MPI_Type_create_struct(20, blockLengths, metricOffsets, metricTypes, &networkMetricsType);
     MPI_Type_commit(&networkMetricsType);
+    MPI_Type_free(&networkInterfaceMetricsType);
+    MPI_Type_free(&infinibandPortMetricsType);
 
     return networkMetricsType;
 };
 
+// Create MPI data type for GpuDeviceMetrics
+MPI_Datatype createMpiGpuDeviceMetricsType(){
+
+    int blockLengths[] = {
+        GPU_NAME_LENGTH, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT};
+    MPI_Aint metricOffsets[] = {
+        offsetof(GpuDeviceMetrics, name),
+        offsetof(GpuDeviceMetrics, power),
+        offsetof(GpuDeviceMetrics, temperature),
+        offsetof(GpuDeviceMetrics, fanSpeed),
+        offsetof(GpuDeviceMetrics, memoryTotal),
+        offsetof(GpuDeviceMetrics, memoryUsed),
+        offsetof(GpuDeviceMetrics, memoryFree),
+        offsetof(GpuDeviceMetrics, clocksSM),
+        offsetof(GpuDeviceMetrics, clocksMemory),
+        offsetof(GpuDeviceMetrics, utilization),
+        offsetof(GpuDeviceMetrics, memoryUtilization)};
+
+    MPI_Datatype structType, gpuDeviceMetricsType;
+    MPI_Type_create_struct(11, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside PowerMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(GpuDeviceMetrics), &gpuDeviceMetricsType);
+    MPI_Type_commit(&gpuDeviceMetricsType);
+    MPI_Type_free(&structType);
+
+    return gpuDeviceMetricsType;
+};
+
 // Create MPI data type for PowerMetrics
 MPI_Datatype createMpiPowerMetricsType(){
 
+    MPI_Datatype gpuDeviceMetricsType = createMpiGpuDeviceMetricsType();
+
     int blockLengths[] = {
-        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+        1, 1, 1, 1, RAPL_MAX_PACKAGES, RAPL_MAX_PACKAGES, RAPL_MAX_PACKAGES, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, GPU_MAX_DEVICES};
     MPI_Datatype metricTypes[] = {
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_INT,
         MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_INT,
         MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
-        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT};
+        MPI_FLOAT, MPI_FLOAT, MPI_FLOAT, MPI_FLOAT,
+        MPI_INT, gpuDeviceMetricsType};
     MPI_Aint metricOffsets[] = {
         offsetof(PowerMetrics, processorPower),
         offsetof(PowerMetrics, memoryPower),
         offsetof(PowerMetrics, systemPower),
+        offsetof(PowerMetrics, packages),
+        offsetof(PowerMetrics, packagePower),
+        offsetof(PowerMetrics, corePower),
+        offsetof(PowerMetrics, dramPower),
+        offsetof(PowerMetrics, platformPower),
+        offsetof(PowerMetrics, meterPower),
+        offsetof(PowerMetrics, meterEnergy),
+        offsetof(PowerMetrics, meterPeakPower),
+        offsetof(PowerMetrics, meterSamples),
         offsetof(PowerMetrics, gpuPower),
         offsetof(PowerMetrics, gpuTemperature),
         offsetof(PowerMetrics, gpuFanSpeed),
@@ -175,11 +567,368 @@ MPI_Datatype createMpiPowerMetricsType(){
         offsetof(PowerMetrics, gpuMemoryUsed),
         offsetof(PowerMetrics, gpuMemoryFree),
         offsetof(PowerMetrics, gpuClocksCurrentSM),
-        offsetof(PowerMetrics, gpuClocksCurrentMemory)};
+        offsetof(PowerMetrics, gpuClocksCurrentMemory),
+        offsetof(PowerMetrics, gpus),
+        offsetof(PowerMetrics, gpuMetrics)};
     
     MPI_Datatype powerMetricsType;
-    MPI_Type_create_struct(11, blockLengths, metricOffsets, metricTypes, &powerMetricsType);
+    MPI_Type_create_struct(22, blockLengths, metricOffsets, metricTypes, &powerMetricsType);
     MPI_Type_commit(&powerMetricsType);
+    MPI_Type_free(&gpuDeviceMetricsType);
 
     return powerMetricsType;
-};
\ No newline at end of file
+};
+
+// Create MPI data type for PressureResourceMetricsType
+MPI_Datatype createMpiPressureResourceMetricsType(){
+
+    int blockLengths[] = {1, 1, 1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_DOUBLE, MPI_DOUBLE, MPI_UINT64_T, MPI_UINT64_T,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct PressureResourceMetrics, someAvg10),
+        offsetof(struct PressureResourceMetrics, fullAvg10),
+        offsetof(struct PressureResourceMetrics, someTotal),
+        offsetof(struct PressureResourceMetrics, fullTotal),
+        offsetof(struct PressureResourceMetrics, someStall),
+        offsetof(struct PressureResourceMetrics, fullStall),
+        offsetof(struct PressureResourceMetrics, someStallRatio),
+        offsetof(struct PressureResourceMetrics, fullStallRatio)};
+
+    MPI_Datatype structType, pressureResourceMetricsType;
+    MPI_Type_create_struct(8, blockLengths, metricOffsets, metricTypes, &structType);
+    // Used as an array inside PressureMetrics, so the extent has to include the padding
+    MPI_Type_create_resized(structType, 0, sizeof(PressureResourceMetrics), &pressureResourceMetricsType);
+    MPI_Type_commit(&pressureResourceMetricsType);
+    MPI_Type_free(&structType);
+
+    return pressureResourceMetricsType;
+};
+
+// Create MPI data type for PressureMetricsType
+MPI_Datatype createMpiPressureMetricsType(){
+
+    MPI_Datatype pressureResourceMetricsType = createMpiPressureResourceMetricsType();
+
+    int blockLengths[] = {PRESSURE_RESOURCES, PRESSURE_RESOURCES, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        pressureResourceMetricsType, pressureResourceMetricsType, MPI_INT, MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct PressureMetrics, system),
+        offsetof(struct PressureMetrics, cgroup),
+        offsetof(struct PressureMetrics, triggerEvents),
+        offsetof(struct PressureMetrics, firstTriggerDelay)};
+
+    MPI_Datatype pressureMetricsType;
+    MPI_Type_create_struct(4, blockLengths, metricOffsets, metricTypes, &pressureMetricsType);
+    MPI_Type_commit(&pressureMetricsType);
+    MPI_Type_free(&pressureResourceMetricsType);
+
+    return pressureMetricsType;
+};
+
+// Create MPI data type for JobMetricsType
+MPI_Datatype createMpiJobMetricsType(){
+
+    int blockLengths[] = {
+        CGROUP_PATH_LENGTH, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_CHAR, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE,
+        MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE};
+    MPI_Aint metricOffsets[] = {
+        offsetof(struct JobMetrics, cgroup),
+        offsetof(struct JobMetrics, cpuUsage),
+        offsetof(struct JobMetrics, cpuUser),
+        offsetof(struct JobMetrics, cpuSystem),
+        offsetof(struct JobMetrics, cpuShare),
+        offsetof(struct JobMetrics, throttledPeriods),
+        offsetof(struct JobMetrics, throttledTime),
+        offsetof(struct JobMetrics, memoryCurrent),
+        offsetof(struct JobMetrics, memoryAnon),
+        offsetof(struct JobMetrics, memoryFile),
+        offsetof(struct JobMetrics, memoryKernel),
+        offsetof(struct JobMetrics, memoryShmem),
+        offsetof(struct JobMetrics, pageFaultRate),
+        offsetof(struct JobMetrics, majorFaultRate),
+        offsetof(struct JobMetrics, dataReadRate),
+        offsetof(struct JobMetrics, dataWrittenRate),
+        offsetof(struct JobMetrics, readRate),
+        offsetof(struct JobMetrics, writeRate),
+        offsetof(struct JobMetrics, power)};
+
+    MPI_Datatype jobMetricsType;
+    MPI_Type_create_struct(19, blockLengths, metricOffsets, metricTypes, &jobMetricsType);
+    MPI_Type_commit(&jobMetricsType);
+
+    return jobMetricsType;
+};
+
+// Create MPI data type for AllMetrics, with the sections of the given collectors only
+MPI_Datatype createMpiAllMetricsType(uint32_t groups, int cpus){
+
+    // The processor section is sized by cpus below
+    MPI_Datatype (*sectionTypes[METRIC_GROUPS])() = {
+        createMpiSystemMetricsType, nullptr, createMpiInputOutputMetricsType,
+        createMpiProcessMetricsType, createMpiMemoryMetricsType, createMpiNetworkMetricsType,
+        createMpiPowerMetricsType, createMpiPressureMetricsType, createMpiJobMetricsType};
+    MPI_Aint sectionOffsets[METRIC_GROUPS] = {
+        offsetof(struct AllMetrics, systemMetrics),
+        offsetof(struct AllMetrics, processorMetrics),
+        offsetof(struct AllMetrics, inputOutputMetrics),
+        offsetof(struct AllMetrics, processMetrics),
+        offsetof(struct AllMetrics, memoryMetrics),
+        offsetof(struct AllMetrics, networkMetrics),
+        offsetof(struct AllMetrics, powerMetrics),
+        offsetof(struct AllMetrics, pressureMetrics),
+        offsetof(struct AllMetrics, jobMetrics)};
+
+    // Which sections are there and when they were sampled goes with every record, the clock offset is
+    // only known on the root
+    int blockLengths[METRIC_GROUPS + 6] = {1, METRIC_GROUPS, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[METRIC_GROUPS + 6] = {MPI_UINT32_T, MPI_INT64_T, MPI_INT64_T, MPI_INT64_T, MPI_INT64_T, MPI_INT64_T};
+    MPI_Aint metricOffsets[METRIC_GROUPS + 6] = {
+        offsetof(struct AllMetrics, groups),
+        offsetof(struct AllMetrics, timestamps),
+        offsetof(struct AllMetrics, deadline),
+        offsetof(struct AllMetrics, jitter),
+        offsetof(struct AllMetrics, sampleRealTime),
+        offsetof(struct AllMetrics, sampleMonotonicTime)};
+    int members = 6;
+    for(int group = 0; group < METRIC_GROUPS; group++){
+        if(!(groups & METRIC_BIT(group))) continue;
+        blockLengths[members] = 1;
+        metricTypes[members] = group == METRIC_PROCESSOR ? createMpiProcessorMetricsType(cpus) : sectionTypes[group]();
+        metricOffsets[members] = sectionOffsets[group];
+        members++;
+    }
+
+    MPI_Datatype structType, allMetricsType;
+    MPI_Type_create_struct(members, blockLengths, metricOffsets, metricTypes, &structType);
+    // The gather places every node at index * extent, so the extent has to match the array of AllMetrics
+    MPI_Type_create_resized(structType, 0, sizeof(AllMetrics), &allMetricsType);
+    MPI_Type_commit(&allMetricsType);
+
+    MPI_Type_free(&structType);
+    for(int i = 6; i < members; i++) MPI_Type_free(&metricTypes[i]);
+
+    return allMetricsType;
+};
+
+// Create MPI data type for LaunchRecord
+MPI_Datatype createMpiLaunchRecordType(){
+
+    int blockLengths[] = {1, 1, 1, 1, 1};
+    MPI_Datatype metricTypes[] = {
+        MPI_INT, MPI_INT, MPI_INT, MPI_INT64_T, MPI_INT64_T};
+    MPI_Aint metricOffsets[] = {
+        offsetof(LaunchRecord, processID),
+        offsetof(LaunchRecord, exitCode),
+        offsetof(LaunchRecord, exitSignal),
+        offsetof(LaunchRecord, startTime),
+        offsetof(LaunchRecord, endTime)};
+
+    MPI_Datatype structType, launchRecordType;
+    MPI_Type_create_struct(5, blockLengths, metricOffsets, metricTypes, &structType);
+    MPI_Type_create_resized(structType, 0, sizeof(LaunchRecord), &launchRecordType);
+    MPI_Type_commit(&launchRecordType);
+    MPI_Type_free(&structType);
+
+    return launchRecordType;
+};
+
+// A PSI trigger only cuts the wait short to note when the stall happened, the tick still waits for its deadline
+uint32_t sleepWhileGathering(SamplingScheduler &scheduler, MPI_Request* requests, int count, ClockExchange &clockExchange){
+
+    int completed = 0;
+    uint32_t tick;
+    while(!(tick = scheduler.wait(0))){
+        if(!completed) MPI_Testall(count, requests, &completed, MPI_STATUSES_IGNORE);
+        int timeout = completed ? -1 : GATHER_POLL_PERIOD, probing = clockExchange.progress();
+        if(probing >= 0 && (timeout < 0 || probing < timeout)) timeout = probing;
+        waitForPressure(timeout, scheduler.descriptor());
+    }
+    return tick;
+};
+
+int countClusterCpus(){
+
+    int cpus = countCpus(), clusterCpus;
+    MPI_Allreduce(&cpus, &clusterCpus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    return clusterCpus;
+};
+
+int64_t waitForCommonEpoch(int delay){
+
+    // Rounded up to a whole ms, only to make the deadlines easier to read
+    int64_t epoch = realTime() + int64_t(delay) * 1000000;
+    epoch += 1000000 - epoch % 1000000;
+    MPI_Bcast(&epoch, 1, MPI_INT64_T, 0, MPI_COMM_WORLD);
+
+    // A node that got the epoch late returns at once, its deadlines are still the common ones
+    timespec wakeUp = {time_t(epoch / 1000000000), long(epoch % 1000000000)};
+    while(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &wakeUp, nullptr) == EINTR);
+    return epoch;
+};
+
+ClockExchange::ClockExchange(){
+    MPI_Comm_rank(MPI_COMM_WORLD, &this->rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &this->clusterSize);
+    this->opened = false;
+    this->stopped = false;
+    this->pending = 0;
+    this->answered = 0;
+    this->roundEnd = 0;
+    this->ping = CLOCK_PING;
+    this->stop = CLOCK_STOP;
+    this->received = 0;
+    this->answer[0] = this->answer[1] = 0;
+    this->pingRequest = MPI_REQUEST_NULL;
+    this->answerRequest = MPI_REQUEST_NULL;
+};
+
+ClockExchange::~ClockExchange(){
+    this->close();
+};
+
+void ClockExchange::open(){
+
+    this->close();
+    // Everything the rounds need is allocated here, nothing afterwards
+    if(!this->rank){
+        this->clocks.assign(this->clusterSize, ClockOffset());
+        this->probes.assign(this->clusterSize * CLOCK_PROBES, ClockProbe());
+        this->times.assign(this->clusterSize * 2, 0);
+        this->probeCounts.assign(this->clusterSize, 0);
+        this->sendRequests.assign(this->clusterSize, MPI_REQUEST_NULL);
+        this->receiveRequests.assign(this->clusterSize, MPI_REQUEST_NULL);
+        this->completed.assign(this->clusterSize, 0);
+    }
+    else MPI_Irecv(&this->received, 1, MPI_INT, 0, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->pingRequest);
+    this->opened = true;
+    this->stopped = false;
+};
+
+const ClockOffset& ClockExchange::clock(int node) const {
+    return this->clocks[node];
+};
+
+void ClockExchange::sendPing(int node){
+
+    this->probes[node * CLOCK_PROBES + this->probeCounts[node]].sent = realTime();
+    MPI_Isend(&this->ping, 1, MPI_INT, node, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->sendRequests[node]);
+    MPI_Irecv(&this->times[node * 2], 2, MPI_INT64_T, node, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->receiveRequests[node]);
+};
+
+// The node stamps the ping as soon as it sees it and once more right before the answer, the time
+// it took in between is not part of the round trip
+bool ClockExchange::answerPing(){
+
+    int64_t receivedTime = realTime();
+    if(this->received == CLOCK_STOP){
+        this->stopped = true;
+        return false;
+    }
+    MPI_Wait(&this->answerRequest, MPI_STATUS_IGNORE);
+    this->answer[0] = receivedTime;
+    this->answer[1] = realTime();
+    MPI_Isend(this->answer, 2, MPI_INT64_T, 0, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->answerRequest);
+    MPI_Irecv(&this->received, 1, MPI_INT, 0, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->pingRequest);
+    return true;
+};
+
+void ClockExchange::start(){
+
+    if(!this->opened) return;
+    this->roundEnd = monotonicTime() + uint64_t(CLOCK_ROUND_TIMEOUT) * 1000000;
+    if(this->rank){
+        this->answered = 0;
+        return;
+    }
+
+    // Every node gets its first ping at once, a node still busy with the previous round is left alone
+    for(int j = 1; j < this->clusterSize; j++){
+        if(this->receiveRequests[j] != MPI_REQUEST_NULL) continue;
+        this->probeCounts[j] = 0;
+        this->sendPing(j);
+        this->pending++;
+    }
+};
+
+void ClockExchange::round(){
+
+    this->start();
+    if(!this->rank){
+        while(this->pending) this->progress();
+        return;
+    }
+    while(!this->stopped && this->answered < CLOCK_PROBES){
+        MPI_Wait(&this->pingRequest, MPI_STATUS_IGNORE);
+        if(this->answerPing()) this->answered++;
+    }
+};
+
+int ClockExchange::progress(){
+
+    if(!this->opened) return -1;
+    bool inRound = monotonicTime() < this->roundEnd;
+
+    // Every ping that arrived is answered, the root waits for nothing else
+    if(this->rank){
+        int arrived = 0;
+        while(!this->stopped){
+            MPI_Test(&this->pingRequest, &arrived, MPI_STATUS_IGNORE);
+            if(!arrived || !this->answerPing()) break;
+            this->answered++;
+        }
+        return inRound && !this->stopped && this->answered < CLOCK_PROBES ? 0 : -1;
+    }
+
+    // The root stamps every answer as soon as it sees it and sends the next ping to that node right away
+    while(this->pending){
+        int count;
+        MPI_Testsome(this->clusterSize, this->receiveRequests.data(), &count, this->completed.data(), MPI_STATUSES_IGNORE);
+        if(count == MPI_UNDEFINED || !count) break;
+        int64_t returnedTime = realTime();
+        for(int i = 0; i < count; i++){
+            int node = this->completed[i];
+            MPI_Wait(&this->sendRequests[node], MPI_STATUS_IGNORE);
+            ClockProbe &probe = this->probes[node * CLOCK_PROBES + this->probeCounts[node]];
+            probe.received = this->times[node * 2];
+            probe.answered = this->times[node * 2 + 1];
+            probe.returned = returnedTime;
+            if(++this->probeCounts[node] < CLOCK_PROBES) this->sendPing(node);
+            else {
+                this->clocks[node].update(&this->probes[node * CLOCK_PROBES], CLOCK_PROBES);
+                this->pending--;
+            }
+        }
+    }
+    // After the timeout a slow node is still waited for, its late answers are dropped by ClockOffset
+    if(!this->pending) return -1;
+    return inRound ? 0 : GATHER_POLL_PERIOD;
+};
+
+void ClockExchange::close(){
+
+    if(!this->opened) return;
+    if(this->rank){
+        // Answers the pings of the last round until the root says stop
+        while(!this->stopped){
+            MPI_Wait(&this->pingRequest, MPI_STATUS_IGNORE);
+            this->answerPing();
+        }
+        MPI_Wait(&this->answerRequest, MPI_STATUS_IGNORE);
+    }
+    else {
+        while(this->progress() >= 0);
+        for(int j = 1; j < this->clusterSize; j++)
+            MPI_Isend(&this->stop, 1, MPI_INT, j, CLOCK_PROBE_TAG, MPI_COMM_WORLD, &this->sendRequests[j]);
+        MPI_Waitall(this->clusterSize, this->sendRequests.data(), MPI_STATUSES_IGNORE);
+    }
+    this->opened = false;
+};
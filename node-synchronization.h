@@ -11,13 +11,103 @@
 
 // External libraries
 #include <mpi.h>        // MPI_Datatype, MPI_Type_commit, ...
+#include <cstdint>      // uint32_t, int64_t
+#include <vector>       // vector
+// Internal headers
+#include "metrics.h"
+#include "sampling-scheduler.h"
+#include "clock-offset.h"
+
+#define GATHER_POLL_PERIOD 5    // Time between two MPI_Test calls while waiting for the next sample in ms
+#define EPOCH_DELAY 200         // Time from the choice of the epoch to the epoch itself in ms, covers the broadcast
+#define CLOCK_PROBE_TAG 1       // Tag of the ping-pong messages of the clock probes
+#define CLOCK_ROUND_TIMEOUT 20  // Longest time the root and the nodes poll without sleeping for a round in ms
+#define CLOCK_PING 1            // Ping of a probe, answered with the two stamps of the node
+#define CLOCK_STOP 0            // Last message of the root, the node stops answering
 
 // Generating MPI types
+MPI_Datatype createMpiInterruptMetricsType();
 MPI_Datatype createMpiSystemMetricsType();
-MPI_Datatype createMpiProcessorMetricsType();
+MPI_Datatype createMpiCpuMetricsType();
+MPI_Datatype createMpiProcessorMetricsType(int = TOPOLOGY_MAX_CPUS);
+MPI_Datatype createMpiBlockDeviceMetricsType();
 MPI_Datatype createMpiInputOutputMetricsType();
+MPI_Datatype createMpiProcessMetricsType();
 MPI_Datatype createMpiMemoryMetricsType();
+MPI_Datatype createMpiNetworkInterfaceMetricsType();
+MPI_Datatype createMpiInfinibandPortMetricsType();
 MPI_Datatype createMpiNetworkMetricsType();
+MPI_Datatype createMpiGpuDeviceMetricsType();
 MPI_Datatype createMpiPowerMetricsType();
+MPI_Datatype createMpiPressureResourceMetricsType();
+MPI_Datatype createMpiPressureMetricsType();
+MPI_Datatype createMpiAllMetricsType(uint32_t = METRIC_ALL_GROUPS, int = TOPOLOGY_MAX_CPUS);
+MPI_Datatype createMpiLaunchRecordType();
+
+// Most logical CPUs of any node. Every node ships that many entries of cpuMetrics, so the types of
+// all nodes match and a node with few CPUs does not send TOPOLOGY_MAX_CPUS of them.
+int countClusterCpus();
+
+// The root picks a CLOCK_REALTIME epoch in ns a moment ahead and broadcasts it, every node sleeps
+// until it and returns it. Deadlines counted from it are the same instants on every node.
+int64_t waitForCommonEpoch(int = EPOCH_DELAY);
+
+// Clock probes of the root with every other node, all of the nodes at once and without blocking.
+// A round gives every node its first ping at the same time and sends the next one as soon as the
+// answer is back, CLOCK_PROBES of them. The nodes answer every ping as soon as they see it, so no
+// node waits for the others and a slow node only delays its own probes. While a round is on, the
+// root and the nodes poll without sleeping, for at most CLOCK_ROUND_TIMEOUT, so the stamps are not
+// delayed by the sleep between ticks.
+class ClockExchange {
+public:
+    ClockExchange();
+    ClockExchange(const ClockExchange&) = delete;
+    ClockExchange& operator=(const ClockExchange&) = delete;
+    ~ClockExchange();
+
+    // Called by every node
+    void open();
+    void start();
+    // Starts a round and waits until it is over
+    void round();
+    // Tests the messages in flight, returns the time the caller may sleep before the next call in ms:
+    // 0 while a round is on, GATHER_POLL_PERIOD while the root waits for a late node, -1 otherwise
+    int progress();
+    // The root finishes its round and tells every node to stop answering
+    void close();
+
+    // Root only, clock of every node to its own
+    const ClockOffset& clock(int) const;
+
+private:
+    int rank;
+    int clusterSize;
+    bool opened;
+    bool stopped;                           // The node got CLOCK_STOP
+    uint64_t roundEnd;                      // CLOCK_MONOTONIC in ns, end of the polling without sleeping
+    int ping, stop;                         // Messages of the root, kept alive until their sends complete
+
+    // Root
+    std::vector<ClockOffset> clocks;
+    std::vector<ClockProbe> probes;         // CLOCK_PROBES of every node
+    std::vector<int64_t> times;             // Answer of every node, the stamps t2 and t3
+    std::vector<int> probeCounts;           // Probes of the round done with every node
+    std::vector<MPI_Request> sendRequests, receiveRequests;
+    std::vector<int> completed;             // Indices from MPI_Testsome
+    int pending;                            // Nodes with probes of the round left
+
+    // Other nodes
+    int received;                           // CLOCK_PING or CLOCK_STOP
+    int64_t answer[2];
+    int answered;                           // Pings answered in the current round
+    MPI_Request pingRequest, answerRequest;
+
+    void sendPing(int);
+    bool answerPing();
+};
+
+// Nonblocking collectives only progress inside MPI calls, so the requests in flight and the clock
+// probes are tested while sleeping until the next tick of the scheduler, which is returned
+uint32_t sleepWhileGathering(SamplingScheduler&, MPI_Request*, int, ClockExchange&);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+//
+//	nvml-stub.cpp - stand-in for libnvidia-ml with simulated GPUs, for nodes without an NVIDIA driver
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// g++ -std=c++2a -shared -fPIC nvml-stub.cpp -o libnvidia-ml.so.1
+// measure-performance --nvml ./libnvidia-ml.so.1 (or LD_LIBRARY_PATH=. measure-performance)
+//
+// NVML_STUB_DEVICES sets the number of GPUs, 2 by default. Every GPU draws a constant power that
+// grows with its index, so the energy counter and the power reading can be checked against each other.
+//
+
+// External libraries
+#include <cstdio>	// snprintf
+#include <cstdlib>	// getenv, atoi
+#include <ctime>	// clock_gettime
+// Internal headers
+#include "gpu-devices.h"
+
+#define STUB_ERROR_INVALID_ARGUMENT 2
+#define STUB_ERROR_UNINITIALIZED 1
+#define STUB_ERROR_NOT_SUPPORTED 3
+
+// Simulated device, the handle given to the caller points to one of these
+struct nvmlDevice_st {
+	unsigned int index;
+};
+
+static nvmlDevice_st stubDevices[GPU_MAX_DEVICES];
+static unsigned int stubCount = 0;
+static int stubInitialized = 0;
+static timespec stubStart;
+
+// Seconds since nvmlInit(), the energy counters start from 0 like after loading the driver
+static double stubElapsed(){
+
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - stubStart.tv_sec) + (now.tv_nsec - stubStart.tv_nsec) / 1e9;
+};
+
+static double stubPower(nvmlDevice_t device){
+	return 100 + 50 * device->index;							// W
+};
+
+extern "C" {
+
+nvmlReturn_t nvmlInit_v2(){
+
+	if(!stubInitialized++){
+		const char* devices = getenv("NVML_STUB_DEVICES");
+		int count = devices ? atoi(devices) : 2;
+		stubCount = count < 0 ? 0 : count > GPU_MAX_DEVICES ? GPU_MAX_DEVICES : count;
+		for(unsigned int i = 0; i < stubCount; i++) stubDevices[i].index = i;
+		clock_gettime(CLOCK_MONOTONIC, &stubStart);
+	}
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlShutdown(){
+
+	if(!stubInitialized) return STUB_ERROR_UNINITIALIZED;
+	stubInitialized--;
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetCount_v2(unsigned int* count){
+
+	if(!stubInitialized) return STUB_ERROR_UNINITIALIZED;
+	*count = stubCount;
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex_v2(unsigned int index, nvmlDevice_t* device){
+
+	if(!stubInitialized) return STUB_ERROR_UNINITIALIZED;
+	if(index >= stubCount) return STUB_ERROR_INVALID_ARGUMENT;
+	*device = &stubDevices[index];
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetName(nvmlDevice_t device, char* name, unsigned int length){
+	snprintf(name, length, "Stub GPU %u", device->index);
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device, unsigned int* power){
+	*power = stubPower(device) * 1000;							// mW
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(nvmlDevice_t device, unsigned long long* energy){
+	*energy = stubPower(device) * stubElapsed() * 1000;					// mJ
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetTemperature(nvmlDevice_t device, int sensor, unsigned int* temperature){
+
+	if(sensor != NVML_TEMPERATURE_GPU) return STUB_ERROR_INVALID_ARGUMENT;
+	*temperature = 40 + 5 * device->index;							// C
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetFanSpeed(nvmlDevice_t device, unsigned int* speed){
+
+	// Odd GPUs are passively cooled, like the SXM boards of a real node
+	if(device->index % 2) return STUB_ERROR_NOT_SUPPORTED;
+	*speed = 30;										// %
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetClockInfo(nvmlDevice_t, int type, unsigned int* clock){
+
+	if(type == NVML_CLOCK_SM) *clock = 1410;						// MHz
+	else if(type == NVML_CLOCK_MEM) *clock = 1215;						// MHz
+	else return STUB_ERROR_INVALID_ARGUMENT;
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetMemoryInfo(nvmlDevice_t device, nvmlMemory_t* memory){
+	memory->total = 40ULL << 30;								// B
+	memory->used = (1ULL << 30) * (device->index + 1);					// B
+	memory->free = memory->total - memory->used;						// B
+	return NVML_SUCCESS;
+};
+
+nvmlReturn_t nvmlDeviceGetUtilizationRates(nvmlDevice_t, nvmlUtilization_t* utilization){
+	utilization->gpu = 50;									// %
+	utilization->memory = 20;								// %
+	return NVML_SUCCESS;
+};
+
+}
@@ -0,0 +1,206 @@
+//
+//	perf-counters.cpp - file with definitions of the hardware counter collector based on perf_event_open
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <cstring>		// memset
+#include <unistd.h>		// syscall, read, close
+#include <sys/syscall.h>	// SYS_perf_event_open
+#include <linux/perf_event.h>	// perf_event_attr, PERF_*
+// Internal headers
+#include "perf-counters.h"
+#include "procfs-reader.h"
+
+// Counters that share a group are always scheduled together, so their ratios stay exact
+static const PerfCounterEvent coreGroup[] = {COUNTER_INSTRUCTIONS, COUNTER_CYCLES, COUNTER_REF_CYCLES};
+static const PerfCounterEvent l2Group[] = {COUNTER_L2_REQUESTS, COUNTER_L2_MISSES};
+static const PerfCounterEvent llcLoadGroup[] = {COUNTER_LLC_LOADS, COUNTER_LLC_LOAD_MISSES};
+static const PerfCounterEvent llcStoreGroup[] = {COUNTER_LLC_STORES, COUNTER_LLC_STORE_MISSES};
+
+static void setEventAttributes(PerfCounterEvent event, perf_event_attr &attributes){
+
+	const uint64_t llc = PERF_COUNT_HW_CACHE_LL;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch(event){
+		case COUNTER_INSTRUCTIONS:
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case COUNTER_CYCLES:
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case COUNTER_REF_CYCLES:
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = PERF_COUNT_HW_REF_CPU_CYCLES;
+			break;
+		// Raw encodings of l2_rqsts.references (umask 0xff) and l2_rqsts.miss (umask 0x3f), event 0x24
+		case COUNTER_L2_REQUESTS:
+			attributes.type = PERF_TYPE_RAW;
+			attributes.config = 0xff24;
+			break;
+		case COUNTER_L2_MISSES:
+			attributes.type = PERF_TYPE_RAW;
+			attributes.config = 0x3f24;
+			break;
+		case COUNTER_LLC_LOADS:
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.config = llc | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+			break;
+		case COUNTER_LLC_LOAD_MISSES:
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.config = llc | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case COUNTER_LLC_STORES:
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.config = llc | (PERF_COUNT_HW_CACHE_OP_WRITE << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+			break;
+		case COUNTER_LLC_STORE_MISSES:
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.config = llc | (PERF_COUNT_HW_CACHE_OP_WRITE << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		default:
+			break;
+	}
+};
+
+static int perfEventOpen(perf_event_attr &attributes, int cpu, int groupDescriptor){
+	// pid = -1 together with a CPU counts every task running on that CPU
+	return syscall(SYS_perf_event_open, &attributes, -1, cpu, groupDescriptor, PERF_FLAG_FD_CLOEXEC);
+};
+
+PerfCounters::PerfCounters(){
+	for(double &total : this->totals) total = 0;
+};
+
+PerfCounters::~PerfCounters(){
+	this->close();
+};
+
+bool PerfCounters::open(){
+
+	this->close();
+	for(double &total : this->totals) total = 0;
+
+	ProcfsFile onlineFile("/sys/devices/system/cpu/online");
+	std::vector<int> cpus = parseCpuList(onlineFile.read());
+
+	// The raw L2 encodings are only meaningful on Intel cores
+	ProcfsFile cpuinfoFile("/proc/cpuinfo");
+	std::string_view vendor;
+	bool isIntel = findLine(cpuinfoFile.read(), "vendor_id", vendor) && vendor.find("GenuineIntel") != std::string_view::npos;
+
+	for(int cpu : cpus){
+		this->openGroup(cpu, coreGroup, 3);
+		if(isIntel) this->openGroup(cpu, l2Group, 2);
+		this->openGroup(cpu, llcLoadGroup, 2);
+		this->openGroup(cpu, llcStoreGroup, 2);
+	}
+
+	// Reading right away sets the starting point for the first call to read()
+	PerfCounterReading reading;
+	this->read(reading);
+	return this->isOpen();
+};
+
+void PerfCounters::openGroup(int cpu, const PerfCounterEvent* events, int eventCount){
+
+	CounterGroup group;
+	group.cpu = cpu;
+	group.leaderDescriptor = -1;
+	group.previousEnabled = 0;
+	group.previousRunning = 0;
+
+	perf_event_attr attributes;
+	for(int i = 0; i < eventCount; i++){
+		setEventAttributes(events[i], attributes);
+		int descriptor = perfEventOpen(attributes, cpu, group.leaderDescriptor);
+
+		// Events the PMU does not support (or we are not allowed to use) are left out of the group
+		if(descriptor < 0) continue;
+		if(group.leaderDescriptor < 0) group.leaderDescriptor = descriptor;
+		group.descriptors.push_back(descriptor);
+		group.events.push_back(events[i]);
+		group.previousValues.push_back(0);
+	}
+
+	if(group.leaderDescriptor >= 0) this->groups.push_back(std::move(group));
+};
+
+void PerfCounters::close(){
+
+	for(CounterGroup &group : this->groups)
+		for(int descriptor : group.descriptors)
+			::close(descriptor);
+	this->groups.clear();
+};
+
+bool PerfCounters::isOpen() const {
+	return !this->groups.empty();
+};
+
+bool PerfCounters::readGroup(CounterGroup &group, std::vector<uint64_t> &values, uint64_t &enabled, uint64_t &running){
+
+	// Layout of PERF_FORMAT_GROUP: nr, time_enabled, time_running, value[nr]
+	size_t words = 3 + group.events.size();
+	if(this->readBuffer.size() < words) this->readBuffer.resize(words);
+
+	ssize_t bytes = ::read(group.leaderDescriptor, this->readBuffer.data(), words * sizeof(uint64_t));
+	if(bytes != ssize_t(words * sizeof(uint64_t)) || this->readBuffer[0] != group.events.size()) return false;
+
+	enabled = this->readBuffer[1];
+	running = this->readBuffer[2];
+	values.assign(this->readBuffer.begin() + 3, this->readBuffer.begin() + words);
+	return true;
+};
+
+bool PerfCounters::read(PerfCounterReading &reading){
+
+	bool available[COUNTER_EVENTS] = {};
+	std::vector<uint64_t> values;
+	uint64_t enabled, running;
+
+	for(int i = 0; i < COUNTER_EVENTS; i++) reading.rates[i] = 0;
+	reading.elapsedTime = 0;
+
+	for(CounterGroup &group : this->groups){
+		if(!this->readGroup(group, values, enabled, running)) continue;
+
+		uint64_t enabledDelta = enabled - group.previousEnabled;
+		uint64_t runningDelta = running - group.previousRunning;
+		group.previousEnabled = enabled;
+		group.previousRunning = running;
+
+		// The group was not scheduled at all in this interval - nothing to extrapolate from
+		if(!enabledDelta || !runningDelta){
+			group.previousValues = values;
+			continue;
+		}
+
+		double scale = double(enabledDelta) / double(runningDelta);
+		double seconds = enabledDelta / 1e9;
+		if(seconds > reading.elapsedTime) reading.elapsedTime = seconds;
+
+		for(size_t j = 0; j < group.events.size(); j++){
+			double count = (values[j] - group.previousValues[j]) * scale;
+			this->totals[group.events[j]] += count;
+			reading.rates[group.events[j]] += count / seconds;
+			available[group.events[j]] = true;
+		}
+		group.previousValues = values;
+	}
+
+	for(int i = 0; i < COUNTER_EVENTS; i++){
+		reading.totals[i] = available[i] ? this->totals[i] : -1;
+		if(!available[i]) reading.rates[i] = -1;
+	}
+
+	return reading.elapsedTime > 0;
+};
@@ -0,0 +1,72 @@
+//
+//	perf-counters.h - header file with the hardware counter collector based on perf_event_open
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// External libraries
+#include <vector>	// vector
+#include <string_view>	// string_view
+#include <cstdint>	// uint64_t
+
+// Every event has a fixed place in PerfCounterReading::rates
+enum PerfCounterEvent {
+	COUNTER_INSTRUCTIONS,			// Retired instructions
+	COUNTER_CYCLES,				// Unhalted core cycles
+	COUNTER_REF_CYCLES,			// Unhalted reference cycles (nominal frequency)
+	COUNTER_L2_REQUESTS,			// l2_rqsts.references (Intel only)
+	COUNTER_L2_MISSES,			// l2_rqsts.miss (Intel only)
+	COUNTER_LLC_LOADS,			// LLC-loads
+	COUNTER_LLC_LOAD_MISSES,		// LLC-load-misses
+	COUNTER_LLC_STORES,			// LLC-stores
+	COUNTER_LLC_STORE_MISSES,		// LLC-store-misses
+	COUNTER_EVENTS
+};
+
+struct PerfCounterReading {
+	double totals[COUNTER_EVENTS];		// Events since open() summed over all CPUs, -1 if not available
+	double rates[COUNTER_EVENTS];		// Events per second summed over all CPUs, -1 if not available
+	double elapsedTime;			// Longest enabled time of all groups since the previous read in seconds
+};
+
+// Grouped counters opened once on every online CPU and read with PERF_FORMAT_GROUP.
+// Counts are scaled by time_enabled/time_running when the kernel had to multiplex the groups.
+class PerfCounters {
+public:
+	PerfCounters();
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	~PerfCounters();
+
+	bool open();
+	void close();
+	bool isOpen() const;
+
+	// Rates since the previous call (or since open() for the first one)
+	bool read(PerfCounterReading&);
+
+private:
+	struct CounterGroup {
+		int cpu;
+		int leaderDescriptor;
+		std::vector<int> descriptors;
+		std::vector<PerfCounterEvent> events;	// Order of values in the group read
+		std::vector<uint64_t> previousValues;
+		uint64_t previousEnabled;
+		uint64_t previousRunning;
+	};
+
+	std::vector<CounterGroup> groups;
+	std::vector<uint64_t> readBuffer;
+	double totals[COUNTER_EVENTS];		// Scaled counts accumulated over all reads
+
+	void openGroup(int, const PerfCounterEvent*, int);
+	bool readGroup(CounterGroup&, std::vector<uint64_t>&, uint64_t&, uint64_t&);
+};
+
+#endif
@@ -0,0 +1,286 @@
+//
+//	power-meter.cpp - file with definitions of the Yokogawa WT power meter read by its own sampling thread
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <algorithm>	// lower_bound, max
+#include <chrono>	// steady_clock, milliseconds
+#include <cmath>	// isfinite, abs
+#include <cerrno>	// errno, EINPROGRESS, ENOTSOCK
+#include <cstdlib>	// atoi
+#include <fcntl.h>	// open, fcntl, O_NONBLOCK
+#include <netdb.h>	// getaddrinfo, freeaddrinfo
+#include <netinet/in.h>	// IPPROTO_TCP
+#include <netinet/tcp.h>	// TCP_NODELAY
+#include <poll.h>	// poll
+#include <sys/socket.h>	// socket, connect, send
+#include <termios.h>	// tcsetattr, cfmakeraw, cfsetspeed
+#include <unistd.h>	// read, write, close
+// Internal headers
+#include "power-meter.h"
+#include "procfs-reader.h"
+
+// Update rates the WT series accepts, in ms
+static const int meterRates[] = {100, 250, 500, 1000, 2000, 5000, 10000, 20000};
+
+bool parseMeterValue(std::string_view text, double &value){
+
+	// Values are separated by commas, the meter gives 9.91E+37 for NAN and 9.9E+37 for INF
+	skipWhitespace(text);
+	if(!text.empty() && text[0] == '+') text.remove_prefix(1);
+	std::string_view number = text.substr(0, text.find(','));
+	double parsed;
+	if(!parseDouble(number, parsed) || !std::isfinite(parsed) || std::abs(parsed) >= 9.9e37) return false;
+	value = parsed;
+	return true;
+};
+
+bool integratePower(const MeterSample* samples, int count, uint64_t from, uint64_t to, uint64_t maxGap, MeterReading &reading){
+
+	reading = {0, -1, -1, 0};
+	if(count <= 0 || to <= from) return false;
+
+	auto after = [&](uint64_t time){
+		return int(std::lower_bound(samples, samples + count, time,
+			[](const MeterSample &sample, uint64_t value){ return sample.time < value; }) - samples);
+	};
+	// Power at an instant from the samples around it, held from the nearest one past the first or the last
+	auto powerAt = [&](uint64_t time, int next, double &power){
+		if(next == 0){
+			power = samples[0].power;
+			return samples[0].time - time <= maxGap;
+		}
+		if(next == count){
+			power = samples[count - 1].power;
+			return time - samples[count - 1].time <= maxGap;
+		}
+		const MeterSample &before = samples[next - 1], &later = samples[next];
+		power = before.power + (later.power - before.power) * (time - before.time) / double(later.time - before.time);
+		return later.time - before.time <= maxGap;
+	};
+
+	int first = after(from), last = after(to);
+	double previousPower, endPower;
+	if(!powerAt(from, first, previousPower) || !powerAt(to, last, endPower)) return false;
+
+	// Trapezoids between the readings inside the interval
+	uint64_t previousTime = from;
+	reading.peakPower = std::max(previousPower, endPower);
+	for(int i = first; i < last; i++){
+		if(i > first && samples[i].time - samples[i - 1].time > maxGap) return false;
+		reading.energy += (previousPower + samples[i].power) / 2 * (samples[i].time - previousTime) / 1e9;
+		reading.peakPower = std::max(reading.peakPower, samples[i].power);
+		previousTime = samples[i].time;
+		previousPower = samples[i].power;
+	}
+	reading.energy += (previousPower + endPower) / 2 * (to - previousTime) / 1e9;
+	reading.samples = last - first;
+	reading.power = reading.energy / ((to - from) / 1e9);
+	return true;
+};
+
+PowerMeter::PowerMeter(){
+	this->descriptor = -1;
+	this->period = METER_PERIOD;
+	this->running = false;
+	this->count = 0;
+};
+
+PowerMeter::~PowerMeter(){
+	this->close();
+};
+
+bool PowerMeter::open(const std::string &address, int samplingPeriod){
+
+	this->close();
+	if(address.empty()) return false;
+	bool connected = address[0] == '/' ? this->connectSerial(address) : this->connectNetwork(address);
+	if(!connected) return false;
+
+	// Anything that does not answer *IDN? is not a meter
+	if(!this->query("*IDN?", this->identity) || this->identity.empty()){
+		this->close();
+		return false;
+	}
+
+	// Plain numbers without headers, the active power of element 1 as the only value, and the
+	// fastest update rate that is not faster than the period
+	int rate = meterRates[0];
+	for(int candidate : meterRates)
+		if(candidate <= samplingPeriod) rate = candidate;
+	this->send(":COMMUNICATE:HEADER OFF");
+	this->send(":COMMUNICATE:VERBOSE OFF");
+	this->send(":NUMERIC:FORMAT ASCII");
+	this->send(":NUMERIC:NORMAL:NUMBER 1");
+	this->send(":NUMERIC:NORMAL:ITEM1 P,1");
+	this->send(":RATE " + (rate < 1000 ? std::to_string(rate) + "MS" : std::to_string(rate / 1000) + "S"));
+
+	this->period = std::max(samplingPeriod, meterRates[0]);
+	this->samples.assign(METER_BUFFER, {0, 0});
+	this->interval.assign(METER_BUFFER, {0, 0});
+	this->count = 0;
+	this->running = true;
+	this->sampler = std::thread(&PowerMeter::run, this);
+	return true;
+};
+
+bool PowerMeter::isOpen() const {
+	return this->running;
+};
+
+void PowerMeter::close(){
+
+	this->running = false;
+	if(this->sampler.joinable()) this->sampler.join();
+	if(this->descriptor >= 0) ::close(this->descriptor);
+	this->descriptor = -1;
+	this->received.clear();
+};
+
+const std::string& PowerMeter::model() const {
+	return this->identity;
+};
+
+bool PowerMeter::connectNetwork(const std::string &address){
+
+	size_t colon = address.rfind(':');
+	std::string host = address.substr(0, colon), port = colon == std::string::npos ? METER_PORT : address.substr(colon + 1);
+	addrinfo hints = {}, *addresses;
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses)) return false;
+
+	// Connecting without blocking, so an unreachable meter costs METER_TIMEOUT and not the TCP timeout
+	for(addrinfo* candidate = addresses; candidate && this->descriptor < 0; candidate = candidate->ai_next){
+		int socketDescriptor = socket(candidate->ai_family, candidate->ai_socktype | SOCK_NONBLOCK, candidate->ai_protocol);
+		if(socketDescriptor < 0) continue;
+		int result = connect(socketDescriptor, candidate->ai_addr, candidate->ai_addrlen), error = 0;
+		if(result && errno == EINPROGRESS){
+			pollfd descriptor = {socketDescriptor, POLLOUT, 0};
+			socklen_t length = sizeof(error);
+			if(poll(&descriptor, 1, METER_TIMEOUT) == 1 && !getsockopt(socketDescriptor, SOL_SOCKET, SO_ERROR, &error, &length))
+				result = error;
+		}
+		if(result){
+			::close(socketDescriptor);
+			continue;
+		}
+		fcntl(socketDescriptor, F_SETFL, fcntl(socketDescriptor, F_GETFL) & ~O_NONBLOCK);
+		int noDelay = 1;
+		setsockopt(socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+		this->descriptor = socketDescriptor;
+	}
+	freeaddrinfo(addresses);
+	return this->descriptor >= 0;
+};
+
+bool PowerMeter::connectSerial(const std::string &address){
+
+	size_t at = address.find('@');
+	int baud = at == std::string::npos ? METER_BAUD : std::atoi(address.c_str() + at + 1);
+	speed_t speed = baud == 9600 ? B9600 : baud == 19200 ? B19200 : baud == 38400 ? B38400 : baud == 57600 ? B57600 : B0;
+	if(speed == B0) return false;
+
+	this->descriptor = ::open(address.substr(0, at).c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if(this->descriptor < 0) return false;
+
+	// 8 data bits, no parity, 1 stop bit, no flow control and no line editing
+	termios settings;
+	if(tcgetattr(this->descriptor, &settings)){
+		::close(this->descriptor);
+		this->descriptor = -1;
+		return false;
+	}
+	cfmakeraw(&settings);
+	cfsetspeed(&settings, speed);
+	settings.c_cflag |= CLOCAL | CREAD;
+	settings.c_cflag &= ~CRTSCTS;
+	tcsetattr(this->descriptor, TCSANOW, &settings);
+	tcflush(this->descriptor, TCIOFLUSH);
+	return true;
+};
+
+bool PowerMeter::send(const std::string &command){
+
+	std::string line = command + "\n";
+	size_t written = 0;
+	while(written < line.size()){
+		// A socket closed by the meter must not raise SIGPIPE, a serial device is written to directly
+		ssize_t result = ::send(this->descriptor, line.data() + written, line.size() - written, MSG_NOSIGNAL);
+		if(result < 0 && errno == ENOTSOCK) result = write(this->descriptor, line.data() + written, line.size() - written);
+		if(result <= 0) return false;
+		written += result;
+	}
+	return true;
+};
+
+bool PowerMeter::query(const std::string &command, std::string &answer){
+
+	// An answer that came after the previous query timed out would be taken for this one
+	char buffer[256];
+	pollfd descriptor = {this->descriptor, POLLIN, 0};
+	while(poll(&descriptor, 1, 0) == 1 && ::read(this->descriptor, buffer, sizeof(buffer)) > 0);
+	this->received.clear();
+	if(!this->send(command)) return false;
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(METER_TIMEOUT);
+	size_t end;
+	while((end = this->received.find('\n')) == std::string::npos){
+		int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+		if(remaining <= 0 || poll(&descriptor, 1, remaining) != 1) return false;
+		ssize_t length = ::read(this->descriptor, buffer, sizeof(buffer));
+		if(length <= 0) return false;
+		this->received.append(buffer, length);
+	}
+
+	answer = this->received.substr(0, end);
+	if(!answer.empty() && answer.back() == '\r') answer.pop_back();
+	this->received.erase(0, end + 1);
+	return true;
+};
+
+void PowerMeter::run(){
+
+	auto deadline = std::chrono::steady_clock::now();
+	std::string answer;
+	double power;
+	while(this->running){
+		uint64_t start = monotonicTime();
+		bool answered = this->query(":NUMERIC:NORMAL:VALUE?", answer);
+		uint64_t end = monotonicTime();
+		if(answered && parseMeterValue(answer, power)){
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->samples[this->count % METER_BUFFER] = {start + (end - start) / 2, power};
+			this->count++;
+		}
+
+		// Fixed deadlines, so a slow answer does not shift the following readings
+		deadline += std::chrono::milliseconds(this->period);
+		auto now = std::chrono::steady_clock::now();
+		if(deadline < now) deadline = now;
+		std::this_thread::sleep_until(deadline);
+	}
+};
+
+bool PowerMeter::read(uint64_t from, uint64_t to, MeterReading &reading){
+
+	// Readings from the newest back to the last one before the interval, copied out under the lock
+	// into the end of the scratch buffer, so they are in order without allocating anything
+	uint64_t maxGap = 3 * uint64_t(this->period) * 1000000;
+	int copied = 0;
+	if(this->interval.empty()) return integratePower(nullptr, 0, from, to, maxGap, reading);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		uint64_t oldest = this->count > METER_BUFFER ? this->count - METER_BUFFER : 0;
+		for(uint64_t i = this->count; i > oldest; i--){
+			const MeterSample &sample = this->samples[(i - 1) % METER_BUFFER];
+			this->interval[METER_BUFFER - ++copied] = sample;
+			if(sample.time < from) break;
+		}
+	}
+	return integratePower(this->interval.data() + METER_BUFFER - copied, copied, from, to, maxGap, reading);
+};
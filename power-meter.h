@@ -0,0 +1,87 @@
+//
+//	power-meter.h - header file with the Yokogawa WT power meter read by its own sampling thread
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef POWER_METER_H
+#define POWER_METER_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <thread>		// thread
+#include <atomic>		// atomic
+#include <mutex>		// mutex, lock_guard
+#include <cstdint>		// uint64_t
+
+#define METER_PORT "10001"			// Remote control port of the Ethernet interface of the WT series
+#define METER_BAUD 9600				// Default speed of the serial interface
+#define METER_PERIOD 100			// Time between two readings in ms, the fastest update rate of the WT300
+#define METER_BUFFER 8192			// Readings kept, more than 13 minutes at 100 ms
+#define METER_TIMEOUT 1000			// Time to wait for an answer in ms
+
+// Active power of the meter at one instant
+struct MeterSample {
+	uint64_t time;				// CLOCK_MONOTONIC in ns, halfway between the query and the answer
+	double power;				// W
+};
+
+// Energy used between two instants
+struct MeterReading {
+	double energy;				// J
+	double power;				// Average power in W
+	double peakPower;			// Highest reading in the interval in W
+	int samples;				// Readings inside the interval
+};
+
+// The meter is queried with ":NUMERIC:NORMAL:VALUE?" every period by a thread of its own, so
+// a sample of AllMetrics never waits for it. Readings go into a ring buffer and the energy of any
+// interval is the integral of the power between them, interpolated at both ends. The end of the
+// interval is usually newer than the last reading, its power is held for at most three periods.
+class PowerMeter {
+public:
+	PowerMeter();
+	PowerMeter(const PowerMeter&) = delete;
+	PowerMeter& operator=(const PowerMeter&) = delete;
+	~PowerMeter();
+
+	// host, host:port or a serial device, e.g. /dev/ttyUSB0 or /dev/ttyUSB0@19200, and the period in ms
+	bool open(const std::string&, int = METER_PERIOD);
+	bool isOpen() const;
+	void close();
+	// Answer of *IDN?, e.g. YOKOGAWA,WT310E,C2XXXXXXX,F1.03
+	const std::string& model() const;
+
+	// Between two CLOCK_MONOTONIC timestamps in ns, false if the readings do not cover them
+	bool read(uint64_t, uint64_t, MeterReading&);
+
+private:
+	int descriptor;
+	int period;
+	std::string identity;
+	std::string received;			// Bytes after the last complete answer
+	std::thread sampler;
+	std::atomic<bool> running;
+	std::mutex mutex;			// Guards samples and count
+	std::vector<MeterSample> samples;
+	uint64_t count;				// Readings since open(), the newest is at (count - 1) % METER_BUFFER
+	std::vector<MeterSample> interval;	// Readings of the interval of read(), only used by the caller of read()
+
+	bool connectNetwork(const std::string&);
+	bool connectSerial(const std::string&);
+	bool send(const std::string&);
+	bool query(const std::string&, std::string&);
+	void run();
+};
+
+// Integral of the power of ordered samples between two timestamps, linear between the samples.
+// Fails if a gap between two samples, or between the ends and the nearest sample, is over the given ns.
+bool integratePower(const MeterSample*, int, uint64_t, uint64_t, uint64_t, MeterReading&);
+// First value of a NUMERIC:NORMAL:VALUE? answer, e.g. "+1.2345E+02", false for NAN, INF and the error values
+bool parseMeterValue(std::string_view, double&);
+
+#endif
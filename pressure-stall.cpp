@@ -0,0 +1,152 @@
+//
+//	pressure-stall.cpp - file with definitions of the Pressure Stall Information collector reading /proc/pressure
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <fcntl.h>		// open, O_RDWR
+#include <poll.h>		// poll, POLLPRI
+#include <unistd.h>		// write, close
+// Internal headers
+#include "pressure-stall.h"
+
+static const char* pressureNames[PRESSURE_RESOURCES] = {"cpu", "memory", "io"};
+
+bool parsePressure(std::string_view text, PressureCounters &counters){
+
+	counters = {-1, -1, UINT64_MAX, UINT64_MAX};
+	bool found = false;
+	while(!text.empty()){
+		std::string_view line = nextLine(text);
+		std::string_view kind = nextToken(line);
+		bool some = kind == "some";
+		if(!some && kind != "full") continue;
+
+		// Fields are "name=value", avg60 and avg300 are left out
+		while(!line.empty()){
+			std::string_view field = nextToken(line);
+			size_t equals = field.find('=');
+			if(equals == std::string_view::npos) continue;
+			std::string_view name = field.substr(0, equals), value = field.substr(equals + 1);
+
+			if(name == "avg10") found |= parseDouble(value, some ? counters.someAvg10 : counters.fullAvg10);
+			else if(name == "total") found |= parseUnsigned(value, some ? counters.someTotal : counters.fullTotal);
+		}
+	}
+	return found;
+};
+
+PressureStall::PressureStall(){
+	for(int &descriptor : this->triggerDescriptors) descriptor = -1;
+	this->triggerEvents = 0;
+	this->firstTrigger = 0;
+};
+
+PressureStall::~PressureStall(){
+	this->closeTriggers();
+};
+
+bool PressureStall::open(const std::string &root){
+
+	this->root = root;
+	bool opened = false;
+	for(int i = 0; i < PRESSURE_RESOURCES; i++)
+		opened |= this->systemFiles[i].open(root + "/" + pressureNames[i]);
+	return opened;
+};
+
+bool PressureStall::isOpen() const {
+	return this->systemFiles[PRESSURE_CPU].isOpen() || this->systemFiles[PRESSURE_MEMORY].isOpen()
+		|| this->systemFiles[PRESSURE_IO].isOpen();
+};
+
+bool PressureStall::setProcess(int pid, const std::string &cgroupRoot){
+	return this->setCgroup(findCgroupDirectory(pid, cgroupRoot));
+};
+
+bool PressureStall::setCgroup(const std::string &directory){
+
+	bool opened = false;
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		this->cgroupFiles[i].close();
+		if(!directory.empty()) opened |= this->cgroupFiles[i].open(directory + "/" + pressureNames[i] + ".pressure");
+	}
+	return opened;
+};
+
+bool PressureStall::setTriggers(uint64_t stallTime){
+
+	this->closeTriggers();
+	std::string trigger = "some " + std::to_string(stallTime) + " " + std::to_string(PRESSURE_TRIGGER_WINDOW);
+
+	// Every trigger needs a descriptor of its own, the kernel drops it when the descriptor is closed
+	bool registered = false;
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		int descriptor = ::open((this->root + "/" + pressureNames[i]).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if(descriptor < 0) continue;
+		if(write(descriptor, trigger.c_str(), trigger.size() + 1) < 0){
+			close(descriptor);
+			continue;
+		}
+		this->triggerDescriptors[i] = descriptor;
+		registered = true;
+	}
+	return registered;
+};
+
+bool PressureStall::hasTriggers() const {
+
+	for(int descriptor : this->triggerDescriptors)
+		if(descriptor >= 0) return true;
+	return false;
+};
+
+void PressureStall::closeTriggers(){
+
+	for(int &descriptor : this->triggerDescriptors){
+		if(descriptor >= 0) close(descriptor);
+		descriptor = -1;
+	}
+};
+
+void PressureStall::read(PressureReading &reading){
+
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		if(!parsePressure(this->systemFiles[i].read(), reading.system[i])) reading.system[i] = {-1, -1, UINT64_MAX, UINT64_MAX};
+		if(!parsePressure(this->cgroupFiles[i].read(), reading.cgroup[i])) reading.cgroup[i] = {-1, -1, UINT64_MAX, UINT64_MAX};
+	}
+
+	reading.triggerEvents = this->triggerEvents;
+	reading.firstTrigger = this->firstTrigger;
+	this->triggerEvents = 0;
+	this->firstTrigger = 0;
+};
+
+bool PressureStall::waitForTrigger(int timeout, int descriptor){
+
+	pollfd descriptors[PRESSURE_RESOURCES + 1];
+	for(int i = 0; i < PRESSURE_RESOURCES; i++)
+		descriptors[i] = {this->triggerDescriptors[i], POLLPRI, 0};
+	descriptors[PRESSURE_RESOURCES] = {descriptor, POLLIN, 0};
+
+	// Negative descriptors are skipped by poll(), so it is a plain sleep without triggers
+	if(poll(descriptors, PRESSURE_RESOURCES + 1, timeout) <= 0) return false;
+
+	// A descriptor in error would wake every poll() from now on, so it is dropped
+	bool fired = false;
+	for(int i = 0; i < PRESSURE_RESOURCES; i++){
+		fired |= (descriptors[i].revents & POLLPRI) != 0;
+		if(descriptors[i].revents & (POLLERR | POLLNVAL)){
+			close(this->triggerDescriptors[i]);
+			this->triggerDescriptors[i] = -1;
+		}
+	}
+	if(!fired) return false;
+
+	if(!this->triggerEvents) this->firstTrigger = monotonicTime();
+	this->triggerEvents++;
+	return true;
+};
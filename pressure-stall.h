@@ -0,0 +1,82 @@
+//
+//	pressure-stall.h - header file with the Pressure Stall Information collector reading /proc/pressure
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef PRESSURE_STALL_H
+#define PRESSURE_STALL_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <cstdint>		// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+#include "cgroup-accounting.h"
+
+#define PRESSURE_ROOT "/proc/pressure"		// System wide cpu, memory and io files, since Linux 4.20
+#define PRESSURE_TRIGGER_WINDOW 2000000		// Window of a PSI trigger in us, a multiple of 2 s without CAP_SYS_RESOURCE
+
+enum PressureResource {
+	PRESSURE_CPU,
+	PRESSURE_MEMORY,
+	PRESSURE_IO,
+	PRESSURE_RESOURCES
+};
+
+// "some" and "full" lines of one pressure file, the totals are cumulative stall times in us
+struct PressureCounters {
+	double someAvg10;			// Share of the last 10 s with at least one task stalled in %
+	double fullAvg10;			// Share of the last 10 s with all non-idle tasks stalled in %
+	uint64_t someTotal;
+	uint64_t fullTotal;			// The cpu file has a full line only since Linux 5.13
+};
+
+struct PressureReading {
+	PressureCounters system[PRESSURE_RESOURCES];		// /proc/pressure/{cpu,memory,io}
+	PressureCounters cgroup[PRESSURE_RESOURCES];		// {cpu,memory,io}.pressure of the followed cgroup
+	int triggerEvents;					// Triggers fired since the previous read
+	uint64_t firstTrigger;					// CLOCK_MONOTONIC of the first of them in ns
+};
+
+// The system files and the ones of the cgroup of the monitored process stay open and are read once
+// per sample. Triggers are optional: a write of "some <stall us> <window us>" to a pressure file
+// makes the kernel wake a poll() on it as soon as the tasks stall that long within one window.
+class PressureStall {
+public:
+	PressureStall();
+	~PressureStall();
+
+	bool open(const std::string& = PRESSURE_ROOT);
+	bool isOpen() const;
+	// cgroup v2 directory of a process, found through /proc/[pid]/cgroup
+	bool setProcess(int, const std::string& = CGROUP_ROOT);
+	// The same for a cgroup v2 directory given directly
+	bool setCgroup(const std::string&);
+	// Stall time in us within PRESSURE_TRIGGER_WINDOW that fires a trigger on every resource
+	bool setTriggers(uint64_t);
+	bool hasTriggers() const;
+
+	void read(PressureReading&);
+	// Sleeps until a trigger fires, the timeout in ms passes or the given descriptor becomes
+	// readable, returns true if a trigger fired
+	bool waitForTrigger(int, int = -1);
+
+private:
+	std::string root;
+	ProcfsFile systemFiles[PRESSURE_RESOURCES];
+	ProcfsFile cgroupFiles[PRESSURE_RESOURCES];
+	int triggerDescriptors[PRESSURE_RESOURCES];
+	int triggerEvents;
+	uint64_t firstTrigger;
+
+	void closeTriggers();
+};
+
+// "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456" and the same for "full"
+bool parsePressure(std::string_view, PressureCounters&);
+
+#endif
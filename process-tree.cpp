@@ -0,0 +1,295 @@
+//
+//	process-tree.cpp - file with definitions of the collector following a process and all of its descendants
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <unistd.h>	// sysconf
+// Internal headers
+#include "process-tree.h"
+
+static const uint64_t ticksPerSecond = sysconf(_SC_CLK_TCK);
+static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+
+// Directory entries of /proc that are processes, "self" and the other files are skipped
+static bool parsePid(const char* name, int &pid){
+
+	std::string_view text = name;
+	uint64_t value;
+	if(!parseUnsigned(text, value) || !text.empty() || !value) return false;
+	pid = value;
+	return true;
+};
+
+bool parseProcessStat(std::string_view text, ProcessStat &stat){
+
+	size_t commandEnd = text.rfind(')');
+	if(commandEnd == std::string_view::npos) return false;
+	text.remove_prefix(commandEnd + 1);
+
+	// Fields are numbered from 1 and the view now starts at field 3 (state)
+	uint64_t value, userTime = 0, systemTime = 0;
+	nextToken(text);
+	for(int field = 4; field <= 24; field++){
+		if(!parseUnsigned(text, value)){
+			// Only tty_nr, priority and nice can be negative and none of them is needed
+			int64_t signedValue;
+			if(!parseSigned(text, signedValue)) return false;
+			continue;
+		}
+		switch(field){
+			case 4: stat.parent = value; break;
+			case 14: userTime = value; break;
+			case 15: systemTime = value; break;
+			case 20: stat.threads = value; break;
+			case 22: stat.startTime = value; break;
+			case 24: stat.residentPages = value; break;
+			default: break;
+		}
+	}
+	stat.cpuTime = userTime + systemTime;
+	return true;
+};
+
+ProcessTree::ProcessTree(){
+	this->rootProcess = -1;
+	this->procDirectory = nullptr;
+	this->readCount = 0;
+	this->ioAvailable = false;
+};
+
+ProcessTree::~ProcessTree(){
+	this->close();
+};
+
+bool ProcessTree::open(int pid){
+
+	this->close();
+	this->procDirectory = opendir("/proc");
+	if(!this->procDirectory) return false;
+
+	ProcfsFile statFile("/proc/" + std::to_string(pid) + "/stat");
+	ProcessStat stat;
+	if(!parseProcessStat(statFile.read(), stat) || !this->addProcess(pid, stat.startTime)){
+		this->close();
+		return false;
+	}
+	this->rootProcess = pid;
+
+	// Only the PIDs that appear after this point can be new children
+	this->findNewProcesses();
+	return true;
+};
+
+void ProcessTree::close(){
+
+	if(this->procDirectory) closedir(this->procDirectory);
+	this->procDirectory = nullptr;
+	this->rootProcess = -1;
+	this->processes.clear();
+	this->knownProcesses.clear();
+	this->readCount = 0;
+	this->ioAvailable = false;
+
+	TreeProcess &exited = this->exited;
+	exited.cpuTime = exited.contextSwitches = 0;
+	exited.dataRead = exited.dataWritten = exited.readCalls = exited.writeCalls = 0;
+};
+
+bool ProcessTree::isOpen() const {
+	return this->rootProcess > 0;
+};
+
+int ProcessTree::root() const {
+	return this->rootProcess;
+};
+
+bool ProcessTree::addProcess(int pid, uint64_t startTime){
+
+	TreeProcess process;
+	process.pid = pid;
+	process.startTime = startTime;
+	process.cpuTime = process.contextSwitches = 0;
+	process.dataRead = process.dataWritten = process.readCalls = process.writeCalls = 0;
+
+	std::string directory = "/proc/" + std::to_string(pid);
+	if(!process.statFile.open(directory + "/stat")) return false;
+	process.statusFile.open(directory + "/status");
+	// io of processes owned by other users can only be read by root
+	bool ioOpened = process.ioFile.open(directory + "/io");
+	if(pid == this->rootProcess || this->processes.empty()) this->ioAvailable = ioOpened;
+
+	this->processes.push_back(std::move(process));
+	return true;
+};
+
+void ProcessTree::findNewProcesses(){
+
+	struct NewProcess {
+		int pid;
+		int parent;
+		uint64_t startTime;
+	};
+	std::vector<NewProcess> newProcesses;
+	ProcfsFile statFile;
+
+	this->readCount++;
+	rewinddir(this->procDirectory);
+	struct dirent* entry;
+	int pid;
+	while((entry = readdir(this->procDirectory)) != nullptr){
+		if(!parsePid(entry->d_name, pid)) continue;
+
+		auto known = this->knownProcesses.find(pid);
+		if(known != this->knownProcesses.end()){
+			known->second = this->readCount;
+			continue;
+		}
+		this->knownProcesses[pid] = this->readCount;
+
+		// The parent of a process never changes unless it exits, so stat is read only once per PID
+		ProcessStat stat;
+		if(statFile.open("/proc/" + std::string(entry->d_name) + "/stat") && parseProcessStat(statFile.read(), stat))
+			newProcesses.push_back({pid, stat.parent, stat.startTime});
+	}
+
+	// PIDs that were not listed anymore have exited
+	for(auto known = this->knownProcesses.begin(); known != this->knownProcesses.end();){
+		if(known->second != this->readCount) known = this->knownProcesses.erase(known);
+		else known++;
+	}
+
+	// A new child can be listed before its new parent (after the PIDs wrap), so repeat until nothing joins
+	bool joined = true;
+	while(joined && !newProcesses.empty()){
+		joined = false;
+		for(size_t i = 0; i < newProcesses.size();){
+			bool isChild = false;
+			for(const TreeProcess &process : this->processes)
+				if(process.pid == newProcesses[i].parent){
+					isChild = true;
+					break;
+				}
+
+			if(isChild && this->addProcess(newProcesses[i].pid, newProcesses[i].startTime)){
+				newProcesses[i] = newProcesses.back();
+				newProcesses.pop_back();
+				joined = true;
+			}
+			else i++;
+		}
+	}
+};
+
+bool ProcessTree::readProcess(TreeProcess &process, int &threads, uint64_t &residentMemory){
+
+	ProcessStat stat;
+	if(!parseProcessStat(process.statFile.read(), stat) || stat.startTime != process.startTime) return false;
+
+	process.cpuTime = stat.cpuTime * 1000 / ticksPerSecond;
+	threads += stat.threads;
+	residentMemory += stat.residentPages * pageSize;
+
+	std::string_view text = process.statusFile.read();
+	uint64_t voluntary, involuntary;
+	if(findKeyValue(text, "voluntary_ctxt_switches", voluntary) && findKeyValue(text, "nonvoluntary_ctxt_switches", involuntary))
+		process.contextSwitches = voluntary + involuntary;
+
+	text = process.ioFile.read();
+	findKeyValue(text, "rchar", process.dataRead);
+	findKeyValue(text, "wchar", process.dataWritten);
+	findKeyValue(text, "syscr", process.readCalls);
+	findKeyValue(text, "syscw", process.writeCalls);
+	return true;
+};
+
+bool ProcessTree::read(ProcessTreeReading &reading){
+
+	reading.rootProcess = this->rootProcess;
+	reading.processes = reading.threads = 0;
+	reading.residentMemory = 0;
+	if(!this->isOpen()){
+		reading.processes = reading.threads = -1;
+		reading.residentMemory = reading.cpuTime = reading.contextSwitches = PROCESS_MISSING;
+		reading.dataRead = reading.dataWritten = reading.readCalls = reading.writeCalls = PROCESS_MISSING;
+		return false;
+	}
+
+	this->findNewProcesses();
+
+	TreeProcess &exited = this->exited;
+	reading.cpuTime = exited.cpuTime;
+	reading.contextSwitches = exited.contextSwitches;
+	reading.dataRead = exited.dataRead;
+	reading.dataWritten = exited.dataWritten;
+	reading.readCalls = exited.readCalls;
+	reading.writeCalls = exited.writeCalls;
+
+	for(size_t i = 0; i < this->processes.size();){
+		TreeProcess &process = this->processes[i];
+
+		// Whatever the process did until the previous read stays in the counters of the tree
+		if(!this->readProcess(process, reading.threads, reading.residentMemory)){
+			exited.cpuTime += process.cpuTime;
+			exited.contextSwitches += process.contextSwitches;
+			exited.dataRead += process.dataRead;
+			exited.dataWritten += process.dataWritten;
+			exited.readCalls += process.readCalls;
+			exited.writeCalls += process.writeCalls;
+			reading.cpuTime += process.cpuTime;
+			reading.contextSwitches += process.contextSwitches;
+			reading.dataRead += process.dataRead;
+			reading.dataWritten += process.dataWritten;
+			reading.readCalls += process.readCalls;
+			reading.writeCalls += process.writeCalls;
+
+			if(i + 1 < this->processes.size()) process = std::move(this->processes.back());
+			this->processes.pop_back();
+			continue;
+		}
+
+		reading.processes++;
+		reading.cpuTime += process.cpuTime;
+		reading.contextSwitches += process.contextSwitches;
+		reading.dataRead += process.dataRead;
+		reading.dataWritten += process.dataWritten;
+		reading.readCalls += process.readCalls;
+		reading.writeCalls += process.writeCalls;
+		i++;
+	}
+
+	if(!this->ioAvailable) reading.dataRead = reading.dataWritten = reading.readCalls = reading.writeCalls = PROCESS_MISSING;
+	return reading.processes > 0;
+};
+
+int findProcessByName(std::string_view name){
+
+	DIR* directory = opendir("/proc");
+	if(!directory) return -1;
+
+	ProcfsFile file;
+	int found = -1, pid;
+	uint64_t foundStart = UINT64_MAX;
+	struct dirent* entry;
+	while((entry = readdir(directory)) != nullptr){
+		if(!parsePid(entry->d_name, pid)) continue;
+
+		std::string directoryName = "/proc/" + std::string(entry->d_name);
+		if(!file.open(directoryName + "/comm")) continue;
+		std::string_view comm = file.read();
+		while(!comm.empty() && comm.back() == '\n') comm.remove_suffix(1);
+		if(comm != name) continue;
+
+		ProcessStat stat;
+		if(!file.open(directoryName + "/stat") || !parseProcessStat(file.read(), stat)) continue;
+		if(stat.startTime < foundStart){
+			found = pid;
+			foundStart = stat.startTime;
+		}
+	}
+	closedir(directory);
+	return found;
+};
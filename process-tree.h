@@ -0,0 +1,97 @@
+//
+//	process-tree.h - header file with the collector following a process and all of its descendants
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+// External libraries
+#include <string>		// string
+#include <string_view>		// string_view
+#include <vector>		// vector
+#include <unordered_map>	// unordered_map
+#include <cstdint>		// uint64_t
+#include <dirent.h>		// DIR
+// Internal headers
+#include "procfs-reader.h"
+
+#define PROCESS_MISSING UINT64_MAX		// Counter that could not be read for the tree
+
+struct ProcessTreeReading {
+	int rootProcess;			// PID the tree started from, -1 if it is not monitored
+	int processes;				// Processes of the tree alive at the read
+	int threads;				// Threads of these processes
+	uint64_t residentMemory;		// Resident set of the live processes in bytes
+	// Counters below include the processes of the tree that already exited, so they never go back
+	uint64_t cpuTime;			// User and system time in ms
+	uint64_t contextSwitches;		// Voluntary and involuntary context switches
+	uint64_t dataRead;			// rchar in bytes
+	uint64_t dataWritten;			// wchar in bytes
+	uint64_t readCalls;			// syscr
+	uint64_t writeCalls;			// syscw
+};
+
+// Processes join the tree when their parent is already in it and stay in it until they exit,
+// so daemons reparented to init are still counted. /proc is kept open and rewound on every read,
+// and only PIDs that were not there before have their stat file read to learn the parent.
+class ProcessTree {
+public:
+	ProcessTree();
+	ProcessTree(const ProcessTree&) = delete;
+	ProcessTree& operator=(const ProcessTree&) = delete;
+	~ProcessTree();
+
+	bool open(int);
+	void close();
+	bool isOpen() const;
+	int root() const;
+
+	bool read(ProcessTreeReading&);
+
+private:
+	struct TreeProcess {
+		int pid;
+		uint64_t startTime;		// Field 22 of stat, tells a reused PID apart
+		ProcfsFile statFile;
+		ProcfsFile statusFile;
+		ProcfsFile ioFile;
+		uint64_t cpuTime;		// Last values read from the files above
+		uint64_t contextSwitches;
+		uint64_t dataRead;
+		uint64_t dataWritten;
+		uint64_t readCalls;
+		uint64_t writeCalls;
+	};
+
+	int rootProcess;
+	DIR* procDirectory;
+	std::vector<TreeProcess> processes;
+	std::unordered_map<int, uint64_t> knownProcesses;	// Every PID seen in /proc, with the read that saw it last
+	uint64_t readCount;
+	bool ioAvailable;			// /proc/[pid]/io of the root could be read
+	TreeProcess exited;			// Sum of the last values of processes that exited
+
+	bool addProcess(int, uint64_t);
+	void findNewProcesses();
+	bool readProcess(TreeProcess&, int&, uint64_t&);
+};
+
+struct ProcessStat {
+	int parent;				// ppid, field 4
+	int threads;				// num_threads, field 20
+	uint64_t cpuTime;			// utime + stime in USER_HZ, fields 14 and 15
+	uint64_t startTime;			// starttime in USER_HZ since boot, field 22
+	uint64_t residentPages;			// rss in pages, field 24
+};
+
+// Fields of /proc/[pid]/stat are counted after the command name, which can contain spaces and parentheses
+bool parseProcessStat(std::string_view, ProcessStat&);
+
+// Oldest process with the given name in /proc/[pid]/comm, -1 if there is none
+int findProcessByName(std::string_view);
+
+#endif
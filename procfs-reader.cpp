@@ -0,0 +1,264 @@
+//
+//	procfs-reader.cpp - file with definitions of the in-process reader for procfs and sysfs files
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <charconv>	// from_chars
+#include <fcntl.h>	// open, O_RDONLY, O_CLOEXEC
+#include <unistd.h>	// pread, close
+#include <cerrno>	// errno, EINTR
+#include <ctime>	// clock_gettime, CLOCK_MONOTONIC, timespec_get
+#ifdef __SSE2__
+#include <emmintrin.h>	// _mm_loadu_si128, _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+// Internal headers
+#include "procfs-reader.h"
+
+ProcfsFile::ProcfsFile(){
+	this->fileDescriptor = -1;
+};
+
+ProcfsFile::ProcfsFile(const std::string &path){
+	this->fileDescriptor = -1;
+	this->open(path);
+};
+
+ProcfsFile::ProcfsFile(ProcfsFile &&other) noexcept {
+	this->fileDescriptor = other.fileDescriptor;
+	this->filePath = std::move(other.filePath);
+	this->buffer = std::move(other.buffer);
+	other.fileDescriptor = -1;
+};
+
+ProcfsFile& ProcfsFile::operator=(ProcfsFile &&other) noexcept {
+	if(this != &other){
+		this->close();
+		this->fileDescriptor = other.fileDescriptor;
+		this->filePath = std::move(other.filePath);
+		this->buffer = std::move(other.buffer);
+		other.fileDescriptor = -1;
+	}
+	return *this;
+};
+
+ProcfsFile::~ProcfsFile(){
+	this->close();
+};
+
+bool ProcfsFile::open(const std::string &path){
+
+	this->close();
+	this->filePath = path;
+	this->fileDescriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(this->fileDescriptor < 0) return false;
+
+	if(this->buffer.size() < PROCFS_BUFFER_SIZE)
+		this->buffer.resize(PROCFS_BUFFER_SIZE);
+	return true;
+};
+
+void ProcfsFile::close(){
+	if(this->fileDescriptor >= 0) ::close(this->fileDescriptor);
+	this->fileDescriptor = -1;
+};
+
+bool ProcfsFile::isOpen() const {
+	return this->fileDescriptor >= 0;
+};
+
+const std::string& ProcfsFile::path() const {
+	return this->filePath;
+};
+
+std::string_view ProcfsFile::read(){
+
+	if(this->fileDescriptor < 0) return std::string_view();
+
+	// procfs regenerates the content on every read from offset 0, so there is no need to reopen
+	// or lseek. If the buffer was filled completely the file might be longer - grow and read again.
+	while(true){
+		size_t total = 0;
+		ssize_t count = 0;
+		while(total < this->buffer.size()){
+			count = pread(this->fileDescriptor, this->buffer.data() + total, this->buffer.size() - total, total);
+			if(count < 0 && errno == EINTR) continue;
+			if(count <= 0) break;
+			total += count;
+		}
+		if(count < 0) return std::string_view();
+		if(total < this->buffer.size()) return std::string_view(this->buffer.data(), total);
+		this->buffer.resize(this->buffer.size() * 2);
+	}
+};
+
+#ifdef __SSE2__
+#define TOKEN_BLOCK 16				// Bytes compared at once by whitespaceMask()
+
+// Bit i is set when byte i of the block is a space, a tab or a newline
+static inline unsigned whitespaceMask(const char* block){
+
+	__m128i bytes = _mm_loadu_si128((const __m128i*)block);
+	__m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+		_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+	return _mm_movemask_epi8(spaces);
+};
+#endif
+
+// First byte that is not whitespace, or the end
+static inline const char* whitespaceEnd(const char* position, const char* end){
+
+#ifdef __SSE2__
+	// Counters in /proc/interrupts and /proc/softirqs are right-aligned in 10 character columns, so
+	// most of the bytes on a node with many CPUs are padding. Only whole blocks are loaded.
+	for(; end - position >= TOKEN_BLOCK; position += TOKEN_BLOCK){
+		unsigned mask = whitespaceMask(position);
+		if(mask != 0xFFFF) return position + __builtin_ctz(~mask);
+	}
+#endif
+	while(position < end && (*position == ' ' || *position == '\t' || *position == '\n'))
+		position++;
+	return position;
+};
+
+void skipWhitespace(std::string_view &text){
+	text.remove_prefix(whitespaceEnd(text.data(), text.data() + text.size()) - text.data());
+};
+
+std::string_view nextToken(std::string_view &text){
+
+	skipWhitespace(text);
+	size_t position = 0;
+	while(position < text.size() && text[position] != ' ' && text[position] != '\t' && text[position] != '\n')
+		position++;
+
+	std::string_view token = text.substr(0, position);
+	text.remove_prefix(position);
+	return token;
+};
+
+std::string_view nextLine(std::string_view &text){
+
+	size_t position = text.find('\n');
+	std::string_view line = text.substr(0, position);
+	text.remove_prefix(position == std::string_view::npos ? text.size() : position + 1);
+	return line;
+};
+
+bool parseUnsigned(std::string_view &text, uint64_t &value){
+
+	skipWhitespace(text);
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if(error != std::errc()) return false;
+	text.remove_prefix(end - text.data());
+	return true;
+};
+
+int parseUnsignedList(std::string_view &text, uint64_t* values, int count){
+
+	for(int i = 0; i < count; i++)
+		if(!parseUnsigned(text, values[i])) return i;
+	return count;
+};
+
+bool parseSigned(std::string_view &text, int64_t &value){
+
+	skipWhitespace(text);
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if(error != std::errc()) return false;
+	text.remove_prefix(end - text.data());
+	return true;
+};
+
+bool parseDouble(std::string_view &text, double &value){
+
+	skipWhitespace(text);
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if(error != std::errc()) return false;
+	text.remove_prefix(end - text.data());
+	return true;
+};
+
+bool findLine(std::string_view text, std::string_view prefix, std::string_view &line){
+
+	while(!text.empty()){
+		std::string_view current = nextLine(text);
+		if(current.substr(0, prefix.size()) == prefix){
+			line = current.substr(prefix.size());
+			return true;
+		}
+	}
+	return false;
+};
+
+bool findKeyValue(std::string_view text, std::string_view key, uint64_t &value){
+
+	while(!text.empty()){
+		std::string_view line = nextLine(text);
+		if(line.size() <= key.size() || line.substr(0, key.size()) != key) continue;
+
+		// The key has to end right here, "Active" must not match "Active(anon)"
+		char separator = line[key.size()];
+		if(separator != ':' && separator != ' ') continue;
+
+		line.remove_prefix(key.size() + 1);
+		return parseUnsigned(line, value);
+	}
+	return false;
+};
+
+int findKeyValues(std::string_view text, const KeyValueField* fields, int count){
+
+	int found = 0;
+	while(!text.empty() && found < count){
+		std::string_view line = nextLine(text);
+		size_t end = line.find_first_of(": ");
+		if(end == std::string_view::npos) continue;
+
+		// /proc/vmstat has more than a hundred lines, a short list of keys is cheaper than a map
+		std::string_view key = line.substr(0, end);
+		for(int i = 0; i < count; i++)
+			if(fields[i].key == key){
+				line.remove_prefix(end + 1);
+				if(parseUnsigned(line, *fields[i].value)) found++;
+				break;
+			}
+	}
+	return found;
+};
+
+std::vector<int> parseCpuList(std::string_view text){
+
+	std::vector<int> cpus;
+	uint64_t first, last;
+
+	while(parseUnsigned(text, first)){
+		last = first;
+		if(!text.empty() && text[0] == '-'){
+			text.remove_prefix(1);
+			if(!parseUnsigned(text, last)) break;
+		}
+		for(uint64_t cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+
+		if(text.empty() || text[0] != ',') break;
+		text.remove_prefix(1);
+	}
+	return cpus;
+};
+
+uint64_t monotonicTime(){
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+};
+
+int64_t realTime(){
+
+	std::timespec now;
+	std::timespec_get(&now, TIME_UTC);
+	return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+};
@@ -0,0 +1,79 @@
+//
+//	procfs-reader.h - header file with the in-process reader for procfs and sysfs files
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef PROCFS_READER_H
+#define PROCFS_READER_H
+
+// External libraries
+#include <string>	// string
+#include <string_view>	// string_view
+#include <vector>	// vector
+#include <cstdint>	// uint64_t, int64_t
+
+#define PROCFS_BUFFER_SIZE 4096			// Initial size of the buffer used for a single file
+
+// File from /proc or /sys that stays open for the whole run and is re-read with pread()
+class ProcfsFile {
+public:
+	ProcfsFile();
+	explicit ProcfsFile(const std::string&);
+	ProcfsFile(ProcfsFile&&) noexcept;
+	ProcfsFile& operator=(ProcfsFile&&) noexcept;
+	ProcfsFile(const ProcfsFile&) = delete;
+	ProcfsFile& operator=(const ProcfsFile&) = delete;
+	~ProcfsFile();
+
+	bool open(const std::string&);
+	void close();
+	bool isOpen() const;
+	const std::string& path() const;
+
+	// Content of the file from offset 0, valid until the next call to read()
+	std::string_view read();
+
+private:
+	int fileDescriptor;
+	std::string filePath;
+	std::vector<char> buffer;		// Grows only when the file does not fit
+};
+
+// Parsing helpers - they consume the parsed part of the view and never allocate. Whitespace is
+// skipped 16 bytes at a time with SSE2 where it is available
+void skipWhitespace(std::string_view&);
+std::string_view nextToken(std::string_view&);
+std::string_view nextLine(std::string_view&);
+bool parseUnsigned(std::string_view&, uint64_t&);
+// Up to a given number of counters separated by whitespace, returns how many of them were parsed
+int parseUnsignedList(std::string_view&, uint64_t*, int);
+bool parseSigned(std::string_view&, int64_t&);
+bool parseDouble(std::string_view&, double&);
+
+// Line that starts with a given prefix (e.g. "ctxt " in /proc/stat), without the prefix
+bool findLine(std::string_view, std::string_view, std::string_view&);
+// Value of "Key: value" files like /proc/meminfo and "key value" files like /proc/vmstat
+bool findKeyValue(std::string_view, std::string_view, uint64_t&);
+
+// Key of a "Key: value" or "key value" file and where to store its value
+struct KeyValueField {
+	std::string_view key;
+	uint64_t* value;
+};
+
+// Every listed key in one pass over the file, returns the number of keys found. Values of keys
+// that are missing are left untouched, so they keep COUNTER_MISSING
+int findKeyValues(std::string_view, const KeyValueField*, int);
+
+// List of CPUs in the "0-3,8,10-11" format used by /sys/devices/system/cpu/online
+std::vector<int> parseCpuList(std::string_view);
+
+// CLOCK_MONOTONIC in nanoseconds, the clock every rate is calculated with
+uint64_t monotonicTime();
+// CLOCK_REALTIME in nanoseconds, the time written to the results
+int64_t realTime();
+
+#endif
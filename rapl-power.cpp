@@ -0,0 +1,140 @@
+//
+//	rapl-power.cpp - file with definitions of the RAPL energy collector reading the powercap sysfs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <map>		// map
+#include <dirent.h>	// opendir, readdir, closedir
+// Internal headers
+#include "rapl-power.h"
+
+// Reads a whole sysfs attribute that is only needed once
+static std::string_view readAttribute(ProcfsFile &file, const std::string &path){
+
+	if(!file.open(path)) return std::string_view();
+	std::string_view text = file.read();
+	while(!text.empty() && (text.back() == '\n' || text.back() == ' ')) text.remove_suffix(1);
+	return text;
+};
+
+RaplPower::RaplPower(){
+	this->packages = 0;
+	this->previousTime = 0;
+};
+
+bool RaplPower::open(const std::string &root){
+
+	this->domains.clear();
+	this->packages = 0;
+
+	// Directories are called intel-rapl:P for top level domains and intel-rapl:P:S for their subdomains.
+	// P is not the socket number (psys usually takes intel-rapl:1), the name file of the top level says it.
+	const std::string prefix = "intel-rapl:";
+	std::vector<std::string> topLevel, subdomains;
+	DIR* directory = opendir(root.c_str());
+	if(!directory) return false;
+
+	struct dirent* entry;
+	while((entry = readdir(directory)) != nullptr){
+		std::string name = entry->d_name;
+		if(name.compare(0, prefix.size(), prefix)) continue;
+		if(name.find(':', prefix.size()) == std::string::npos) topLevel.push_back(name);
+		else subdomains.push_back(name);
+	}
+	closedir(directory);
+
+	std::map<std::string, int> packageOfDomain;
+	ProcfsFile attributeFile;
+	uint64_t value;
+
+	auto addDomain = [&](const std::string &name, RaplDomainType type, int package){
+		RaplDomain domain;
+		domain.type = type;
+		domain.package = package;
+		std::string_view maxEnergy = readAttribute(attributeFile, root + "/" + name + "/max_energy_range_uj");
+		domain.maxEnergy = parseUnsigned(maxEnergy, value) ? value : 0;
+		domain.previousEnergy = 0;
+
+		// energy_uj is readable only by root on kernels patched for CVE-2020-8694
+		if(!domain.energyFile.open(root + "/" + name + "/energy_uj")) return;
+		if(!this->readEnergy(domain, domain.previousEnergy)) return;
+		this->domains.push_back(std::move(domain));
+	};
+
+	for(const std::string &name : topLevel){
+		std::string_view domainName = readAttribute(attributeFile, root + "/" + name + "/name");
+		if(domainName == "psys"){
+			addDomain(name, RAPL_PSYS, 0);
+			continue;
+		}
+		if(domainName.substr(0, 8) != "package-") continue;
+
+		domainName.remove_prefix(8);
+		if(!parseUnsigned(domainName, value) || value >= RAPL_MAX_PACKAGES) continue;
+		packageOfDomain[name] = value;
+		if(int(value) + 1 > this->packages) this->packages = value + 1;
+		addDomain(name, RAPL_PACKAGE, value);
+	}
+
+	for(const std::string &name : subdomains){
+		auto parent = packageOfDomain.find(name.substr(0, name.rfind(':')));
+		if(parent == packageOfDomain.end()) continue;
+
+		std::string_view domainName = readAttribute(attributeFile, root + "/" + name + "/name");
+		if(domainName == "core") addDomain(name, RAPL_CORE, parent->second);
+		else if(domainName == "uncore") addDomain(name, RAPL_UNCORE, parent->second);
+		else if(domainName == "dram") addDomain(name, RAPL_DRAM, parent->second);
+	}
+
+	this->previousTime = monotonicTime();
+	return this->isOpen();
+};
+
+bool RaplPower::isOpen() const {
+	return !this->domains.empty();
+};
+
+bool RaplPower::readEnergy(RaplDomain &domain, uint64_t &energy){
+
+	std::string_view text = domain.energyFile.read();
+	return parseUnsigned(text, energy);
+};
+
+bool RaplPower::read(RaplReading &reading){
+	return this->read(reading, monotonicTime());
+};
+
+bool RaplPower::read(RaplReading &reading, uint64_t now){
+
+	reading.packages = this->packages;
+	for(int type = 0; type < RAPL_DOMAIN_TYPES; type++)
+		for(int package = 0; package < RAPL_MAX_PACKAGES; package++)
+			reading.power[type][package] = -1;
+
+	reading.elapsedTime = 0;
+	if(now <= this->previousTime || !this->isOpen()) return false;
+	reading.elapsedTime = (now - this->previousTime) / 1e9;
+	this->previousTime = now;
+
+	uint64_t energy;
+	for(RaplDomain &domain : this->domains){
+		if(!this->readEnergy(domain, energy)) continue;
+		uint64_t delta = raplEnergyDelta(domain.previousEnergy, energy, domain.maxEnergy);
+		domain.previousEnergy = energy;
+		reading.power[domain.type][domain.package] = delta / 1e6 / reading.elapsedTime;	// W
+	}
+	return true;
+};
+
+uint64_t raplEnergyDelta(uint64_t previous, uint64_t current, uint64_t maxEnergy){
+
+	if(current >= previous) return current - previous;
+	// Without a known range the wrap cannot be told apart from a reset
+	if(maxEnergy < previous) return 0;
+	// The counter went over max_energy_range_uj and started again from 0
+	return maxEnergy - previous + current;
+};
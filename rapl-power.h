@@ -0,0 +1,68 @@
+//
+//	rapl-power.h - header file with the RAPL energy collector reading the powercap sysfs
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef RAPL_POWER_H
+#define RAPL_POWER_H
+
+// External libraries
+#include <string>	// string
+#include <vector>	// vector
+#include <cstdint>	// uint64_t
+// Internal headers
+#include "procfs-reader.h"
+
+#define RAPL_ROOT "/sys/class/powercap"		// Default place of the intel-rapl:* domains
+#define RAPL_MAX_PACKAGES 4			// Packages (sockets) reported separately
+
+enum RaplDomainType {
+	RAPL_PACKAGE,				// package-N, the whole socket
+	RAPL_CORE,				// core, the cores of the socket
+	RAPL_UNCORE,				// uncore, e.g. the integrated GPU
+	RAPL_DRAM,				// dram, memory attached to the socket
+	RAPL_PSYS,				// psys, the whole platform
+	RAPL_DOMAIN_TYPES
+};
+
+struct RaplReading {
+	int packages;						// Number of packages found
+	double power[RAPL_DOMAIN_TYPES][RAPL_MAX_PACKAGES];	// Average power in W, -1 if the domain does not exist
+	double elapsedTime;					// Interval since the previous read in seconds
+};
+
+// Every domain keeps its energy_uj open and remembers the last value, so the power is
+// always the energy used between two consecutive reads divided by the monotonic time between them
+class RaplPower {
+public:
+	RaplPower();
+
+	bool open(const std::string& = RAPL_ROOT);
+	bool isOpen() const;
+
+	bool read(RaplReading&);
+	bool read(RaplReading&, uint64_t);	// With an explicit CLOCK_MONOTONIC timestamp in ns
+
+private:
+	struct RaplDomain {
+		RaplDomainType type;
+		int package;
+		ProcfsFile energyFile;
+		uint64_t maxEnergy;		// max_energy_range_uj, the counter wraps to 0 after it
+		uint64_t previousEnergy;
+	};
+
+	std::vector<RaplDomain> domains;
+	int packages;
+	uint64_t previousTime;
+
+	bool readEnergy(RaplDomain&, uint64_t&);
+};
+
+// Energy used between two readings of a counter that wraps after maxEnergy
+uint64_t raplEnergyDelta(uint64_t, uint64_t, uint64_t);
+
+#endif
@@ -0,0 +1,75 @@
+//
+// 	read-results.cpp - summary of a columnar binary results file
+//
+// 	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// Lists the schema of the file, or the minimum, mean and maximum of one metric on every node.
+//
+// g++ -std=c++20 -O2 read-results.cpp results-reader.cpp -o read-results
+// read-results results/1610-2245_metrics.columns processorMetrics.timeUser
+//
+
+// External libraries
+#include <iostream>		// cout, cerr
+#include <chrono>		// steady_clock
+#include <algorithm>		// min, max
+// Internal headers
+#include "results-reader.h"
+
+int main(int argc, char **argv){
+
+	if(argc < 2){
+		std::cerr << "Usage: " << argv[0] << " FILE [FIELD]\n";
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	ResultsReader reader;
+	if(!reader.open(argv[1])){
+		std::cerr << "\n\t[ERROR] " << argv[1] << " is not a columnar results file.\n";
+		return 1;
+	}
+	std::chrono::duration<double, std::milli> openTime = std::chrono::steady_clock::now() - start;
+
+	std::cout << argv[1] << ": " << reader.nodes() << " nodes, " << reader.fields() << " fields, "
+		<< reader.samples() << " samples in " << reader.chunks() << " chunks, opened in " << openTime.count() << " ms\n";
+
+	if(argc < 3){
+		for(int i = 0; i < reader.fields(); i++) std::cout << "\t" << reader.field(i).name << "\n";
+		return 0;
+	}
+
+	int field = reader.findField(argv[2]);
+	if(field < 0){
+		std::cerr << "\n\t[ERROR] There is no field " << argv[2] << ".\n";
+		return 1;
+	}
+
+	// Names change only when the devices of a node do, the last one is shown
+	if(reader.field(field).type == COLUMN_TEXT){
+		for(int node = 0; node < reader.nodes(); node++)
+			std::cout << "Node " << node << ": \"" << (reader.samples() ? reader.text(reader.samples() - 1, field, node) : "") << "\"\n";
+		return 0;
+	}
+
+	// Negative values mark metrics that could not be read and are left out, except in the signed columns
+	bool isSigned = reader.field(field).type == COLUMN_INT64;
+	for(int node = 0; node < reader.nodes(); node++){
+		double minimum = 0, maximum = 0, sum = 0;
+		uint64_t count = 0;
+		for(uint64_t sample = 0; sample < reader.samples(); sample++){
+			double value = reader.value(sample, field, node);
+			if(value < 0 && !isSigned) continue;
+			minimum = count ? std::min(minimum, value) : value;
+			maximum = count ? std::max(maximum, value) : value;
+			sum += value;
+			count++;
+		}
+		std::cout << "Node " << node << ": ";
+		if(count) std::cout << "min " << minimum << ", mean " << sum / count << ", max " << maximum << " (" << count << " samples)\n";
+		else std::cout << "no values\n";
+	}
+	return 0;
+};
@@ -0,0 +1,68 @@
+//
+//	results-format.h - layout of the columnar binary results file shared by the writer and the reader
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// File layout (host byte order, every part aligned to 8 bytes):
+//
+//	ResultsFileHeader
+//	ResultsField[fields]			schema, one entry per column of AllMetrics
+//	chunk[0], chunk[1], ...			every chunk has the same size (chunkSize)
+//
+// One chunk holds up to chunkSamples consecutive samples of the whole cluster:
+//
+//	ResultsChunkHeader
+//	int64_t timestamps[chunkSamples]	deadline of every sample, CLOCK_REALTIME in ns
+//	field 0 of node 0, field 0 of node 1, ..., field 1 of node 0, ...
+//
+// so the values of one metric of one node within a chunk are a contiguous array.
+//
+
+#ifndef RESULTS_FORMAT_H
+#define RESULTS_FORMAT_H
+
+// External libraries
+#include <cstdint>	// uint32_t, uint64_t
+
+#define RESULTS_MAGIC "MPCOLS1"			// First 8 bytes of the file (with the terminating zero)
+#define RESULTS_VERSION 1			// Changed whenever the layout changes
+#define RESULTS_CHUNK_SAMPLES 64		// Samples kept in memory before a chunk is written
+#define RESULTS_FIELD_NAME 56			// Room for "section.field[index]" with the terminating zero
+
+enum ResultsColumnType : uint32_t {
+	COLUMN_INT32,				// int
+	COLUMN_UINT64,				// uint64_t counter, COUNTER_MISSING if it could not be read
+	COLUMN_FLOAT,				// float
+	COLUMN_DOUBLE,				// double
+	COLUMN_TEXT,				// char[width], zero padded, e.g. the name of a device
+	COLUMN_INT64				// int64_t, e.g. a timestamp or a clock offset in ns
+};
+
+struct ResultsFileHeader {
+	char magic[8];				// RESULTS_MAGIC
+	uint32_t version;			// RESULTS_VERSION
+	uint32_t nodes;				// Number of nodes in every sample
+	uint32_t fields;			// Number of ResultsField entries after the header
+	uint32_t chunkSamples;			// Capacity of one chunk in samples
+	uint64_t chunkSize;			// Size of one chunk in bytes
+};
+
+struct ResultsField {
+	char name[RESULTS_FIELD_NAME];		// e.g. "processorMetrics.timeUser" or "powerMetrics.packagePower[1]"
+	uint32_t type;				// ResultsColumnType
+	uint32_t width;				// Size of one value in bytes
+};
+
+struct ResultsChunkHeader {
+	uint32_t samples;			// Samples stored in this chunk, only the last one can be partial
+	uint32_t reserved;
+};
+
+// Size of the values of one field of one node in a chunk, padded so the next column stays aligned
+inline uint64_t resultsColumnSize(uint32_t width, uint32_t chunkSamples){
+	return (uint64_t(width) * chunkSamples + 7) / 8 * 8;
+};
+
+#endif
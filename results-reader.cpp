@@ -0,0 +1,177 @@
+//
+//	results-reader.cpp - file with definitions of the reader of the columnar binary results
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <cstring>	// memcmp, strnlen
+#include <fcntl.h>	// open
+#include <unistd.h>	// close
+#include <sys/mman.h>	// mmap, munmap, madvise
+#include <sys/stat.h>	// fstat
+// Internal headers
+#include "results-reader.h"
+
+ResultsReader::ResultsReader(){
+	this->mapping = nullptr;
+	this->mappingSize = 0;
+	this->header = nullptr;
+	this->schema = nullptr;
+	this->dataOffset = 0;
+	this->chunkCount = 0;
+	this->sampleCount = 0;
+};
+
+ResultsReader::~ResultsReader(){
+	this->close();
+};
+
+bool ResultsReader::open(const std::string &fileName){
+
+	this->close();
+
+	int descriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if(descriptor < 0) return false;
+
+	struct stat status;
+	if(fstat(descriptor, &status) || size_t(status.st_size) < sizeof(ResultsFileHeader)){
+		::close(descriptor);
+		return false;
+	}
+
+	void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+	if(address == MAP_FAILED) return false;
+	this->mapping = (const char*)address;
+	this->mappingSize = status.st_size;
+
+	// Analysis usually walks whole columns, let the kernel read ahead
+	madvise(address, this->mappingSize, MADV_SEQUENTIAL);
+
+	const ResultsFileHeader* fileHeader = (const ResultsFileHeader*)this->mapping;
+	uint64_t schemaSize = uint64_t(fileHeader->fields) * sizeof(ResultsField);
+	if(memcmp(fileHeader->magic, RESULTS_MAGIC, sizeof(fileHeader->magic)) || fileHeader->version != RESULTS_VERSION
+		|| !fileHeader->nodes || !fileHeader->chunkSamples || !fileHeader->chunkSize
+		|| this->mappingSize < sizeof(ResultsFileHeader) + schemaSize){
+		this->close();
+		return false;
+	}
+	this->header = fileHeader;
+	this->schema = (const ResultsField*)(this->mapping + sizeof(ResultsFileHeader));
+	this->dataOffset = sizeof(ResultsFileHeader) + schemaSize;
+
+	// Same layout as ColumnarWriter::open()
+	uint64_t offset = sizeof(ResultsChunkHeader) + resultsColumnSize(sizeof(int64_t), fileHeader->chunkSamples);
+	for(uint32_t i = 0; i < fileHeader->fields; i++){
+		uint64_t columnSize = resultsColumnSize(this->schema[i].width, fileHeader->chunkSamples);
+		this->columnOffsets.push_back(offset);
+		this->columnSizes.push_back(columnSize);
+		offset += columnSize * fileHeader->nodes;
+	}
+	if(offset != fileHeader->chunkSize){
+		this->close();
+		return false;
+	}
+
+	// A chunk cut short by a killed run is left out
+	this->chunkCount = (this->mappingSize - this->dataOffset) / fileHeader->chunkSize;
+	if(this->chunkCount)
+		this->sampleCount = (this->chunkCount - 1) * fileHeader->chunkSamples + this->chunkSamples(this->chunkCount - 1);
+	return true;
+};
+
+void ResultsReader::close(){
+
+	if(this->mapping) munmap((void*)this->mapping, this->mappingSize);
+	this->mapping = nullptr;
+	this->mappingSize = 0;
+	this->header = nullptr;
+	this->schema = nullptr;
+	this->chunkCount = 0;
+	this->sampleCount = 0;
+	this->columnOffsets.clear();
+	this->columnSizes.clear();
+};
+
+int ResultsReader::nodes() const {
+	return this->header ? this->header->nodes : 0;
+};
+
+int ResultsReader::fields() const {
+	return this->header ? this->header->fields : 0;
+};
+
+uint64_t ResultsReader::chunks() const {
+	return this->chunkCount;
+};
+
+uint64_t ResultsReader::samples() const {
+	return this->sampleCount;
+};
+
+const ResultsField& ResultsReader::field(int index) const {
+	return this->schema[index];
+};
+
+int ResultsReader::findField(std::string_view name) const {
+
+	for(int i = 0; i < this->fields(); i++){
+		const char* fieldName = this->schema[i].name;
+		if(std::string_view(fieldName, strnlen(fieldName, RESULTS_FIELD_NAME)) == name) return i;
+	}
+	return -1;
+};
+
+const char* ResultsReader::chunkData(uint64_t chunk) const {
+	return this->mapping + this->dataOffset + chunk * this->header->chunkSize;
+};
+
+uint32_t ResultsReader::chunkSamples(uint64_t chunk) const {
+
+	const ResultsChunkHeader* chunkHeader = (const ResultsChunkHeader*)this->chunkData(chunk);
+	if(chunkHeader->samples > this->header->chunkSamples) return this->header->chunkSamples;
+	return chunkHeader->samples;
+};
+
+std::span<const int64_t> ResultsReader::timestamps(uint64_t chunk) const {
+
+	const char* data = this->chunkData(chunk) + sizeof(ResultsChunkHeader);
+	return std::span<const int64_t>((const int64_t*)data, this->chunkSamples(chunk));
+};
+
+double ResultsReader::value(uint64_t sample, int field, int node) const {
+
+	if(sample >= this->sampleCount || field < 0 || field >= this->fields() || node < 0 || node >= this->nodes()) return -1;
+	uint64_t chunk = sample / this->header->chunkSamples, index = sample % this->header->chunkSamples;
+
+	switch(this->schema[field].type){
+		case COLUMN_INT32:
+			return this->column<int32_t>(chunk, field, node)[index];
+		case COLUMN_UINT64: {
+			uint64_t counter = this->column<uint64_t>(chunk, field, node)[index];
+			return counter == UINT64_MAX ? -1 : double(counter);	// COUNTER_MISSING
+		}
+		case COLUMN_FLOAT:
+			return this->column<float>(chunk, field, node)[index];
+		case COLUMN_DOUBLE:
+			return this->column<double>(chunk, field, node)[index];
+		case COLUMN_INT64:
+			return double(this->column<int64_t>(chunk, field, node)[index]);
+		default:
+			return -1;
+	}
+};
+
+std::string_view ResultsReader::text(uint64_t sample, int field, int node) const {
+
+	if(sample >= this->sampleCount || field < 0 || field >= this->fields() || node < 0 || node >= this->nodes()) return std::string_view();
+	if(this->schema[field].type != COLUMN_TEXT) return std::string_view();
+	uint64_t chunk = sample / this->header->chunkSamples, index = sample % this->header->chunkSamples;
+
+	uint32_t width = this->schema[field].width;
+	const char* data = this->chunkData(chunk) + this->columnOffsets[field] + node * this->columnSizes[field] + index * width;
+	return std::string_view(data, strnlen(data, width));
+};
@@ -0,0 +1,73 @@
+//
+//	results-reader.h - header file with the reader of the columnar binary results
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+// Does not depend on MPI or metrics.h - the schema is read from the file, so analysis
+// tools can be built with a plain g++ -std=c++20 results-reader.cpp.
+//
+
+#ifndef RESULTS_READER_H
+#define RESULTS_READER_H
+
+// External libraries
+#include <string>	// string
+#include <string_view>	// string_view
+#include <span>		// span
+#include <vector>	// vector
+#include <cstdint>	// uint64_t, int64_t
+// Internal headers
+#include "results-format.h"
+
+// The file is mapped, not read, so opening costs the same no matter how long the run was.
+// Every span points straight into the mapping and is valid until close().
+class ResultsReader {
+public:
+	ResultsReader();
+	ResultsReader(const ResultsReader&) = delete;
+	ResultsReader& operator=(const ResultsReader&) = delete;
+	~ResultsReader();
+
+	bool open(const std::string&);
+	void close();
+
+	int nodes() const;
+	int fields() const;
+	uint64_t chunks() const;
+	uint64_t samples() const;		// Samples in all complete chunks
+
+	const ResultsField& field(int) const;
+	int findField(std::string_view) const;	// -1 if there is no such field
+
+	uint32_t chunkSamples(uint64_t) const;
+	std::span<const int64_t> timestamps(uint64_t) const;
+
+	// Values of one field of one node in one chunk, the type has to match ResultsField::type
+	template<typename T>
+	std::span<const T> column(uint64_t chunk, int field, int node) const {
+		const char* data = this->chunkData(chunk) + this->columnOffsets[field] + node * this->columnSizes[field];
+		return std::span<const T>((const T*)data, this->chunkSamples(chunk));
+	};
+
+	// Single value converted to double, COUNTER_MISSING counters, text and missing chunks give -1
+	double value(uint64_t sample, int field, int node) const;
+	// Single value of a COLUMN_TEXT field without the padding, empty for the other types
+	std::string_view text(uint64_t sample, int field, int node) const;
+
+private:
+	const char* mapping;
+	size_t mappingSize;
+	const ResultsFileHeader* header;
+	const ResultsField* schema;
+	uint64_t dataOffset;			// Place of the first chunk in the file
+	uint64_t chunkCount;
+	uint64_t sampleCount;
+	std::vector<uint64_t> columnOffsets;	// Place of the column of node 0 of every field in a chunk
+	std::vector<uint64_t> columnSizes;	// Size of the column of one node of every field
+
+	const char* chunkData(uint64_t) const;
+};
+
+#endif
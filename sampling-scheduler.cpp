@@ -0,0 +1,130 @@
+//
+//	sampling-scheduler.cpp - file with definitions of the scheduler giving every collector its own sampling period
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <cerrno>		// errno, EINTR
+#include <sys/epoll.h>		// epoll_create1, epoll_ctl, epoll_wait
+#include <sys/timerfd.h>	// timerfd_create, timerfd_settime, TFD_TIMER_ABSTIME
+#include <unistd.h>		// read, close
+// Internal headers
+#include "sampling-scheduler.h"
+
+SamplingScheduler::SamplingScheduler(){
+	this->epollDescriptor = -1;
+	this->timers = 0;
+	for(int &descriptor : this->timerDescriptors) descriptor = -1;
+	this->lastTick = 0;
+	this->fired = 0;
+};
+
+SamplingScheduler::~SamplingScheduler(){
+	this->close();
+};
+
+bool SamplingScheduler::open(const int* periods, int count, int64_t epoch){
+
+	this->close();
+	if(count <= 0 || count > SCHEDULER_MAX_TIMERS) return false;
+	this->epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+	if(this->epollDescriptor < 0) return false;
+
+	// Every deadline counts from the same epoch, so timers with multiple periods fire at the same instant
+	for(int i = 0; i < count; i++){
+		int descriptor = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u32 = i;
+		if(descriptor < 0 || periods[i] <= 0 || epoll_ctl(this->epollDescriptor, EPOLL_CTL_ADD, descriptor, &event)){
+			if(descriptor >= 0) ::close(descriptor);
+			this->close();
+			return false;
+		}
+		this->timerDescriptors[i] = descriptor;
+		this->timers = i + 1;
+		this->periods[i] = int64_t(periods[i]) * 1000000;
+		this->deadlines[i] = epoch + this->periods[i];
+		if(!this->arm(i)){
+			this->close();
+			return false;
+		}
+	}
+	return true;
+};
+
+void SamplingScheduler::close(){
+
+	for(int i = 0; i < this->timers; i++){
+		::close(this->timerDescriptors[i]);
+		this->timerDescriptors[i] = -1;
+	}
+	if(this->epollDescriptor >= 0) ::close(this->epollDescriptor);
+	this->epollDescriptor = -1;
+	this->timers = 0;
+	this->fired = 0;
+};
+
+int SamplingScheduler::descriptor() const {
+	return this->epollDescriptor;
+};
+
+int64_t SamplingScheduler::tickTime() const {
+	return this->lastTick;
+};
+
+// Every timer whose deadline is the earliest one
+uint32_t SamplingScheduler::nextTick() const {
+
+	uint32_t tick = 0;
+	int64_t earliest = INT64_MAX;
+	for(int i = 0; i < this->timers; i++){
+		if(this->deadlines[i] > earliest) continue;
+		if(this->deadlines[i] < earliest) tick = 0;
+		earliest = this->deadlines[i];
+		tick |= 1u << i;
+	}
+	return tick;
+};
+
+bool SamplingScheduler::arm(int timer){
+
+	itimerspec deadline = {};
+	deadline.it_value.tv_sec = this->deadlines[timer] / 1000000000;
+	deadline.it_value.tv_nsec = this->deadlines[timer] % 1000000000;
+	return !timerfd_settime(this->timerDescriptors[timer], TFD_TIMER_ABSTIME, &deadline, nullptr);
+};
+
+uint32_t SamplingScheduler::wait(int timeout){
+
+	uint32_t tick = this->nextTick();
+	if(!tick) return 0;
+
+	// Timers of later ticks that fired meanwhile stay in fired until their tick comes
+	epoll_event events[SCHEDULER_MAX_TIMERS];
+	while((this->fired & tick) != tick){
+		int ready = epoll_wait(this->epollDescriptor, events, SCHEDULER_MAX_TIMERS, timeout);
+		if(ready < 0 && errno != EINTR) return 0;
+		for(int i = 0; i < ready; i++){
+			uint64_t expirations;
+			int timer = events[i].data.u32;
+			if(::read(this->timerDescriptors[timer], &expirations, sizeof(expirations)) == sizeof(expirations))
+				this->fired |= 1u << timer;
+		}
+		if(timeout >= 0 && (this->fired & tick) != tick) return 0;
+	}
+
+	// The next deadline is counted from the previous one and not from now, a deadline already
+	// passed makes the timer fire right away
+	this->lastTick = this->deadlines[__builtin_ctz(tick)];
+	for(int i = 0; i < this->timers; i++){
+		if(!(tick & (1u << i))) continue;
+		this->deadlines[i] += this->periods[i];
+		this->arm(i);
+	}
+	this->fired &= ~tick;
+	return tick;
+};
@@ -0,0 +1,56 @@
+//
+//	sampling-scheduler.h - header file with the scheduler giving every collector its own sampling period
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef SAMPLING_SCHEDULER_H
+#define SAMPLING_SCHEDULER_H
+
+// External libraries
+#include <cstdint>	// uint32_t, int64_t
+
+#define SCHEDULER_MAX_TIMERS 32			// Timers of one scheduler, one bit of a tick each
+
+// Every timer is a timerfd armed with an absolute CLOCK_REALTIME deadline, epoch + k * period, so a
+// late wake-up never shifts the following deadlines. All of them sit in one epoll set. A tick is the
+// set of timers that share the earliest deadline; it depends only on the periods, so every node goes
+// through the same ticks in the same order whatever its load. With the same epoch on every node and
+// clocks kept in step by NTP or PTP, the nodes wake up for a tick at the same instant.
+class SamplingScheduler {
+public:
+	SamplingScheduler();
+	SamplingScheduler(const SamplingScheduler&) = delete;
+	SamplingScheduler& operator=(const SamplingScheduler&) = delete;
+	~SamplingScheduler();
+
+	// Periods in ms and the CLOCK_REALTIME epoch in ns, every timer fires for the first time one
+	// period after the epoch
+	bool open(const int*, int, int64_t);
+	void close();
+	// epoll descriptor, readable when a timer fired
+	int descriptor() const;
+
+	// Waits up to the given time in ms (0 returns at once, -1 until the tick) and returns the timers
+	// of the next tick once all of them fired, 0 otherwise. A timer late by a whole period still
+	// fires for every deadline it missed, one tick after the other.
+	uint32_t wait(int);
+	// Deadline of the last tick returned by wait(), CLOCK_REALTIME in ns
+	int64_t tickTime() const;
+
+private:
+	int epollDescriptor;
+	int timers;
+	int timerDescriptors[SCHEDULER_MAX_TIMERS];
+	int64_t periods[SCHEDULER_MAX_TIMERS];			// ns
+	int64_t deadlines[SCHEDULER_MAX_TIMERS];		// Next deadline of every timer, CLOCK_REALTIME in ns
+	int64_t lastTick;
+	uint32_t fired;						// Timers that fired for their current deadline
+
+	uint32_t nextTick() const;
+	bool arm(int);
+};
+
+#endif
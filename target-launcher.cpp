@@ -0,0 +1,103 @@
+//
+//	target-launcher.cpp - file with definitions of the launcher of the monitored application
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+// External libraries
+#include <csignal>		// SIGTERM, SIGKILL
+#include <spawn.h>		// posix_spawnp
+#include <poll.h>		// poll
+#include <unistd.h>		// syscall, close
+#include <sys/wait.h>		// waitid
+#include <sys/syscall.h>	// SYS_pidfd_open, SYS_pidfd_send_signal
+// Internal headers
+#include "target-launcher.h"
+#include "procfs-reader.h"
+
+#ifndef P_PIDFD
+#define P_PIDFD 3				// idtype_t of waitid() for a pidfd, missing in glibc before 2.36
+#endif
+
+extern char** environ;
+
+TargetLauncher::TargetLauncher(){
+	this->launchRecord = {-1, -1, 0, -1, -1};
+	this->pidDescriptor = -1;
+	this->running = false;
+};
+
+TargetLauncher::~TargetLauncher(){
+	this->stop();
+};
+
+bool TargetLauncher::start(char** command){
+
+	pid_t pid;
+	this->launchRecord.startTime = realTime();
+	if(posix_spawnp(&pid, command[0], nullptr, nullptr, command, environ)) return false;
+	this->launchRecord.processID = pid;
+
+	// The child is not reaped before waitid(), so the pidfd cannot point to a reused PID
+#ifdef SYS_pidfd_open
+	this->pidDescriptor = syscall(SYS_pidfd_open, pid, 0);
+#endif
+
+	this->running = true;
+	this->waiter = std::thread(&TargetLauncher::wait, this);
+	return true;
+};
+
+bool TargetLauncher::isRunning() const {
+	return this->running;
+};
+
+int TargetLauncher::processID() const {
+	return this->launchRecord.processID;
+};
+
+const LaunchRecord& TargetLauncher::record() const {
+	return this->launchRecord;
+};
+
+void TargetLauncher::wait(){
+
+	siginfo_t info = {};
+	int result = -1;
+	if(this->pidDescriptor >= 0) result = waitid((idtype_t)P_PIDFD, this->pidDescriptor, &info, WEXITED);
+	if(result) result = waitid(P_PID, this->launchRecord.processID, &info, WEXITED);
+	this->launchRecord.endTime = realTime();
+
+	if(!result && info.si_code == CLD_EXITED) this->launchRecord.exitCode = info.si_status;
+	else if(!result) this->launchRecord.exitSignal = info.si_status;
+	this->running = false;
+};
+
+bool TargetLauncher::sendSignal(int signal){
+
+#ifdef SYS_pidfd_send_signal
+	if(this->pidDescriptor >= 0) return !syscall(SYS_pidfd_send_signal, this->pidDescriptor, signal, nullptr, 0);
+#endif
+	return !kill(this->launchRecord.processID, signal);
+};
+
+void TargetLauncher::stop(){
+
+	if(!this->waiter.joinable()) return;
+
+	if(this->running){
+		this->sendSignal(SIGTERM);
+		// A pidfd becomes readable when the process ends, without it there is nothing to wait on
+		if(this->pidDescriptor >= 0){
+			pollfd descriptor = {this->pidDescriptor, POLLIN, 0};
+			poll(&descriptor, 1, LAUNCH_KILL_TIMEOUT);
+		}
+		if(this->running) this->sendSignal(SIGKILL);
+	}
+	this->waiter.join();
+
+	if(this->pidDescriptor >= 0) close(this->pidDescriptor);
+	this->pidDescriptor = -1;
+};
@@ -0,0 +1,56 @@
+//
+//	target-launcher.h - header file with the launcher of the monitored application
+//
+//	2022-2023	Damian Strojek @damianStrojek
+// 			Piotr Garbowski @dideek
+// 			Jakub Wasniewski @wisnia01
+//
+
+#ifndef TARGET_LAUNCHER_H
+#define TARGET_LAUNCHER_H
+
+// External libraries
+#include <thread>	// thread
+#include <atomic>	// atomic
+#include <cstdint>	// int64_t
+
+#define LAUNCH_KILL_TIMEOUT 5000		// Time between SIGTERM and SIGKILL when the monitoring is stopped in ms
+
+struct LaunchRecord {
+	int processID;				// PID of the launched command on the node, -1 if it was not started
+	int exitCode;				// Exit status, -1 if the command was killed by a signal or did not end
+	int exitSignal;				// Signal that ended the command, 0 if it exited on its own
+	int64_t startTime;			// CLOCK_REALTIME when the command was started in ns
+	int64_t endTime;			// CLOCK_REALTIME when the command ended in ns, -1 if it did not end
+};
+
+// The command is started with posix_spawnp() and a thread blocks in waitid() on its pidfd,
+// so the exit is noticed (and timed) by the kernel instead of by polling the PID every sample.
+class TargetLauncher {
+public:
+	TargetLauncher();
+	TargetLauncher(const TargetLauncher&) = delete;
+	TargetLauncher& operator=(const TargetLauncher&) = delete;
+	~TargetLauncher();
+
+	bool start(char**);
+	bool isRunning() const;
+	int processID() const;
+
+	// SIGTERM and SIGKILL after LAUNCH_KILL_TIMEOUT if the command is still running, then wait for it
+	void stop();
+
+	// Complete once the command ended (isRunning() is false)
+	const LaunchRecord& record() const;
+
+private:
+	LaunchRecord launchRecord;
+	int pidDescriptor;			// pidfd of the command, -1 on kernels older than 5.3
+	std::thread waiter;
+	std::atomic<bool> running;
+
+	void wait();
+	bool sendSignal(int);
+};
+
+#endif